@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+
+/*
+ * Bump-арена: вузли AST і рядки однієї програми лежать підряд у великих
+ * блоках і звільняються разом із власником (Program). Для типів з
+ * нетривіальним деструктором make<T> запам'ятовує виклик ~T(), деструктори
+ * виконуються у зворотному порядку перед звільненням блоків.
+ */
+class Arena {
+    struct Block { Block* next; };
+    struct Dtor { void (*fn)(void*); void* obj; Dtor* next; };
+
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    Block* head = nullptr;
+    char* cur = nullptr;
+    char* end = nullptr;
+    Dtor* dtors = nullptr;
+    size_t used = 0, reserved = 0;
+
+    void grow(size_t need){
+        size_t sz = sizeof(Block) + need;
+        if(sz < BLOCK_SIZE) sz = BLOCK_SIZE;
+        auto* b = static_cast<Block*>(std::malloc(sz));
+        if(!b) throw std::bad_alloc();
+        b->next = head; head = b;
+        cur = reinterpret_cast<char*>(b + 1);
+        end = reinterpret_cast<char*>(b) + sz;
+        reserved += sz;
+    }
+
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena(){
+        for(Dtor* d = dtors; d; d = d->next) d->fn(d->obj);
+        while(head){ Block* n = head->next; std::free(head); head = n; }
+    }
+
+    void* alloc(size_t n, size_t align){
+        uintptr_t p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~(uintptr_t)(align - 1);
+        if(!cur || p + n > reinterpret_cast<uintptr_t>(end)){
+            grow(n + align);
+            p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~(uintptr_t)(align - 1);
+        }
+        cur = reinterpret_cast<char*>(p + n);
+        used += n;
+        return reinterpret_cast<void*>(p);
+    }
+
+    template<typename T, typename... A> T* make(A&&... a){
+        T* obj = new(alloc(sizeof(T), alignof(T))) T(std::forward<A>(a)...);
+        if constexpr(!std::is_trivially_destructible_v<T>){
+            auto* d = new(alloc(sizeof(Dtor), alignof(Dtor))) Dtor{ [](void* p){ static_cast<T*>(p)->~T(); }, obj, dtors };
+            dtors = d;
+        }
+        return obj;
+    }
+
+    /* Копія рядка в арені з завершальним '\0' */
+    std::string_view copy(std::string_view s){
+        char* p = static_cast<char*>(alloc(s.size() + 1, 1));
+        std::memcpy(p, s.data(), s.size()); p[s.size()] = '\0';
+        return std::string_view(p, s.size());
+    }
+
+    size_t bytes_used() const { return used; }
+    size_t bytes_reserved() const { return reserved; }
+};
+
+/*
+ * Інтернер імен: кожен різний ідентифікатор зберігається в арені один раз,
+ * повернутий string_view стабільний, поки жива арена, і завершується '\0'.
+ * Однакові імена мають однаковий data(), тож їх можна порівнювати вказівником.
+ */
+class Interner {
+    Arena& arena;
+    std::unordered_set<std::string_view> set;
+public:
+    explicit Interner(Arena& a): arena(a){}
+    std::string_view intern(std::string_view s){
+        auto it = set.find(s);
+        if(it != set.end()) return *it;
+        auto v = arena.copy(s);
+        set.insert(v);
+        return v;
+    }
+    size_t size() const { return set.size(); }
+};
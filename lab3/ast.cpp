@@ -1,2 +1,62 @@
 #include "ast.hpp"
-// Наразі нічого додаткового.
+
+const char* op_str(Op op){
+    switch(op){
+        case Op::Add: return "+";  case Op::Sub: return "-";  case Op::Mul: return "*";
+        case Op::Div: return "/";  case Op::Mod: return "%";
+        case Op::Lt:  return "<";  case Op::Gt:  return ">";  case Op::Le:  return "<=";
+        case Op::Ge:  return ">="; case Op::Eq:  return "=="; case Op::Ne:  return "!=";
+        case Op::And: return "&&"; case Op::Or:  return "||";
+        case Op::Not: return "!";  case Op::Neg: return "-";
+    }
+    return "?";
+}
+
+const char* kind_name(NodeKind k){
+    static const char* names[] = {
+        "Type", "Vec", "Program", "Param", "ParamList", "Block", "Decl", "ExprStmt",
+        "Assign", "BinOp", "UnaryOp", "Number", "Bool", "VarRef", "Call",
+        "Return", "If", "While", "For", "ArgList", "FuncDef", "Cast",
+        "Index", "IndexAssign", "Len"
+    };
+    return names[(int)k];
+}
+
+const char* type_name(Type t){
+    switch(t){
+        case Type::Int: return "int"; case Type::Double: return "double"; case Type::Bool: return "bool";
+        case Type::None: break;
+    }
+    return "?";
+}
+
+Type type_of(Name n){
+    if(n == "int") return Type::Int;
+    if(n == "double") return Type::Double;
+    if(n == "bool") return Type::Bool;
+    return Type::None;
+}
+
+bool par_loop(ForNode* fr, ParLoop& l){
+    if(!fr->init || !fr->cond || !fr->step) return false;
+    if(fr->init->kind != NodeKind::Assign || fr->cond->kind != NodeKind::BinOp || fr->step->kind != NodeKind::Assign) return false;
+    auto* init = as<AssignNode>(fr->init);
+    auto is_iv = [&](ExprNode* e){ return e->kind == NodeKind::VarRef && as<VarRefNode>(e)->slot == init->slot && as<VarRefNode>(e)->depth == init->depth; };
+    auto* c = as<BinOpNode>(fr->cond);
+    if((c->op != Op::Lt && c->op != Op::Le) || !is_iv(c->a)) return false;
+    auto* st = as<AssignNode>(fr->step);
+    if(st->slot != init->slot || st->depth != init->depth || st->rhs->kind != NodeKind::BinOp) return false;
+    auto* inc = as<BinOpNode>(st->rhs);
+    if(inc->op != Op::Add) return false;
+    ExprNode* k = is_iv(inc->a)? inc->b : is_iv(inc->b)? inc->a : nullptr;
+    if(!k || k->kind != NodeKind::Number || k->type != Type::Int || as<NumberNode>(k)->i <= 0) return false;
+    l.init = init; l.hi = c->b; l.inclusive = c->op == Op::Le; l.step = as<NumberNode>(k)->i;
+    return true;
+}
+
+uint64_t par_trip_count(const ParLoop& l, int64_t lo, int64_t hi){
+    if(hi < lo || (hi == lo && !l.inclusive)) return 0;
+    uint64_t span = uint64_t(hi) - uint64_t(lo); // без переповнення навіть для крайніх значень
+    uint64_t step = uint64_t(l.step);
+    return l.inclusive? span / step + 1 : (span - 1) / step + 1;
+}
@@ -1,69 +1,185 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
+#include "arena.hpp"
+
+/* Тег вузла: проходи диспетчеризують switch-ем по kind замість ланцюжка dynamic_cast. */
+enum class NodeKind : uint8_t {
+    Type, Vec, Program, Param, ParamList, Block, Decl, ExprStmt,
+    Assign, BinOp, UnaryOp, Number, Bool, VarRef, Call,
+    Return, If, While, For, ArgList, FuncDef, Cast,
+    Index, IndexAssign, Len
+};
 
-struct AST { virtual ~AST() = default; };
+enum class Op : uint8_t {
+    Add, Sub, Mul, Div, Mod,
+    Lt, Gt, Le, Ge, Eq, Ne,
+    And, Or,
+    Not, Neg
+};
+
+/* Статичний тип виразу; None — ще не перевірено typecheck_program */
+enum class Type : uint8_t { None, Int, Double, Bool };
+
+/* Написання оператора в C (Neg -> "-") */
+const char* op_str(Op op);
+/* Ім'я виду вузла для діагностики ("Block", "Call", ...) */
+const char* kind_name(NodeKind k);
+/* "int" / "double" / "bool" */
+const char* type_name(Type t);
+
+struct AST {
+    NodeKind kind;
+    uint32_t line=0; // рядок початку в джерелі (інструкції та функції), 0 — невідомо
+    explicit AST(NodeKind k): kind(k){}
+    virtual ~AST() = default;
+};
 
 template<typename T> inline T* as(AST* n){ return static_cast<T*>(n); }
 
-struct Node : AST {};
-struct ExprNode : Node {};
+/* Імена та типи — інтерновані рядки з арени програми */
+using Name = std::string_view;
+
+/* Тип із назви в оголошенні ("int" -> Type::Int); невідома назва -> None */
+Type type_of(Name n);
+
+struct Node : AST { using AST::AST; };
+/* rank > 0 — вираз є посиланням на масив (лише VarRef на масив; typecheck_program), type — тип елемента */
+struct ExprNode : Node { Type type = Type::None; uint8_t rank = 0; using Node::Node; };
 
 struct TypeNode : Node {
-    std::string name; explicit TypeNode(std::string n): name(std::move(n)){}
+    Name name; explicit TypeNode(Name n): Node(NodeKind::Type), name(n){}
 };
 
-struct VecNode : Node { std::vector<AST*> items; };
+struct VecNode : Node { std::vector<AST*> items; VecNode(): Node(NodeKind::Vec){} };
 
-struct Program : Node { std::vector<AST*> items; };
+/* Програма володіє ареною: усі вузли і рядки звільняються разом із нею */
+struct Program : Node {
+    Arena arena;
+    Interner names{arena};
+    std::vector<AST*> items;
+    Program(): Node(NodeKind::Program){}
+};
 
+/* slot — індекс у кадрі функції, depth — глибина блоку (0 = параметри); заповнює resolve_program.
+   rank > 0 — масив (T a[] / T a[][]), передається за посиланням */
 struct ParamNode : Node {
-    std::string type, name;
-    ParamNode(std::string t, std::string n): type(std::move(t)), name(std::move(n)){}
+    Name type, name; int depth=-1, slot=-1, rank=0;
+    ParamNode(Name t, Name n): Node(NodeKind::Param), type(t), name(n){}
 };
 
-struct ParamListNode : Node { std::vector<ParamNode*> params; };
+struct ParamListNode : Node { std::vector<ParamNode*> params; ParamListNode(): Node(NodeKind::ParamList){} };
 
 struct BlockNode : Node {
-    std::vector<AST*> stmts; explicit BlockNode(VecNode* v){ if(v){ stmts = std::move(v->items);} }
+    std::vector<AST*> stmts; explicit BlockNode(VecNode* v): Node(NodeKind::Block){ if(v){ stmts = std::move(v->items);} }
 };
 
+/* Масив (rank 1 або 2) має dims замість init: T a[n]; T m[r][c]; — заповнюється нулями */
 struct DeclNode : Node {
-    std::string type, name; ExprNode* init;
-    DeclNode(std::string t, std::string n, ExprNode* i): type(std::move(t)), name(std::move(n)), init(i){}
+    Name type, name; ExprNode* init; int depth=-1, slot=-1;
+    ExprNode* dims[2] = {nullptr, nullptr}; int rank = 0;
+    DeclNode(Name t, Name n, ExprNode* i): Node(NodeKind::Decl), type(t), name(n), init(i){}
+};
+
+struct ExprStmtNode : Node { ExprNode* expr; explicit ExprStmtNode(ExprNode* e): Node(NodeKind::ExprStmt), expr(e){} };
+
+struct AssignNode : ExprNode { Name name; ExprNode* rhs; int depth=-1, slot=-1; AssignNode(Name n, ExprNode* r): ExprNode(NodeKind::Assign), name(n), rhs(r){} };
+
+struct BinOpNode : ExprNode { Op op; ExprNode* a; ExprNode* b; BinOpNode(Op o, ExprNode* A, ExprNode* B): ExprNode(NodeKind::BinOp), op(o), a(A), b(B){} };
+
+struct UnaryOpNode : ExprNode { Op op; ExprNode* x; UnaryOpNode(Op o, ExprNode* X): ExprNode(NodeKind::UnaryOp), op(o), x(X){} };
+
+/* Літерали типізуються одразу: ціле без крапки й експоненти — int (значення в i), інакше double (в v) */
+struct NumberNode : ExprNode {
+    double v = 0; int64_t i = 0;
+    explicit NumberNode(double V): ExprNode(NodeKind::Number), v(V){ type = Type::Double; }
+    explicit NumberNode(int64_t I): ExprNode(NodeKind::Number), i(I){ type = Type::Int; }
 };
 
-struct ExprStmtNode : Node { ExprNode* expr; explicit ExprStmtNode(ExprNode* e): expr(e){} };
+struct BoolNode : ExprNode { bool v; explicit BoolNode(bool V): ExprNode(NodeKind::Bool), v(V){ type = Type::Bool; } };
+
+/* Неявне перетворення x до type; вставляє лише typecheck_program */
+struct CastNode : ExprNode { ExprNode* x; CastNode(Type t, ExprNode* X): ExprNode(NodeKind::Cast), x(X){ type = t; } };
+
+struct VarRefNode : ExprNode { Name name; int depth=-1, slot=-1; explicit VarRefNode(Name n): ExprNode(NodeKind::VarRef), name(n){} };
 
-struct AssignNode : ExprNode { std::string name; ExprNode* rhs; AssignNode(std::string n, ExprNode* r): name(std::move(n)), rhs(r){} };
+/* a[i] або m[i][j] (j == nullptr для одновимірного); name/depth/slot — як у VarRefNode */
+struct IndexNode : ExprNode {
+    Name name; ExprNode* i; ExprNode* j; int depth=-1, slot=-1;
+    IndexNode(Name n, ExprNode* I, ExprNode* J): ExprNode(NodeKind::Index), name(n), i(I), j(J){}
+};
 
-struct BinOpNode : ExprNode { std::string op; ExprNode* a; ExprNode* b; BinOpNode(std::string o, ExprNode* A, ExprNode* B): op(std::move(o)), a(A), b(B){} };
+/* a[i] = rhs; індекси обчислюються раніше за rhs */
+struct IndexAssignNode : ExprNode {
+    IndexNode* at; ExprNode* rhs;
+    IndexAssignNode(IndexNode* a, ExprNode* r): ExprNode(NodeKind::IndexAssign), at(a), rhs(r){}
+};
 
-struct UnaryOpNode : ExprNode { std::string op; ExprNode* x; UnaryOpNode(std::string o, ExprNode* X): op(std::move(o)), x(X){} };
+/* len(a) / len(a, 1) — кількість рядків чи стовпців */
+struct LenNode : ExprNode {
+    Name name; int dim; int depth=-1, slot=-1;
+    LenNode(Name n, int d): ExprNode(NodeKind::Len), name(n), dim(d){ type = Type::Int; }
+};
 
-struct NumberNode : ExprNode { double v; explicit NumberNode(double V): v(V){} };
+struct ReturnNode : Node { ExprNode* expr; explicit ReturnNode(ExprNode* e): Node(NodeKind::Return), expr(e){} };
 
-struct BoolNode : ExprNode { bool v; explicit BoolNode(bool V): v(V){} };
+struct IfNode : Node { ExprNode* cond; Node* thenN; Node* elseN; IfNode(ExprNode* c, Node* t, Node* e): Node(NodeKind::If), cond(c), thenN(t), elseN(e){} };
 
-struct VarRefNode : ExprNode { std::string name; explicit VarRefNode(std::string n): name(std::move(n)){} };
+struct WhileNode : Node { ExprNode* cond; Node* body; WhileNode(ExprNode* c, Node* b): Node(NodeKind::While), cond(c), body(b){} };
 
-struct ReturnNode : Node { ExprNode* expr; explicit ReturnNode(ExprNode* e): expr(e){} };
+/* reduction(op: name) у parallel for: кожна частина ітерацій накопичує свою копію
+   з нейтрального значення (0 для +, 1 для *); depth/slot — resolve_program, type — typecheck_program */
+struct Reduction { Op op; Name name; int depth=-1, slot=-1; Type type=Type::None; };
 
-struct IfNode : Node { ExprNode* cond; Node* thenN; Node* elseN; IfNode(ExprNode* c, Node* t, Node* e): cond(c), thenN(t), elseN(e){} };
+/* parallel — parallel for: ітерації незалежні (перевіряє typecheck_program), їх
+   ділять між потоками eval (пул з крадіжкою роботи) і gen_c (omp parallel for) */
+struct ForNode : Node {
+    ExprNode* init; ExprNode* cond; ExprNode* step; Node* body;
+    bool parallel = false; std::vector<Reduction> reductions;
+    ForNode(ExprNode* i, ExprNode* c, ExprNode* s, Node* b): Node(NodeKind::For), init(i), cond(c), step(s), body(b){}
+};
 
-struct WhileNode : Node { ExprNode* cond; Node* body; WhileNode(ExprNode* c, Node* b): cond(c), body(b){} };
+/* Заголовок parallel for: i = lo; i < hi (чи i <= hi); i = i + step, step — додатна int-стала */
+struct ParLoop { AssignNode* init = nullptr; ExprNode* hi = nullptr; bool inclusive = false; int64_t step = 0; };
+bool par_loop(ForNode* fr, ParLoop& l);
+/* Кількість ітерацій такого заголовка для значень lo і hi */
+uint64_t par_trip_count(const ParLoop& l, int64_t lo, int64_t hi);
+/* parallel for ділиться на стільки частин (або на ітерації, якщо їх менше)
+   незалежно від кількості потоків: частини накопичують редукції окремо і
+   зводяться в порядку номерів, тож результат однаковий для будь-якого -jN
+   і збігається між інтерпретатором (eval.cpp) і C-бекендом (gen_c.cpp) */
+constexpr size_t PAR_CHUNKS = 256;
 
-struct ForNode : Node { ExprNode* init; ExprNode* cond; ExprNode* step; Node* body; ForNode(ExprNode* i, ExprNode* c, ExprNode* s, Node* b): init(i), cond(c), step(s), body(b){} };
+struct ArgListNode : Node { std::vector<ExprNode*> args; ArgListNode(): Node(NodeKind::ArgList){} };
 
-struct ArgListNode : Node { std::vector<ExprNode*> args; };
+struct FuncDefNode;
 
+/* target — визначення, яке викликається (typecheck_program), без пошуку за іменем під час виконання */
 struct CallNode : ExprNode {
-    std::string name; ArgListNode* args;
-    CallNode(std::string n, ArgListNode* a): name(std::move(n)), args(a){}
+    Name name; ArgListNode* args; FuncDefNode* target=nullptr;
+    CallNode(Name n, ArgListNode* a): ExprNode(NodeKind::Call), name(n), args(a){}
 };
 
+/* return f(...) виконується як хвостовий виклик (кадр звільняється до переходу),
+   якщо серед аргументів немає масивів цього кадру. Масив-параметр (depth 0)
+   належить викликачеві й переживає кадр, тож його можна передати далі;
+   масиви не присвоюються, тож параметр завжди вказує на масив викликача */
+inline CallNode* tail_call(ReturnNode* r){
+    if(r->expr->kind != NodeKind::Call) return nullptr;
+    auto* c = static_cast<CallNode*>(r->expr);
+    if(c->args)
+        for(auto* a: c->args->args)
+            if(a->rank && !(a->kind == NodeKind::VarRef && static_cast<VarRefNode*>(a)->depth == 0)) return nullptr;
+    return c;
+}
+
 struct FuncDefNode : Node {
-    std::string retType, name; ParamListNode* params; BlockNode* body;
-    FuncDefNode(std::string r, std::string n, ParamListNode* p, BlockNode* b): retType(std::move(r)), name(std::move(n)), params(p), body(b){}
+    Name retType, name; ParamListNode* params; BlockNode* body; int nslots=0;
+    Type ret = Type::None; // заповнює typecheck_program
+    int id = -1;           // індекс серед функцій програми (typecheck_program)
+    bool pure = false;     // результат залежить лише від аргументів (analyze_purity)
+    FuncDefNode(Name r, Name n, ParamListNode* p, BlockNode* b): Node(NodeKind::FuncDef), retType(r), name(n), params(p), body(b){}
 };
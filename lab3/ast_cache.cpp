@@ -0,0 +1,359 @@
+#include "ast_cache.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include "mapped_file.hpp"
+
+namespace {
+
+const char MAGIC[5] = {'M','C','A','S','T'};
+constexpr uint8_t NONE = 0xFF; // відсутня дитина (else, init, крок for ...)
+
+uint64_t rotl(uint64_t x, int r){ return (x << r) | (x >> (64 - r)); }
+uint64_t zigzag(int64_t v){ return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+int64_t unzigzag(uint64_t v){ return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+/* Рядок вузла: 0 (вирази рядка не мають) або 1 + zigzag(різниця з попереднім ненульовим) —
+   рядки йдуть майже підряд, тож зазвичай це один байт */
+struct Lines {
+    uint32_t last = 0;
+    uint64_t encode(uint32_t line){
+        if(!line) return 0;
+        uint64_t v = 1 + zigzag(int64_t(line) - last);
+        last = line;
+        return v;
+    }
+    uint32_t decode(uint64_t v){
+        if(!v) return 0;
+        return last = uint32_t(int64_t(last) + unzigzag(v - 1));
+    }
+};
+
+struct Writer {
+    std::string body;
+    std::unordered_map<Name, uint32_t> ids;
+    std::vector<Name> names;
+    Lines lines;
+
+    void byte(uint8_t b){ body.push_back(char(b)); }
+    void varint(uint64_t v){ while(v >= 0x80){ byte(uint8_t(v | 0x80)); v >>= 7; } byte(uint8_t(v)); }
+    void name(Name n){
+        auto [it, fresh] = ids.emplace(n, uint32_t(names.size()));
+        if(fresh) names.push_back(n);
+        varint(it->second);
+    }
+    void f64(double d){ char b[8]; std::memcpy(b, &d, 8); body.append(b, 8); }
+
+    void node(AST* n){
+        if(!n){ byte(NONE); return; }
+        byte(uint8_t(n->kind));
+        varint(lines.encode(n->line));
+        switch(n->kind){
+        case NodeKind::FuncDef: {
+            auto* f = as<FuncDefNode>(n);
+            name(f->retType); name(f->name); node(f->params); node(f->body);
+            return;
+        }
+        case NodeKind::ParamList: {
+            auto& ps = as<ParamListNode>(n)->params;
+            varint(ps.size());
+            for(auto* p : ps){ name(p->type); name(p->name); varint(p->rank); }
+            return;
+        }
+        case NodeKind::Block: {
+            auto& ss = as<BlockNode>(n)->stmts;
+            varint(ss.size());
+            for(auto* s : ss) node(s);
+            return;
+        }
+        case NodeKind::Decl: {
+            auto* d = as<DeclNode>(n);
+            name(d->type); name(d->name); varint(d->rank); node(d->init);
+            for(int k=0;k<d->rank;++k) node(d->dims[k]);
+            return;
+        }
+        case NodeKind::ExprStmt: node(as<ExprStmtNode>(n)->expr); return;
+        case NodeKind::Return: node(as<ReturnNode>(n)->expr); return;
+        case NodeKind::If: { auto* iff = as<IfNode>(n); node(iff->cond); node(iff->thenN); node(iff->elseN); return; }
+        case NodeKind::While: node(as<WhileNode>(n)->cond); node(as<WhileNode>(n)->body); return;
+        case NodeKind::For: {
+            auto* fr = as<ForNode>(n);
+            // 0 — звичайний цикл, інакше parallel for з (значення - 1) редукціями
+            varint(fr->parallel? fr->reductions.size() + 1 : 0);
+            for(auto& r : fr->reductions){ byte(uint8_t(r.op)); name(r.name); }
+            node(fr->init); node(fr->cond); node(fr->step); node(fr->body);
+            return;
+        }
+        case NodeKind::Assign: name(as<AssignNode>(n)->name); node(as<AssignNode>(n)->rhs); return;
+        case NodeKind::BinOp: { auto* b = as<BinOpNode>(n); byte(uint8_t(b->op)); node(b->a); node(b->b); return; }
+        case NodeKind::UnaryOp: byte(uint8_t(as<UnaryOpNode>(n)->op)); node(as<UnaryOpNode>(n)->x); return;
+        case NodeKind::Cast: byte(uint8_t(as<CastNode>(n)->type)); node(as<CastNode>(n)->x); return;
+        case NodeKind::Number: {
+            auto* num = as<NumberNode>(n);
+            byte(uint8_t(num->type));
+            if(num->type == Type::Int) varint(zigzag(num->i)); else f64(num->v);
+            return;
+        }
+        case NodeKind::Bool: byte(as<BoolNode>(n)->v); return;
+        case NodeKind::VarRef: name(as<VarRefNode>(n)->name); return;
+        case NodeKind::Call: {
+            auto* c = as<CallNode>(n);
+            name(c->name);
+            if(!c->args){ byte(NONE); return; }
+            byte(0);
+            varint(c->args->args.size());
+            for(auto* a : c->args->args) node(a);
+            return;
+        }
+        case NodeKind::Index: { auto* x = as<IndexNode>(n); name(x->name); node(x->i); node(x->j); return; }
+        case NodeKind::IndexAssign: node(as<IndexAssignNode>(n)->at); node(as<IndexAssignNode>(n)->rhs); return;
+        case NodeKind::Len: name(as<LenNode>(n)->name); varint(as<LenNode>(n)->dim); return;
+        default: throw std::runtime_error(std::string("AST cache: unexpected ")+kind_name(n->kind));
+        }
+    }
+};
+
+/* Декодер із перевіркою меж і видів вузлів: пошкоджений файл дає виняток, а не UB */
+struct Reader {
+    const unsigned char* p;
+    const unsigned char* end;
+    Program* prog;
+    std::vector<Name> names;
+    Lines lines;
+
+    [[noreturn]] static void bad(){ throw std::runtime_error("corrupt AST cache"); }
+    uint8_t byte(){ if(p == end) bad(); return *p++; }
+    uint64_t varint(){
+        uint64_t v = 0;
+        for(int s = 0; s < 64; s += 7){
+            uint8_t b = byte();
+            v |= uint64_t(b & 0x7f) << s;
+            if(!(b & 0x80)) return v;
+        }
+        bad();
+    }
+    uint64_t fixed(int n){
+        if(end - p < n) bad();
+        uint64_t v = 0;
+        std::memcpy(&v, p, n); p += n;
+        return v;
+    }
+    Name name(){ uint64_t i = varint(); if(i >= names.size()) bad(); return names[i]; }
+    int small(int limit){ uint64_t v = varint(); if(v > uint64_t(limit)) bad(); return int(v); }
+    template<typename T, typename... A> T* mk(A&&... a){ return prog->arena.make<T>(std::forward<A>(a)...); }
+
+    static bool is_expr(NodeKind k){
+        switch(k){
+        case NodeKind::Assign: case NodeKind::BinOp: case NodeKind::UnaryOp: case NodeKind::Number:
+        case NodeKind::Bool: case NodeKind::VarRef: case NodeKind::Call: case NodeKind::Cast:
+        case NodeKind::Index: case NodeKind::IndexAssign: case NodeKind::Len:
+            return true;
+        default: return false;
+        }
+    }
+    ExprNode* expr(bool optional = false){
+        AST* n = node();
+        if(!n){ if(!optional) bad(); return nullptr; }
+        if(!is_expr(n->kind)) bad();
+        return as<ExprNode>(n);
+    }
+    Node* stmt(bool optional = false){
+        AST* n = node();
+        if(!n){ if(!optional) bad(); return nullptr; }
+        if(is_expr(n->kind) || n->kind == NodeKind::FuncDef || n->kind == NodeKind::ParamList) bad();
+        return as<Node>(n);
+    }
+    template<typename T> T* exact(NodeKind k, bool optional){
+        AST* n = node();
+        if(!n){ if(!optional) bad(); return nullptr; }
+        if(n->kind != k) bad();
+        return as<T>(n);
+    }
+
+    AST* node(){
+        uint8_t k = byte();
+        if(k == NONE) return nullptr;
+        uint32_t line = lines.decode(varint());
+        AST* n = decode(NodeKind(k));
+        n->line = line;
+        return n;
+    }
+
+    AST* decode(NodeKind k){
+        switch(k){
+        case NodeKind::FuncDef: {
+            Name r = name(), n = name();
+            auto* ps = exact<ParamListNode>(NodeKind::ParamList, true);
+            return mk<FuncDefNode>(r, n, ps, exact<BlockNode>(NodeKind::Block, false));
+        }
+        case NodeKind::ParamList: {
+            auto* pl = mk<ParamListNode>();
+            for(uint64_t i = 0, n = varint(); i < n; ++i){
+                Name t = name(), nm = name();
+                auto* pr = mk<ParamNode>(t, nm);
+                pr->rank = small(2);
+                pl->params.push_back(pr);
+            }
+            return pl;
+        }
+        case NodeKind::Block: {
+            auto* b = mk<BlockNode>(nullptr);
+            for(uint64_t i = 0, n = varint(); i < n; ++i) b->stmts.push_back(stmt());
+            return b;
+        }
+        case NodeKind::Decl: {
+            Name t = name(), n = name();
+            int rank = small(2);
+            auto* d = mk<DeclNode>(t, n, expr(true));
+            d->rank = rank;
+            for(int i=0;i<rank;++i) d->dims[i] = expr();
+            return d;
+        }
+        case NodeKind::ExprStmt: return mk<ExprStmtNode>(expr());
+        case NodeKind::Return: return mk<ReturnNode>(expr());
+        case NodeKind::If: {
+            ExprNode* c = expr(); Node* t = stmt();
+            return mk<IfNode>(c, t, stmt(true));
+        }
+        case NodeKind::While: { ExprNode* c = expr(); return mk<WhileNode>(c, stmt()); }
+        case NodeKind::For: {
+            uint64_t par = varint();
+            std::vector<Reduction> reds;
+            for(uint64_t i = 1; i < par; ++i){
+                Op op = Op(small(int(Op::Neg)));
+                if(op != Op::Add && op != Op::Mul) bad();
+                reds.push_back({op, name()});
+            }
+            ExprNode* i = expr(true); ExprNode* c = expr(true); ExprNode* s = expr(true);
+            auto* fr = mk<ForNode>(i, c, s, stmt());
+            fr->parallel = par > 0;
+            fr->reductions = std::move(reds);
+            return fr;
+        }
+        case NodeKind::Assign: { Name n = name(); return mk<AssignNode>(n, expr()); }
+        case NodeKind::BinOp: {
+            Op op = Op(small(int(Op::Neg)));
+            ExprNode* a = expr();
+            return mk<BinOpNode>(op, a, expr());
+        }
+        case NodeKind::UnaryOp: { Op op = Op(small(int(Op::Neg))); return mk<UnaryOpNode>(op, expr()); }
+        case NodeKind::Cast: { Type t = Type(small(int(Type::Bool))); return mk<CastNode>(t, expr()); }
+        case NodeKind::Number: {
+            Type t = Type(byte());
+            if(t == Type::Int) return mk<NumberNode>(unzigzag(varint()));
+            if(t != Type::Double) bad();
+            uint64_t bits = fixed(8);
+            double d; std::memcpy(&d, &bits, 8);
+            return mk<NumberNode>(d);
+        }
+        case NodeKind::Bool: return mk<BoolNode>(small(1) != 0);
+        case NodeKind::VarRef: return mk<VarRefNode>(name());
+        case NodeKind::Call: {
+            Name n = name();
+            ArgListNode* args = nullptr;
+            if(byte() != NONE){
+                args = mk<ArgListNode>();
+                for(uint64_t i = 0, m = varint(); i < m; ++i) args->args.push_back(expr());
+            }
+            return mk<CallNode>(n, args);
+        }
+        case NodeKind::Index: {
+            Name n = name();
+            ExprNode* i = expr();
+            return mk<IndexNode>(n, i, expr(true));
+        }
+        case NodeKind::IndexAssign: {
+            auto* at = exact<IndexNode>(NodeKind::Index, false);
+            return mk<IndexAssignNode>(at, expr());
+        }
+        case NodeKind::Len: { Name n = name(); return mk<LenNode>(n, small(1)); }
+        default: bad();
+        }
+    }
+};
+
+} // namespace
+
+uint64_t source_hash(std::string_view s){
+    // по 8 байтів з перемішуванням, як у MurmurHash3, і фінальний splitmix64
+    const uint64_t c1 = 0x87c37b91114253d5ull, c2 = 0x4cf5ad432745937full;
+    uint64_t h = 0x9e3779b97f4a7c15ull ^ s.size();
+    size_t i = 0;
+    for(; i + 8 <= s.size(); i += 8){
+        uint64_t k; std::memcpy(&k, s.data() + i, 8);
+        k *= c1; k = rotl(k, 31); k *= c2;
+        h ^= k; h = rotl(h, 27) * 5 + 0x52dce729;
+    }
+    uint64_t k = 0;
+    if(i < s.size()) std::memcpy(&k, s.data() + i, s.size() - i);
+    k *= c1; k = rotl(k, 31); k *= c2; h ^= k;
+    h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27; h *= 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+}
+
+std::string ast_cache_path(const char* src){ return std::string(src) + ".astc"; }
+
+std::unique_ptr<Program> load_ast_cache(const std::string& path, std::string_view src){
+    MappedFile map;
+    std::string err;
+    if(!map.open(path.c_str(), err)) return nullptr;
+    auto prog = std::make_unique<Program>();
+    Reader r{reinterpret_cast<const unsigned char*>(map.view().data()),
+             reinterpret_cast<const unsigned char*>(map.view().data() + map.view().size()), prog.get(), {}, {}};
+    try {
+        if(r.end - r.p < 5 || std::memcmp(r.p, MAGIC, 5) != 0) return nullptr;
+        r.p += 5;
+        if(r.fixed(4) != AST_CACHE_VERSION || r.fixed(8) != source_hash(src) || r.fixed(8) != src.size()) return nullptr;
+        for(uint64_t i = 0, n = r.varint(); i < n; ++i){
+            uint64_t len = r.varint();
+            if(uint64_t(r.end - r.p) < len) Reader::bad();
+            r.names.push_back(prog->names.intern(std::string_view(reinterpret_cast<const char*>(r.p), len)));
+            r.p += len;
+        }
+        for(uint64_t i = 0, n = r.varint(); i < n; ++i){
+            AST* it = r.node();
+            if(!it || (it->kind != NodeKind::FuncDef && it->kind != NodeKind::Decl)) Reader::bad();
+            prog->items.push_back(it);
+        }
+        if(r.p != r.end) Reader::bad();
+    } catch(const std::exception&){
+        return nullptr;
+    }
+    return prog;
+}
+
+bool save_ast_cache(const Program* p, const std::string& path, std::string_view src, std::string& err){
+    Writer w;
+    w.varint(p->items.size());
+    for(auto* it : p->items) w.node(it);
+    std::string items = std::move(w.body);
+
+    std::string out(MAGIC, 5);
+    uint32_t ver = AST_CACHE_VERSION; uint64_t hash = source_hash(src), size = src.size();
+    out.append(reinterpret_cast<const char*>(&ver), 4);
+    out.append(reinterpret_cast<const char*>(&hash), 8);
+    out.append(reinterpret_cast<const char*>(&size), 8);
+    w.body.clear();
+    w.varint(w.names.size());
+    for(Name n : w.names){ w.varint(n.size()); w.body.append(n.data(), n.size()); }
+    out += w.body;
+    out += items;
+
+    // інший процес може читати кеш одночасно: пишемо поруч і підміняємо rename
+    std::string tmp = path + ".tmp" + std::to_string(getpid());
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if(!f){ err = tmp + ": " + std::strerror(errno); return false; }
+    bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if(!ok || std::rename(tmp.c_str(), path.c_str()) != 0){
+        err = path + ": " + std::strerror(errno);
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "ast.hpp"
+
+/*
+ * Двійковий кеш розібраної програми (до resolve): foo.mc++ -> foo.mc++.astc.
+ * Формат не містить ні вказівників, ні зсувів — лише послідовні записи:
+ *   заголовок  "MCAST" + версія формату, хеш і розмір джерела;
+ *   імена      кількість, далі довжина (varint) і байти кожного імені;
+ *   вузли      Program.items у прямому порядку обходу: вид (байт), рядок
+ *              (різницею з попереднім), поля (varint, імена — індексом
+ *              у таблиці), діти рекурсивно; відсутня дитина — окремий байт.
+ * Файл відображається в пам'ять і декодується послідовно прямо в арену
+ * нової Program; імена інтернуються з відображення без проміжних копій.
+ * Будь-яка невідповідність (інша версія чи джерело, обрізаний файл) —
+ * промах, і програма розбирається звичайно.
+ * AST_CACHE_VERSION треба збільшувати при зміні граматики чи полів вузлів.
+ */
+constexpr uint32_t AST_CACHE_VERSION = 2;
+
+/* 64-бітний хеш вмісту джерела (ключ кешу разом із розміром) */
+uint64_t source_hash(std::string_view src);
+
+std::string ast_cache_path(const char* src);
+
+/* nullptr, якщо кешу немає чи він не для цього джерела */
+std::unique_ptr<Program> load_ast_cache(const std::string& path, std::string_view src);
+
+/* Пише атомарно (тимчасовий файл + rename); false і причина в err при помилці */
+bool save_ast_cache(const Program* p, const std::string& path, std::string_view src, std::string& err);
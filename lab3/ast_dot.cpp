@@ -1,72 +1,193 @@
 #include "ast_dot.hpp"
-#include <typeinfo>
-#include <sstream>
+#include <charconv>
+#include <cmath>
 
-static int gid=0;
-static std::ostringstream oss;
+namespace {
 
-static int emit(AST* n){ return ++gid; }
+/* Діти вузла в порядку джерела (відсутні — nullptr, їх пропускає викликач) */
+template<class F> void children(AST* n, F&& f){
+    switch(n->kind){
+    case NodeKind::Program: for(auto* it: as<Program>(n)->items) f(it); break;
+    case NodeKind::Block: for(auto* it: as<BlockNode>(n)->stmts) f(it); break;
+    case NodeKind::Decl: { auto* d=as<DeclNode>(n); f(d->init); f(d->dims[0]); f(d->dims[1]); break; }
+    case NodeKind::ExprStmt: f(as<ExprStmtNode>(n)->expr); break;
+    case NodeKind::Assign: f(as<AssignNode>(n)->rhs); break;
+    case NodeKind::BinOp: { auto* bo=as<BinOpNode>(n); f(bo->a); f(bo->b); break; }
+    case NodeKind::UnaryOp: f(as<UnaryOpNode>(n)->x); break;
+    case NodeKind::Cast: f(as<CastNode>(n)->x); break;
+    case NodeKind::If: { auto* iff=as<IfNode>(n); f(iff->cond); f(iff->thenN); f(iff->elseN); break; }
+    case NodeKind::While: { auto* wh=as<WhileNode>(n); f(wh->cond); f(wh->body); break; }
+    case NodeKind::For: { auto* fr=as<ForNode>(n); f(fr->init); f(fr->cond); f(fr->step); f(fr->body); break; }
+    case NodeKind::FuncDef: {
+        auto* fd=as<FuncDefNode>(n);
+        if(fd->params){ for(auto* p: fd->params->params) f(p); }
+        f(fd->body);
+        break;
+    }
+    case NodeKind::Call: { auto* call=as<CallNode>(n); if(call->args){ for(auto* e: call->args->args) f(e); } break; }
+    case NodeKind::Return: f(as<ReturnNode>(n)->expr); break;
+    case NodeKind::Index: { auto* x=as<IndexNode>(n); f(x->i); f(x->j); break; }
+    case NodeKind::IndexAssign: { auto* a=as<IndexAssignNode>(n); f(a->at); f(a->rhs); break; }
+    default: break;
+    }
+}
 
-static void walk(AST* n, int id){
-    if(!n) return;
-    auto label = std::string(typeid(*n).name());
-    if(auto* t=dynamic_cast<TypeNode*>(n)) label = "Type:"+t->name;
-    if(auto* d=dynamic_cast<DeclNode*>(n)) label = "Decl:"+d->name+" :"+d->type;
-    if(auto* v=dynamic_cast<VarRefNode*>(n)) label = "Var:"+v->name;
-    if(auto* nb=dynamic_cast<NumberNode*>(n)) label = "Num:"+std::to_string(nb->v);
-    if(auto* bb=dynamic_cast<BoolNode*>(n)) label = std::string("Bool:")+(bb->v?"true":"false");
-    if(auto* bo=dynamic_cast<BinOpNode*>(n)) label = "Bin:"+bo->op;
-    if(auto* uo=dynamic_cast<UnaryOpNode*>(n)) label = "Un:"+uo->op;
-    if(auto* asn=dynamic_cast<AssignNode*>(n)) label = "Assign:"+asn->name;
-    if(auto* fn=dynamic_cast<FuncDefNode*>(n)) label = "Func:"+fn->name+" ->"+fn->retType;
-    if(dynamic_cast<BlockNode*>(n)) label = "Block";
-    if(dynamic_cast<IfNode*>(n)) label = "If";
-    if(dynamic_cast<WhileNode*>(n)) label = "While";
-    if(dynamic_cast<ForNode*>(n)) label = "For";
-    if(dynamic_cast<ExprStmtNode*>(n)) label = "ExprStmt";
-    if(dynamic_cast<Program*>(n)) label = "Program";
-    if(auto* call = dynamic_cast<CallNode*>(n)) label = "Call:"+call->name;
+/* Найкоротший запис, що точно відновлює значення; false — inf/nan */
+bool put_double(std::ostream& out, double v){
+    char buf[32];
+    auto r = std::to_chars(buf, buf + sizeof buf, v);
+    out.write(buf, r.ptr - buf);
+    return std::isfinite(v);
+}
 
-    oss << "  n"<<id<<" [label=\""<<label<<"\"];\n";
+const char* rank_str(int rank){ return rank==2? "[][]" : rank? "[]" : ""; }
 
-    auto link=[&](AST* c){ if(!c) return; int cid=emit(c); oss<<"  n"<<id<<" -> n"<<cid<<";\n"; walk(c,cid); };
+/* Підпис вузла для Dot і Text — пишеться прямо в потік, без проміжних рядків */
+void label(std::ostream& out, AST* n){
+    switch(n->kind){
+    case NodeKind::Type: out << "Type:" << as<TypeNode>(n)->name; break;
+    case NodeKind::Decl: { auto* d=as<DeclNode>(n); out << "Decl:" << d->name << " :" << d->type << rank_str(d->rank); break; }
+    case NodeKind::Param: { auto* p=as<ParamNode>(n); out << "Param:" << p->name << " :" << p->type << rank_str(p->rank); break; }
+    case NodeKind::VarRef: out << "Var:" << as<VarRefNode>(n)->name; break;
+    case NodeKind::Number: {
+        auto* num=as<NumberNode>(n); out << "Num:";
+        if(num->type==Type::Int) out << num->i; else put_double(out, num->v);
+        break;
+    }
+    case NodeKind::Bool: out << "Bool:" << (as<BoolNode>(n)->v? "true" : "false"); break;
+    case NodeKind::BinOp: out << "Bin:" << op_str(as<BinOpNode>(n)->op); break;
+    case NodeKind::UnaryOp: out << "Un:" << op_str(as<UnaryOpNode>(n)->op); break;
+    case NodeKind::Assign: out << "Assign:" << as<AssignNode>(n)->name; break;
+    case NodeKind::FuncDef: { auto* fn=as<FuncDefNode>(n); out << "Func:" << fn->name << " ->" << fn->retType; break; }
+    case NodeKind::Call: out << "Call:" << as<CallNode>(n)->name; break;
+    case NodeKind::Cast: out << "Cast:" << type_name(as<CastNode>(n)->type); break;
+    case NodeKind::Index: out << "Index:" << as<IndexNode>(n)->name; break;
+    case NodeKind::Len: { auto* l=as<LenNode>(n); out << "Len:" << l->name << (l->dim? ",1" : ""); break; }
+    case NodeKind::For: {
+        auto* fr=as<ForNode>(n);
+        out << (fr->parallel? "ParFor" : "For");
+        for(auto& r: fr->reductions) out << " " << op_str(r.op) << ":" << r.name;
+        break;
+    }
+    default: out << kind_name(n->kind);
+    }
+}
 
-    if(auto* p=dynamic_cast<Program*>(n)){
-        for(auto* it: p->items) link(it);
-    } else if(auto* b=dynamic_cast<BlockNode*>(n)){
-        for(auto* it: b->stmts) link(it);
-    } else if(auto* d=dynamic_cast<DeclNode*>(n)){
-        link(d->init);
-    } else if(auto* es=dynamic_cast<ExprStmtNode*>(n)){
-        link(es->expr);
-    } else if(auto* as=dynamic_cast<AssignNode*>(n)){
-        link(as->rhs);
-    } else if(auto* bo=dynamic_cast<BinOpNode*>(n)){
-        link(bo->a); link(bo->b);
-    } else if(auto* uo=dynamic_cast<UnaryOpNode*>(n)){
-        link(uo->x);
-    } else if(auto* iff=dynamic_cast<IfNode*>(n)){
-        link(iff->cond); link(iff->thenN); link(iff->elseN);
-    } else if(auto* wh=dynamic_cast<WhileNode*>(n)){
-        link(wh->cond); link(wh->body);
-    } else if(auto* fr=dynamic_cast<ForNode*>(n)){
-        link(fr->init); link(fr->cond); link(fr->step); link(fr->body);
-    } else if(auto* fd=dynamic_cast<FuncDefNode*>(n)){
-        if(fd->params){ for(auto* p: fd->params->params) link(p); }
-        link(fd->body);
-    } else if(auto* call=dynamic_cast<CallNode*>(n)){
-        if(call->args){ for(auto* e: call->args->args) link(e); }
-    } else if(auto* pr=dynamic_cast<ParamNode*>(n)){
-        (void)pr;
-    } else if(auto* rt=dynamic_cast<ReturnNode*>(n)){
-        link(rt->expr);
+/* Поля вузла для Json (після "kind" і "line"); імена — ідентифікатори, екранування не потрібне */
+void json_fields(std::ostream& out, AST* n){
+    auto str = [&](const char* k, Name v){ out << ",\"" << k << "\":\"" << v << '"'; };
+    switch(n->kind){
+    case NodeKind::Type: str("name", as<TypeNode>(n)->name); break;
+    case NodeKind::Decl: { auto* d=as<DeclNode>(n); str("name", d->name); str("type", d->type); out << ",\"rank\":" << d->rank; break; }
+    case NodeKind::Param: { auto* p=as<ParamNode>(n); str("name", p->name); str("type", p->type); out << ",\"rank\":" << p->rank; break; }
+    case NodeKind::VarRef: str("name", as<VarRefNode>(n)->name); break;
+    case NodeKind::Number: {
+        auto* num=as<NumberNode>(n);
+        str("type", type_name(num->type));
+        out << ",\"value\":";
+        if(num->type==Type::Int) out << num->i;
+        else if(!std::isfinite(num->v)) out << "null";
+        else put_double(out, num->v);
+        break;
+    }
+    case NodeKind::Bool: out << ",\"value\":" << (as<BoolNode>(n)->v? "true" : "false"); break;
+    case NodeKind::BinOp: str("op", op_str(as<BinOpNode>(n)->op)); break;
+    case NodeKind::UnaryOp: str("op", op_str(as<UnaryOpNode>(n)->op)); break;
+    case NodeKind::Assign: str("name", as<AssignNode>(n)->name); break;
+    case NodeKind::FuncDef: { auto* fn=as<FuncDefNode>(n); str("name", fn->name); str("ret", fn->retType); break; }
+    case NodeKind::Call: str("name", as<CallNode>(n)->name); break;
+    case NodeKind::Cast: str("type", type_name(as<CastNode>(n)->type)); break;
+    case NodeKind::Index: str("name", as<IndexNode>(n)->name); break;
+    case NodeKind::Len: { auto* l=as<LenNode>(n); str("name", l->name); out << ",\"dim\":" << l->dim; break; }
+    case NodeKind::For: {
+        auto* fr=as<ForNode>(n);
+        if(!fr->parallel) break;
+        out << ",\"parallel\":true,\"reductions\":[";
+        for(size_t i=0;i<fr->reductions.size();++i)
+            out << (i? "," : "") << "{\"op\":\"" << op_str(fr->reductions[i].op) << "\",\"name\":\"" << fr->reductions[i].name << "\"}";
+        out << ']';
+        break;
+    }
+    default: break;
     }
 }
 
-std::string ast_to_dot(AST* root){
-    gid=0; oss.str(""); oss.clear();
-    oss << "digraph AST {\n  node [shape=box, fontname=Courier];\n";
-    int id=emit(root); walk(root,id);
-    oss << "}\n";
-    return oss.str();
+/* Стан одного вивантаження: лічильники живуть тут, тож паралельні виклики незалежні */
+struct Dumper {
+    std::ostream& out;
+    const AstDumpOptions& o;
+    AstDumpStats st;
+    size_t next_id = 0; // Dot: n1, n2, ... у прямому порядку обходу
+
+    bool fits(uint32_t depth) const {
+        return (!o.max_depth || depth < o.max_depth) && (!o.max_nodes || st.nodes < o.max_nodes);
+    }
+    void indent(uint32_t depth){ for(uint32_t i=0; i<depth; ++i) out << "  "; }
+
+    void open(AST* n, uint32_t depth, size_t id){
+        switch(o.format){
+        case AstFormat::Dot: out << "  n" << id << " [label=\""; label(out, n); out << "\"];\n"; break;
+        case AstFormat::Text:
+            indent(depth); label(out, n);
+            if(n->line) out << " @" << n->line;
+            out << '\n';
+            break;
+        case AstFormat::Json:
+            out << "{\"kind\":\"" << kind_name(n->kind) << '"';
+            if(n->line) out << ",\"line\":" << n->line;
+            json_fields(out, n);
+            break;
+        }
+    }
+
+    void edge(size_t id, size_t cid, bool first){
+        if(o.format==AstFormat::Dot) out << "  n" << id << " -> n" << cid << ";\n";
+        else if(o.format==AstFormat::Json) out << (first? ",\"kids\":[" : ",");
+    }
+
+    void close(size_t id, uint32_t depth, bool any, size_t skipped){
+        switch(o.format){
+        case AstFormat::Dot:
+            if(skipped) out << "  n" << id << "_more [label=\"... +" << skipped << "\", shape=plaintext];\n"
+                            << "  n" << id << " -> n" << id << "_more [style=dashed];\n";
+            break;
+        case AstFormat::Text: if(skipped){ indent(depth + 1); out << "... +" << skipped << '\n'; } break;
+        case AstFormat::Json:
+            if(any) out << ']';
+            if(skipped) out << ",\"elided\":" << skipped;
+            out << '}';
+            break;
+        }
+    }
+
+    void walk(AST* n, uint32_t depth, size_t id){
+        open(n, depth, id);
+        bool any = false;
+        size_t skipped = 0;
+        children(n, [&](AST* c){
+            if(!c) return;
+            if(!fits(depth + 1)){ skipped++; return; }
+            st.nodes++;
+            size_t cid = ++next_id;
+            edge(id, cid, !any);
+            any = true;
+            walk(c, depth + 1, cid);
+        });
+        st.elided += skipped;
+        close(id, depth, any, skipped);
+    }
+};
+
+} // namespace
+
+AstDumpStats dump_ast(std::ostream& out, AST* root, const AstDumpOptions& o){
+    Dumper d{out, o, {}};
+    if(o.format==AstFormat::Dot) out << "digraph AST {\n  node [shape=box, fontname=Courier];\n";
+    if(root){
+        d.st.nodes = 1;
+        d.walk(root, 0, ++d.next_id);
+    }
+    if(o.format==AstFormat::Dot) out << "}\n";
+    else if(o.format==AstFormat::Json) out << '\n';
+    return d.st;
 }
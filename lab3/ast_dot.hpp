@@ -1,6 +1,31 @@
 // ast_dot.hpp
 #pragma once
-#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
 #include "ast.hpp"
 
-std::string ast_to_dot(AST* root);
+/*
+ * Вивантаження AST (--dump-ast): вузли пишуться в потік одразу під час обходу,
+ * тож пам'ять не залежить від розміру програми (лише стек глибини дерева).
+ *   Dot  — граф для graphviz (dot -Tpng ast.dot -o ast.png);
+ *   Text — вузол на рядок із відступом за глибиною: "Bin:+ @3";
+ *   Json — один вкладений об'єкт {"kind","line",поля виду,"kids":[...]}.
+ * Обмеження (0 — без обмеження): max_depth — скільки рівнів від кореня,
+ * max_nodes — скільки вузлів усього. Відкинуті піддерева позначаються
+ * "... +k" (Json: "elided":k) біля батька.
+ */
+enum class AstFormat { Dot, Text, Json };
+
+struct AstDumpOptions {
+    AstFormat format = AstFormat::Dot;
+    uint32_t max_depth = 0;
+    size_t max_nodes = 0;
+};
+
+struct AstDumpStats {
+    size_t nodes = 0;  // записано
+    size_t elided = 0; // відкинуто піддерев
+};
+
+AstDumpStats dump_ast(std::ostream& out, AST* root, const AstDumpOptions& o = {});
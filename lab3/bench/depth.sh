@@ -0,0 +1,27 @@
+#!/bin/sh
+# Регресія межі глибини: bench/deep.mc++ у кожному режимі виконання має
+# завершитися помилкою "Call depth limit exceeded", а не SIGSEGV.
+#   bench/depth.sh [program.mc++]
+# Змінна MINI_CPP — шлях до mini_cpp. Код виходу 1, якщо хоч один режим упав.
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+BIN=${MINI_CPP:-$HERE/../mini_cpp}
+PROG=${1:-$HERE/deep.mc++}
+case $PROG in /*) ;; *) PROG=$(pwd)/$PROG ;; esac
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK" || exit 1
+
+status=0
+for mode in "--jit=off -j1" "--jit=off -j4" "--memoize" "--profile" "--jit=hot -j4" "--jit=all" "--vm"; do
+    # shellcheck disable=SC2086
+    "$BIN" "$PROG" --run $mode > out 2>&1
+    rc=$?
+    if grep -q "Call depth limit exceeded" out; then
+        echo "ok   $mode: $(grep -o 'Call depth limit exceeded.*' out | head -1)"
+    else
+        echo "FAIL $mode: exit $rc, $(tail -1 out)"
+        status=1
+    fi
+done
+exit $status
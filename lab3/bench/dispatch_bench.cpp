@@ -0,0 +1,129 @@
+// Мікробенчмарк вартості диспетчеризації на вузол:
+// ланцюжок dynamic_cast (як було в eval/gen_c/ast_dot) проти switch по AST::kind.
+// Обидва обходи рахують однакову контрольну суму по тому самому дереву.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include "../ast.hpp"
+
+static std::mt19937 rng(42);
+
+static ExprNode* gen_expr(int depth){
+    if(depth == 0){
+        switch(rng() % 3){
+            case 0: return new NumberNode(double(rng() % 100));
+            case 1: return new BoolNode(rng() & 1);
+            default: return new VarRefNode("x");
+        }
+    }
+    switch(rng() % 4){
+        case 0: return new UnaryOpNode(Op::Neg, gen_expr(depth-1));
+        case 1: return new AssignNode("x", gen_expr(depth-1));
+        default: return new BinOpNode((Op)(rng() % 11), gen_expr(depth-1), gen_expr(depth-1));
+    }
+}
+
+static Node* gen_stmt(int depth){
+    if(depth == 0) return new ExprStmtNode(gen_expr(6));
+    switch(rng() % 5){
+        case 0: return new IfNode(gen_expr(3), gen_stmt(depth-1), gen_stmt(depth-1));
+        case 1: return new WhileNode(gen_expr(3), gen_stmt(depth-1));
+        case 2: return new ReturnNode(gen_expr(4));
+        case 3: return new DeclNode("int", "x", gen_expr(4));
+        default: {
+            auto* v = new VecNode();
+            for(int i=0;i<4;++i) v->items.push_back(gen_stmt(depth-1));
+            return new BlockNode(v);
+        }
+    }
+}
+
+/* "До": порядок перевірок як у старому walk з ast_dot.cpp */
+static long walk_cast(AST* n){
+    if(!n) return 0;
+    long s = 1;
+    if(auto* d=dynamic_cast<DeclNode*>(n)) return s + walk_cast(d->init);
+    if(auto* es=dynamic_cast<ExprStmtNode*>(n)) return s + walk_cast(es->expr);
+    if(auto* r=dynamic_cast<ReturnNode*>(n)) return s + walk_cast(r->expr);
+    if(auto* iff=dynamic_cast<IfNode*>(n)) return s + walk_cast(iff->cond) + walk_cast(iff->thenN) + walk_cast(iff->elseN);
+    if(auto* wh=dynamic_cast<WhileNode*>(n)) return s + walk_cast(wh->cond) + walk_cast(wh->body);
+    if(auto* fr=dynamic_cast<ForNode*>(n)) return s + walk_cast(fr->init) + walk_cast(fr->cond) + walk_cast(fr->step) + walk_cast(fr->body);
+    if(auto* b=dynamic_cast<BlockNode*>(n)){ for(auto* it: b->stmts) s += walk_cast(it); return s; }
+    if(auto* a=dynamic_cast<AssignNode*>(n)) return s + walk_cast(a->rhs);
+    if(auto* bo=dynamic_cast<BinOpNode*>(n)) return s + (long)bo->op + walk_cast(bo->a) + walk_cast(bo->b);
+    if(auto* u=dynamic_cast<UnaryOpNode*>(n)) return s + walk_cast(u->x);
+    if(auto* k=dynamic_cast<NumberNode*>(n)) return s + (long)k->v;
+    if(auto* bb=dynamic_cast<BoolNode*>(n)) return s + bb->v;
+    if(dynamic_cast<VarRefNode*>(n)) return s + 7;
+    return s;
+}
+
+/* "Після": один switch по тегу */
+static long walk_kind(AST* n){
+    if(!n) return 0;
+    long s = 1;
+    switch(n->kind){
+    case NodeKind::Decl: return s + walk_kind(as<DeclNode>(n)->init);
+    case NodeKind::ExprStmt: return s + walk_kind(as<ExprStmtNode>(n)->expr);
+    case NodeKind::Return: return s + walk_kind(as<ReturnNode>(n)->expr);
+    case NodeKind::If: { auto* iff=as<IfNode>(n); return s + walk_kind(iff->cond) + walk_kind(iff->thenN) + walk_kind(iff->elseN); }
+    case NodeKind::While: { auto* wh=as<WhileNode>(n); return s + walk_kind(wh->cond) + walk_kind(wh->body); }
+    case NodeKind::For: { auto* fr=as<ForNode>(n); return s + walk_kind(fr->init) + walk_kind(fr->cond) + walk_kind(fr->step) + walk_kind(fr->body); }
+    case NodeKind::Block: for(auto* it: as<BlockNode>(n)->stmts) s += walk_kind(it); return s;
+    case NodeKind::Assign: return s + walk_kind(as<AssignNode>(n)->rhs);
+    case NodeKind::BinOp: { auto* bo=as<BinOpNode>(n); return s + (long)bo->op + walk_kind(bo->a) + walk_kind(bo->b); }
+    case NodeKind::UnaryOp: return s + walk_kind(as<UnaryOpNode>(n)->x);
+    case NodeKind::Number: return s + (long)as<NumberNode>(n)->v;
+    case NodeKind::Bool: return s + as<BoolNode>(n)->v;
+    case NodeKind::VarRef: return s + 7;
+    default: return s;
+    }
+}
+
+static long count_nodes(AST* n){
+    // кількість вузлів = контрольна сума без "ваг" листків — рахуємо окремим проходом
+    if(!n) return 0;
+    switch(n->kind){
+    case NodeKind::Decl: return 1 + count_nodes(as<DeclNode>(n)->init);
+    case NodeKind::ExprStmt: return 1 + count_nodes(as<ExprStmtNode>(n)->expr);
+    case NodeKind::Return: return 1 + count_nodes(as<ReturnNode>(n)->expr);
+    case NodeKind::If: { auto* iff=as<IfNode>(n); return 1 + count_nodes(iff->cond) + count_nodes(iff->thenN) + count_nodes(iff->elseN); }
+    case NodeKind::While: { auto* wh=as<WhileNode>(n); return 1 + count_nodes(wh->cond) + count_nodes(wh->body); }
+    case NodeKind::Block: { long s=1; for(auto* it: as<BlockNode>(n)->stmts) s += count_nodes(it); return s; }
+    case NodeKind::Assign: return 1 + count_nodes(as<AssignNode>(n)->rhs);
+    case NodeKind::BinOp: { auto* bo=as<BinOpNode>(n); return 1 + count_nodes(bo->a) + count_nodes(bo->b); }
+    case NodeKind::UnaryOp: return 1 + count_nodes(as<UnaryOpNode>(n)->x);
+    default: return 1;
+    }
+}
+
+template<typename F>
+static double time_ns(F f, long& sum, int reps){
+    auto t0 = std::chrono::steady_clock::now();
+    for(int i=0;i<reps;++i) sum += f();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1-t0).count();
+}
+
+int main(int argc, char** argv){
+    int stmts = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int reps  = argc > 2 ? std::atoi(argv[2]) : 50;
+    auto* top = new VecNode();
+    for(int i=0;i<stmts;++i) top->items.push_back(gen_stmt(4));
+    AST* root = new BlockNode(top);
+    long nodes = count_nodes(root);
+
+    long s1=0, s2=0;
+    walk_cast(root); walk_kind(root); // прогрів
+    double tc = time_ns([&]{ return walk_cast(root); }, s1, reps);
+    double tk = time_ns([&]{ return walk_kind(root); }, s2, reps);
+    if(s1 != s2){ std::fprintf(stderr, "checksum mismatch: %ld vs %ld\n", s1, s2); return 1; }
+
+    double per = (double)nodes * reps;
+    std::printf("nodes=%ld reps=%d\n", nodes, reps);
+    std::printf("dynamic_cast: %.2f ns/node\n", tc / per);
+    std::printf("kind switch:  %.2f ns/node\n", tk / per);
+    std::printf("speedup:      %.2fx\n", tc / tk);
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Пропускна здатність libminicpp (minicpp.hpp): скільки викликів функції
+// скрипту за секунду отримує хост. Рядки CSV у stdout:
+//   reload  — на кожен виклик розбір, перевірка і новий World (як запуск mini_cpp);
+//   context — програма спільна, новий ExecContext на кожен виклик;
+//   shared  — програма спільна, у кожного з T потоків один ExecContext на всі виклики.
+// Сума результатів кожного потоку звіряється з однопотоковою; розбіжність — код 1.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../minicpp.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds_since(Clock::time_point t0){
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static void row(const char* mode, unsigned threads, long long calls, double s){
+    std::printf("%s,%u,%lld,%.3f,%.0f\n", mode, threads, calls, s * 1e3, calls / s);
+}
+
+/* Аргументи i-го виклику score: різні, щоб кеш і гілки не вироджувалися */
+static void args_of(long long i, Value* a){
+    a[0] = Value::integer(i % 1000);
+    a[1] = Value::integer((i * 7) % 1000);
+}
+
+int main(int argc, char** argv){
+    const char* src = argc > 1? argv[1] : "bench/embed.mc++";
+    unsigned max_threads = argc > 2? (unsigned)std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    long long calls = argc > 3? std::atoll(argv[3]) : 2000000;
+    if(max_threads == 0) max_threads = 1;
+
+    EngineOptions opts;
+    std::string err;
+    auto prog = CompiledProgram::load(src, opts, err);
+    if(!prog){ std::fprintf(stderr, "%s", err.c_str()); return 2; }
+    int score = prog->find("score");
+    if(score < 0 || prog->arity(score) != 2){ std::fprintf(stderr, "%s: no score(int, int)\n", src); return 2; }
+
+    // еталон: сума за один прохід в одному контексті
+    long long expect = 0;
+    {
+        ExecContext ctx(prog);
+        Value a[2];
+        for(long long i=0;i<calls;++i){ args_of(i, a); expect += ctx.call(score, a).i(); }
+    }
+
+    std::printf("mode,threads,calls,ms,calls_per_s\n");
+    int rc = 0;
+
+    long long n = std::min(calls, 2000LL);
+    auto t0 = Clock::now();
+    for(long long i=0;i<n;++i){
+        auto p = CompiledProgram::load(src, opts, err);
+        ExecContext ctx(p);
+        Value a[2]; args_of(i, a);
+        ctx.call(score, a);
+    }
+    row("reload", 1, n, seconds_since(t0));
+
+    n = std::min(calls, 200000LL);
+    t0 = Clock::now();
+    for(long long i=0;i<n;++i){
+        ExecContext ctx(prog);
+        Value a[2]; args_of(i, a);
+        ctx.call(score, a);
+    }
+    row("context", 1, n, seconds_since(t0));
+
+    // 1, 2, 4, ... і сам max_threads
+    std::vector<unsigned> counts;
+    for(unsigned t=1; t<max_threads; t*=2) counts.push_back(t);
+    counts.push_back(max_threads);
+    for(unsigned t : counts){
+        std::vector<std::thread> pool;
+        std::vector<long long> sums(t);
+        std::atomic<unsigned> ready{0};
+        std::atomic<bool> go{false};
+        for(unsigned k=0;k<t;++k) pool.emplace_back([&, k]{
+            ExecContext ctx(prog); // World, JIT і кеш — свої в кожному потоці
+            ready++;
+            while(!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            long long s = 0;
+            Value a[2];
+            for(long long i=0;i<calls;++i){ args_of(i, a); s += ctx.call(score, a).i(); }
+            sums[k] = s;
+        });
+        while(ready.load() < t) std::this_thread::yield();
+        t0 = Clock::now();
+        go.store(true, std::memory_order_release);
+        for(auto& th : pool) th.join();
+        row("shared", t, calls * t, seconds_since(t0));
+        for(unsigned k=0;k<t;++k) if(sums[k] != expect){
+            std::fprintf(stderr, "thread %u: sum %lld, expected %lld\n", k, sums[k], expect);
+            rc = 1;
+        }
+    }
+    return rc;
+}
@@ -0,0 +1,27 @@
+#!/bin/sh
+# Генерує велике джерело для вимірювання швидкості парсингу:
+#   ./gen_large.sh [функцій] > large.mc++
+# Кожна функція — кілька десятків рядків циклів, умов і виразів; main викликає
+# усі, тож програма також виконується і перевіряється через C-бекенд.
+N=${1:-500}
+awk -v n="$N" 'BEGIN {
+    for (f = 0; f < n; f++) {
+        printf "int f%d(int a, int b) {\n", f
+        printf "  int s = a * %d + b;\n", f % 97 + 1
+        printf "  double d = a * 0.5 + %d.25;\n", f % 13
+        printf "  int i;\n"
+        printf "  for (i = 0; i < %d; i = i + 1) {\n", f % 5 + 1
+        printf "    if (s %% 3 == 0) s = s + i * %d; else s = s - i;\n", f % 7 + 1
+        printf "    d = d + s * 0.125 - (i + 1) * 2.0;\n"
+        printf "    bool t = s > %d && !(i == 2) || d < 0.0;\n", f % 50
+        printf "    if (t) { int k = s %% 11; s = s + k * k; }\n"
+        printf "  }\n"
+        printf "  while (s > 100000) s = s / 2;\n"
+        printf "  int r = d;\n"
+        printf "  return (s + r %% 100) %% 1000;\n"
+        printf "}\n\n"
+    }
+    printf "int main() {\n  int acc = 0;\n"
+    for (f = 0; f < n; f++) printf "  acc = (acc + f%d(%d, acc)) %% 65521;\n", f, f % 17
+    printf "  return acc %% 256;\n}\n"
+}'
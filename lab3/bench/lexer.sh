@@ -0,0 +1,34 @@
+#!/bin/sh
+# Швидкість лексерів: flex (lexer.l, FILE*) проти --lexer=fast (mmap + SWAR)
+# на великому згенерованому джерелі; CSV у stdout.
+#   bench/lexer.sh [функцій]      (типово 20000 — близько 8 МБ)
+# Змінні: MINI_CPP (шлях до mini_cpp), RUNS (повторів, береться найкращий, типово 5).
+# Скрипт завершується з кодом 1, якщо потоки токенів (кількість і хеш) різні.
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+BIN=${MINI_CPP:-$HERE/../mini_cpp}
+RUNS=${RUNS:-5}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+"$HERE/gen_large.sh" "${1:-20000}" > "$WORK/big.mc++"
+bytes=$(wc -c < "$WORK/big.mc++")
+
+echo "lexer,bytes,tokens,best_ms,mtokens_per_s,mb_per_s"
+ref=""
+status=0
+for lexer in flex fast; do
+    best=""
+    for r in $(seq "$RUNS"); do
+        "$BIN" "$WORK/big.mc++" --lex-only --lexer=$lexer --timings > "$WORK/out" 2> "$WORK/err" || { cat "$WORK/err" >&2; exit 1; }
+        t=$(awk '$1 == "timing" && $2 == "lex" { print $3 }' "$WORK/err")
+        best=$(awk -v a="$best" -v b="$t" 'BEGIN { print (a == "" || b < a)? b : a }')
+    done
+    stream=$(cat "$WORK/out")
+    [ -z "$ref" ] && ref=$stream
+    [ "$stream" = "$ref" ] || { echo "token streams differ: $ref vs $stream" >&2; status=1; }
+    tokens=$(echo "$stream" | awk '{ print $2 }')
+    awk -v l=$lexer -v b="$bytes" -v n="$tokens" -v ms="$best" \
+        'BEGIN { printf "%s,%d,%d,%.3f,%.1f,%.1f\n", l, b, n, ms, n / ms / 1e3, b / ms / 1e3 }'
+done
+exit $status
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Множення матриць N x N (типово 800, як у lab4): bench/matmul.mc++ через
+# C-бекенд проти стратегій lab4/matrix.c (naive i-j-k, blocked, avx2) з тими
+# самими прапорцями; CSV у stdout.
+#   bench/matmul.sh [N]
+# Змінні: MINI_CPP (шлях до mini_cpp), CC, CFLAGS (типово -O3 -march=native -fopenmp),
+# THREADS (кількості потоків для OMP_NUM_THREADS, типово "1 <nproc>").
+# Без -fopenmp gcc ігнорує #pragma omp parallel for / simd, які ставить C-бекенд.
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+BIN=${MINI_CPP:-$HERE/../mini_cpp}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--O3 -march=native -fopenmp}
+THREADS=${THREADS:-1 $(nproc)}
+N=${1:-800}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK" || exit 1
+
+now_ns() { date +%s%N; }
+ms() { awk -v a="$1" -v b="$2" 'BEGIN { printf "%.3f", (b - a) / 1e6 }'; }
+
+sed "s/int n = 120;/int n = $N;/" "$HERE/matmul.mc++" > matmul.mc++
+"$BIN" matmul.mc++ --emit-c -O2 > emit.log 2>&1 || { cat emit.log >&2; exit 1; }
+$CC $CFLAGS -fwrapv out.c -o mc || exit 1
+LAB4=$HERE/../../lab4
+$CC $CFLAGS -pthread "$LAB4/matrix.c" "$LAB4/matrices.c" "$LAB4/gemm.c" "$LAB4/gemm_avx2.c" "$LAB4/gemm_parallel.c" "$LAB4/work_pool.c" -o ref -lm || exit 1
+
+echo "program,n,threads,ms"
+for t in $(echo $THREADS | tr ' ' '\n' | sort -nu); do
+    t0=$(now_ns); OMP_NUM_THREADS=$t ./mc; t1=$(now_ns)
+    echo "mc++ i-k-j (omp parallel for + simd),$N,$t,$(ms "$t0" "$t1")"
+done
+# час усього процесу, як і для mc++: ініціалізація входить в обидва
+for k in naive blocked avx2; do
+    t0=$(now_ns); ./ref --size="$N" --kernel=$k > /dev/null || continue; t1=$(now_ns)
+    echo "lab4 matrix.c $k,$N,1,$(ms "$t0" "$t1")"
+done
@@ -0,0 +1,65 @@
+#!/bin/sh
+# Масштабування parallel for: час --run -jN і OpenMP-версії з --emit-c
+# для N = 1, 2, 4, ... MAX (типово nproc); CSV у stdout.
+#   bench/parfor.sh [MAX] [program.mc++]
+# Змінні: MINI_CPP (шлях до mini_cpp), RUNS (запусків на вимір, типово 3), CC.
+# Відповідь програми має бути однаковою за будь-якого N (редукції зводяться
+# в порядку частин) і збігатися з C; інакше код виходу 1.
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+BIN=${MINI_CPP:-$HERE/../mini_cpp}
+CC=${CC:-gcc}
+RUNS=${RUNS:-3}
+MAX=${1:-$(nproc)}
+PROG=${2:-$HERE/parfor.mc++}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+now_ns() { date +%s%N; }
+
+# 1, 2, 4, ... і сам MAX
+counts=""
+n=1
+while [ "$n" -lt "$MAX" ]; do counts="$counts $n"; n=$((n * 2)); done
+counts="$counts $MAX"
+
+# найкращий із RUNS запусків (мс); вивід останнього — у $WORK/out
+best() {
+    min=""
+    for r in $(seq "$RUNS"); do
+        t0=$(now_ns)
+        "$@" > "$WORK/out" 2>&1
+        t1=$(now_ns)
+        t=$(( (t1 - t0) / 1000 ))
+        if [ -z "$min" ] || [ "$t" -lt "$min" ]; then min=$t; fi
+    done
+    ms=$(awk -v t="$min" 'BEGIN { printf "%.3f", t / 1e3 }')
+}
+
+(cd "$WORK" && "$BIN" "$PROG" --emit-c > /dev/null 2>&1) || { echo "emit-c failed" >&2; exit 2; }
+"$CC" -O2 -fopenmp -fwrapv "$WORK/out.c" -o "$WORK/native" -lm || exit 2
+
+echo "executor,threads,ms,speedup,result"
+rc=0
+expect=""
+for ex in run native; do
+    base=""
+    for j in $counts; do
+        if [ "$ex" = run ]; then
+            best "$BIN" "$PROG" --run -j"$j"
+            res=$(awk '/^Program returned:/ { print $3 }' "$WORK/out")
+        else
+            OMP_NUM_THREADS=$j best "$WORK/native"
+            OMP_NUM_THREADS=$j "$WORK/native" > /dev/null 2>&1
+            res=$?
+        fi
+        [ -z "$base" ] && base=$ms
+        [ -z "$expect" ] && expect=$res
+        if [ "$res" != "$expect" ]; then
+            echo "$ex -j$j: result $res, expected $expect" >&2
+            rc=1
+        fi
+        echo "$ex,$j,$ms,$(awk -v b="$base" -v t="$ms" 'BEGIN { printf "%.2f", b / t }'),$res"
+    done
+done
+exit $rc
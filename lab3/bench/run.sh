@@ -0,0 +1,62 @@
+#!/bin/sh
+# Бенчмарк інтерпретатора і C-бекенду, результат — CSV у stdout.
+#   bench/run.sh [program.mc++ ...]      (за замовчуванням — увесь корпус bench/)
+# Змінні: MINI_CPP (шлях до mini_cpp), CC і CFLAGS (компіляція out.c, типово -O2 -fopenmp,
+# щоб діяли прагми omp parallel for / simd C-бекенду), LARGE (функцій у large.mc++).
+# Для кожної програми: час фаз mini_cpp (--timings), час gcc і native-запуску,
+# результат main в інтерпретаторі та код виходу native-програми. Код виходу
+# — лише молодший байт, тож програми корпусу повертають значення 0..255.
+# Скрипт завершується з кодом 1, якщо хоч одна пара результатів не збіглася.
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+BIN=${MINI_CPP:-$HERE/../mini_cpp}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--O2 -fopenmp}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ $# -gt 0 ]; then
+    # скрипт працює в тимчасовому каталозі, тож шляхи робимо абсолютними
+    PROGS=
+    for a in "$@"; do PROGS="$PROGS $(cd "$(dirname "$a")" && pwd)/$(basename "$a")"; done
+else
+    "$HERE/gen_large.sh" "${LARGE:-500}" > "$WORK/large.mc++"
+    PROGS="$HERE/fib.mc++ $HERE/loops.mc++ $HERE/scopes.mc++ $HERE/calls.mc++ $HERE/matmul.mc++ $HERE/nested_par.mc++ $WORK/large.mc++"
+fi
+
+now_ns() { date +%s%N; }
+ms() { awk -v a="$1" -v b="$2" 'BEGIN { printf "%.3f", (b - a) / 1e6 }'; }
+# значення фази з виводу --timings
+phase() { awk -v p="$2" '$1 == "timing" && $2 == p { print $3 }' "$1"; }
+result() { sed -n 's/^Program returned: //p' "$1"; }
+
+echo "program,bytes,parse_ms,interp_ms,jit_ms,vm_ms,emit_c_ms,gcc_ms,native_ms,interp_result,native_result,match"
+status=0
+cd "$WORK" || exit 1
+for p in $PROGS; do
+    name=$(basename "$p" .mc++)
+    bytes=$(wc -c < "$p" | tr -d ' ')
+
+    "$BIN" "$p" --run --jit=off --timings > off.out 2> off.err
+    "$BIN" "$p" --run --timings > jit.out 2> jit.err
+    "$BIN" "$p" --run --vm --timings > vm.out 2> vm.err
+    "$BIN" "$p" --emit-c --timings > c.out 2> c.err
+
+    t0=$(now_ns)
+    "$CC" $CFLAGS -fwrapv out.c -o native 2> gcc.err
+    t1=$(now_ns)
+    ./native
+    rc=$?
+    t2=$(now_ns)
+
+    r=$(result off.out)
+    match=no
+    if [ -n "$r" ] && [ "$(result jit.out)" = "$r" ] && [ "$(result vm.out)" = "$r" ] &&
+       [ $(( (r % 256 + 256) % 256 )) -eq "$rc" ]; then
+        match=yes
+    else
+        status=1
+    fi
+    echo "$name,$bytes,$(phase off.err parse),$(phase off.err run),$(phase jit.err run),$(phase vm.err run),$(phase c.err emit-c),$(ms "$t0" "$t1"),$(ms "$t1" "$t2"),${r:-error},$rc,$match"
+done
+exit $status
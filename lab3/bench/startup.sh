@@ -0,0 +1,47 @@
+#!/bin/sh
+# Затримка запуску: холодний розбір джерела проти завантаження --ast-cache; CSV у stdout.
+#   bench/startup.sh [program.mc++ ...]   (типово fib, calls і large.mc++ з gen_large.sh)
+# Змінні: MINI_CPP (шлях до mini_cpp), RUNS (запусків на вимір, типово 20), LARGE (функцій).
+# cold/cached — середній час усього процесу (без --run: розбір, перевірка, вихід),
+# parse/load — середній час лише фази розбору чи завантаження кешу (--timings).
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+BIN=${MINI_CPP:-$HERE/../mini_cpp}
+RUNS=${RUNS:-20}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+if [ $# -gt 0 ]; then
+    PROGS="$*"
+else
+    "$HERE/gen_large.sh" "${LARGE:-500}" > "$WORK/large.mc++"
+    PROGS="$HERE/fib.mc++ $HERE/calls.mc++ $WORK/large.mc++"
+fi
+
+now_ns() { date +%s%N; }
+
+# середній час процесу (мс) і середнє значення фази $2 з --timings
+measure() {
+    total=0
+    : > "$WORK/phases"
+    for r in $(seq "$RUNS"); do
+        t0=$(now_ns)
+        "$BIN" "$WORK/src.mc++" $1 --timings > /dev/null 2> "$WORK/err"
+        t1=$(now_ns)
+        total=$((total + t1 - t0))
+        awk -v p="$2" '$1 == "timing" && $2 == p { print $3 }' "$WORK/err" >> "$WORK/phases"
+    done
+    wall=$(awk -v t="$total" -v n="$RUNS" 'BEGIN { printf "%.3f", t / n / 1e6 }')
+    phase=$(awk '{ s += $1 } END { printf "%.3f", NR? s / NR : 0 }' "$WORK/phases")
+}
+
+echo "program,bytes,cache_bytes,cold_ms,cached_ms,parse_ms,load_ms"
+for p in $PROGS; do
+    name=$(basename "$p" .mc++)
+    cp "$p" "$WORK/src.mc++"
+    rm -f "$WORK/src.mc++.astc"
+    measure "" parse; cold=$wall; parse=$phase
+    "$BIN" "$WORK/src.mc++" --ast-cache > /dev/null 2>&1 # заповнити кеш
+    measure --ast-cache cache-load; cached=$wall; load=$phase
+    echo "$name,$(wc -c < "$WORK/src.mc++"),$(wc -c < "$WORK/src.mc++.astc"),$cold,$cached,$parse,$load"
+done
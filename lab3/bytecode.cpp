@@ -0,0 +1,307 @@
+#include "bytecode.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+const char* bc_op_name(BcOp op){
+    static const char* names[] = {
+#define X(n) #n,
+        BC_OPCODES(X)
+#undef X
+    };
+    return names[(int)op];
+}
+
+namespace {
+
+/* Компілятор однієї функції; слоти змінних уже призначив resolve_program. */
+struct FuncCompiler {
+    BcProgram& bp;
+    BcFunc& fn;
+    int depth=0;
+
+    FuncCompiler(BcProgram& p, BcFunc& f): bp(p), fn(f){}
+
+    void emit(BcOp op, int a=0){
+        switch(op){
+            case BcOp::CONST: case BcOp::LOAD: depth++; break;
+            case BcOp::POP: case BcOp::JMPF: case BcOp::ARR1: case BcOp::XLOAD2: case BcOp::XSTORE1:
+            case BcOp::IADD: case BcOp::ISUB: case BcOp::IMUL: case BcOp::IDIV: case BcOp::IMOD:
+            case BcOp::ILT: case BcOp::IGT: case BcOp::ILE: case BcOp::IGE: case BcOp::IEQ: case BcOp::INE:
+            case BcOp::DADD: case BcOp::DSUB: case BcOp::DMUL: case BcOp::DDIV:
+            case BcOp::DLT: case BcOp::DGT: case BcOp::DLE: case BcOp::DGE: case BcOp::DEQ: case BcOp::DNE:
+                depth--; break;
+            case BcOp::CALL: depth += 1 - bp.funcs[a].nparams; break;
+            case BcOp::TAILCALL: depth -= bp.funcs[a].nparams; break;
+            case BcOp::RET: depth--; break;
+            case BcOp::ARR2: case BcOp::XSTORE2: depth -= 2; break;
+            case BcOp::ROWS: case BcOp::COLS: depth++; break;
+            default: break; // ANDJ/ORJ: гілка зі стрибком лишає значення, інша знімає його — рахуємо від RHS
+        }
+        if(depth > fn.max_stack) fn.max_stack = depth;
+        fn.code.push_back(Instr{op, a});
+    }
+    int here() const { return (int)fn.code.size(); }
+    void patch(int at){ fn.code[at].a = here(); }
+
+    int constant(const Value& v){ bp.consts.push_back(v); return (int)bp.consts.size()-1; }
+
+    void stmt(AST* n){
+        switch(n->kind){
+        case NodeKind::Decl: {
+            auto* d = as<DeclNode>(n);
+            if(d->rank){
+                for(int k=0;k<d->rank;++k) expr(d->dims[k]);
+                emit(d->rank == 2? BcOp::ARR2 : BcOp::ARR1, d->slot);
+                return;
+            }
+            expr(d->init);
+            emit(BcOp::STORE, d->slot); emit(BcOp::POP);
+            return;
+        }
+        case NodeKind::ExprStmt: expr(as<ExprStmtNode>(n)->expr); emit(BcOp::POP); return;
+        case NodeKind::Return: {
+            auto* r = as<ReturnNode>(n);
+            if(CallNode* c = tail_call(r)){ call(c, BcOp::TAILCALL); return; }
+            expr(r->expr);
+            emit(BcOp::RET);
+            return;
+        }
+        case NodeKind::If: {
+            auto* iff = as<IfNode>(n);
+            expr(iff->cond);
+            int jf = here(); emit(BcOp::JMPF);
+            stmt(iff->thenN);
+            if(iff->elseN){
+                int je = here(); emit(BcOp::JMP);
+                patch(jf); stmt(iff->elseN); patch(je);
+            } else patch(jf);
+            return;
+        }
+        case NodeKind::While: {
+            auto* wh = as<WhileNode>(n);
+            int top = here();
+            expr(wh->cond);
+            int jf = here(); emit(BcOp::JMPF);
+            stmt(wh->body);
+            emit(BcOp::JMP, top); patch(jf);
+            return;
+        }
+        case NodeKind::For: {
+            auto* fr = as<ForNode>(n);
+            if(fr->parallel){ parallel_for(fr); return; }
+            if(fr->init){ expr(fr->init); emit(BcOp::POP); }
+            int top = here(), jf = -1;
+            if(fr->cond){ expr(fr->cond); jf = here(); emit(BcOp::JMPF); }
+            stmt(fr->body);
+            if(fr->step){ expr(fr->step); emit(BcOp::POP); }
+            emit(BcOp::JMP, top);
+            if(jf >= 0) patch(jf);
+            return;
+        }
+        case NodeKind::Block: {
+            // масиви блоку звільняються при виході з нього; return звільняє весь кадр у RET
+            auto& stmts = as<BlockNode>(n)->stmts;
+            bool arrays = std::any_of(stmts.begin(), stmts.end(), [](AST* s){
+                return s->kind == NodeKind::Decl && as<DeclNode>(s)->rank; });
+            int mark = arrays? fn.nslots++ : -1;
+            if(arrays) emit(BcOp::AMARK, mark);
+            for(auto* s: stmts) stmt(s);
+            if(arrays) emit(BcOp::AFREE, mark);
+            return;
+        }
+        default: return;
+        }
+    }
+
+    /*
+     * parallel for у VM виконується в одному потоці, але тими самими частинами,
+     * що й у eval (PAR_CHUNKS): редукції кожної частини стартують з нейтрального
+     * значення і додаються до накопичувача по черзі, тож суми double побітово
+     * збігаються з --run і C-бекендом. Лічильники частин — додаткові слоти кадру.
+     * Кількість ітерацій рахується знаковим int: діапазон понад 2^63 ітерацій
+     * однаково не виконати до кінця.
+     */
+    void parallel_for(ForNode* fr){
+        ParLoop l;
+        par_loop(fr, l);
+        auto slot = [&]{ return fn.nslots++; };
+        auto num = [&](int64_t v){ emit(BcOp::CONST, constant(Value::integer(v))); };
+        auto store = [&](int s){ emit(BcOp::STORE, s); emit(BcOp::POP); };
+        int lo = slot(), cnt = slot(), chunks = slot(), q = slot(), r = slot(), t = slot(), e = slot(), k = slot();
+        int iv = l.init->slot;
+        std::vector<int> acc;
+        for(size_t i=0;i<fr->reductions.size();++i) acc.push_back(slot());
+
+        expr(l.init->rhs); store(lo);
+        num(0); store(cnt);
+        // cnt = (hi - lo - 1) / step + 1 для i < hi, (hi - lo) / step + 1 для i <= hi
+        emit(BcOp::LOAD, lo); expr(l.hi); emit(l.inclusive? BcOp::ILE : BcOp::ILT);
+        int jempty = here(); emit(BcOp::JMPF);
+        expr(l.hi); emit(BcOp::LOAD, lo); emit(BcOp::ISUB);
+        if(!l.inclusive){ num(1); emit(BcOp::ISUB); }
+        num(l.step); emit(BcOp::IDIV); num(1); emit(BcOp::IADD); store(cnt);
+
+        num((int64_t)PAR_CHUNKS); store(chunks);
+        emit(BcOp::LOAD, cnt); num((int64_t)PAR_CHUNKS); emit(BcOp::ILT);
+        int jmin = here(); emit(BcOp::JMPF);
+        emit(BcOp::LOAD, cnt); store(chunks);
+        patch(jmin);
+        emit(BcOp::LOAD, cnt); emit(BcOp::LOAD, chunks); emit(BcOp::IDIV); store(q);
+        emit(BcOp::LOAD, cnt); emit(BcOp::LOAD, chunks); emit(BcOp::IMOD); store(r);
+        for(size_t i=0;i<acc.size();++i){ emit(BcOp::LOAD, fr->reductions[i].slot); store(acc[i]); }
+        num(0); store(t);
+        num(0); store(k);
+
+        // частина k: ітерації [t, e), перші r частин на одну довші
+        int chunk_top = here();
+        emit(BcOp::LOAD, k); emit(BcOp::LOAD, chunks); emit(BcOp::ILT);
+        int jdone = here(); emit(BcOp::JMPF);
+        emit(BcOp::LOAD, t); emit(BcOp::LOAD, q); emit(BcOp::IADD); store(e);
+        emit(BcOp::LOAD, k); emit(BcOp::LOAD, r); emit(BcOp::ILT);
+        int jshort = here(); emit(BcOp::JMPF);
+        emit(BcOp::LOAD, e); num(1); emit(BcOp::IADD); store(e);
+        patch(jshort);
+        for(auto& red : fr->reductions){
+            bool add = red.op == Op::Add;
+            emit(BcOp::CONST, constant(red.type == Type::Int? Value::integer(add? 0 : 1) : Value::num(add? 0.0 : 1.0)));
+            store(red.slot);
+        }
+        int iter_top = here();
+        emit(BcOp::LOAD, t); emit(BcOp::LOAD, e); emit(BcOp::ILT);
+        int jchunk = here(); emit(BcOp::JMPF);
+        emit(BcOp::LOAD, lo); emit(BcOp::LOAD, t); num(l.step); emit(BcOp::IMUL); emit(BcOp::IADD); store(iv);
+        stmt(fr->body);
+        emit(BcOp::LOAD, t); num(1); emit(BcOp::IADD); store(t);
+        emit(BcOp::JMP, iter_top);
+        patch(jchunk);
+        for(size_t i=0;i<acc.size();++i){
+            auto& red = fr->reductions[i];
+            emit(BcOp::LOAD, acc[i]); emit(BcOp::LOAD, red.slot); emit(bin_op(red.op, red.type)); store(acc[i]);
+        }
+        emit(BcOp::LOAD, k); num(1); emit(BcOp::IADD); store(k);
+        emit(BcOp::JMP, chunk_top);
+        patch(jdone);
+        for(size_t i=0;i<acc.size();++i){ emit(BcOp::LOAD, acc[i]); store(fr->reductions[i].slot); }
+        patch(jempty);
+        // як після послідовного циклу: перше значення, що не проходить умову
+        emit(BcOp::LOAD, lo); emit(BcOp::LOAD, cnt); num(l.step); emit(BcOp::IMUL); emit(BcOp::IADD); store(iv);
+    }
+
+    static BcOp bin_op(Op op, Type t){
+        bool d = t == Type::Double;
+        switch(op){
+        case Op::Add: return d? BcOp::DADD : BcOp::IADD;
+        case Op::Sub: return d? BcOp::DSUB : BcOp::ISUB;
+        case Op::Mul: return d? BcOp::DMUL : BcOp::IMUL;
+        case Op::Div: return d? BcOp::DDIV : BcOp::IDIV;
+        case Op::Mod: return BcOp::IMOD; // typecheck_program дозволяє % лише для int
+        case Op::Lt: return d? BcOp::DLT : BcOp::ILT;
+        case Op::Gt: return d? BcOp::DGT : BcOp::IGT;
+        case Op::Le: return d? BcOp::DLE : BcOp::ILE;
+        case Op::Ge: return d? BcOp::DGE : BcOp::IGE;
+        case Op::Eq: return d? BcOp::DEQ : BcOp::IEQ;
+        case Op::Ne: return d? BcOp::DNE : BcOp::INE;
+        default: throw std::runtime_error(std::string("Unknown binop: ")+op_str(op));
+        }
+    }
+
+    void call(CallNode* c, BcOp op){
+        int fi = bp.find(c->name);
+        if(fi < 0) throw std::runtime_error("Unknown function: "+std::string(c->name));
+        size_t n = c->args? c->args->args.size() : 0;
+        if((int)n != bp.funcs[fi].nparams) throw std::runtime_error("Arity mismatch in "+std::string(c->name));
+        if(c->args) for(auto* a: c->args->args) expr(a);
+        emit(op, fi);
+    }
+
+    void expr(ExprNode* e){
+        switch(e->kind){
+        case NodeKind::Assign: { auto* a = as<AssignNode>(e); expr(a->rhs); emit(BcOp::STORE, a->slot); return; }
+        case NodeKind::BinOp: {
+            auto* b = as<BinOpNode>(e);
+            expr(b->a);
+            if(b->op==Op::And || b->op==Op::Or){
+                int j = here(); emit(b->op==Op::And? BcOp::ANDJ : BcOp::ORJ);
+                depth--; expr(b->b); patch(j);
+                return;
+            }
+            expr(b->b);
+            emit(bin_op(b->op, b->a->type));
+            return;
+        }
+        case NodeKind::UnaryOp: {
+            auto* u = as<UnaryOpNode>(e);
+            expr(u->x);
+            emit(u->op==Op::Not? BcOp::NOT : u->type==Type::Double? BcOp::DNEG : BcOp::INEG);
+            return;
+        }
+        case NodeKind::Cast: {
+            auto* c = as<CastNode>(e);
+            expr(c->x);
+            bool from_d = c->x->type == Type::Double;
+            if(c->type == Type::Bool) emit(from_d? BcOp::D2B : BcOp::I2B);
+            else if(c->type == Type::Double){ if(!from_d) emit(BcOp::I2D); }
+            else if(from_d) emit(BcOp::D2I);
+            return;
+        }
+        case NodeKind::Number: {
+            auto* num = as<NumberNode>(e);
+            emit(BcOp::CONST, constant(num->type == Type::Int? Value::integer(num->i) : Value::num(num->v)));
+            return;
+        }
+        case NodeKind::Bool: emit(BcOp::CONST, constant(Value::boolean(as<BoolNode>(e)->v))); return;
+        case NodeKind::VarRef: emit(BcOp::LOAD, as<VarRefNode>(e)->slot); return;
+        case NodeKind::Call: call(as<CallNode>(e), BcOp::CALL); return;
+        case NodeKind::Index: {
+            auto* x = as<IndexNode>(e);
+            expr(x->i);
+            if(x->j) expr(x->j);
+            emit(x->j? BcOp::XLOAD2 : BcOp::XLOAD1, x->slot);
+            return;
+        }
+        case NodeKind::IndexAssign: {
+            auto* a = as<IndexAssignNode>(e);
+            expr(a->at->i);
+            if(a->at->j) expr(a->at->j);
+            expr(a->rhs);
+            emit(a->at->j? BcOp::XSTORE2 : BcOp::XSTORE1, a->at->slot);
+            return;
+        }
+        case NodeKind::Len: { auto* l = as<LenNode>(e); emit(l->dim? BcOp::COLS : BcOp::ROWS, l->slot); return; }
+        default:
+            throw std::runtime_error("Unknown expr node");
+        }
+    }
+
+    void function(FuncDefNode* f){
+        fn.nslots = f->nslots;
+        stmt(f->body);
+        // вихід без return повертає нуль свого типу, як і call_func
+        emit(BcOp::CONST, constant(Value::zero(f->ret)));
+        emit(BcOp::RET);
+    }
+};
+
+} // namespace
+
+BcProgram compile_program(Program* p){
+    BcProgram bp;
+    std::vector<FuncDefNode*> defs;
+    // спершу реєструємо всі імена, щоб виклики вперед теж резолвились
+    for(auto* it : p->items){
+        if(it->kind == NodeKind::FuncDef){
+            auto* f = as<FuncDefNode>(it);
+            auto found = bp.index.find(std::string(f->name));
+            int fi;
+            if(found != bp.index.end()){ fi = found->second; defs[fi] = f; } // пізніше визначення перекриває (як у collect_functions)
+            else { fi = (int)bp.funcs.size(); bp.funcs.emplace_back(); defs.push_back(f); bp.index[std::string(f->name)] = fi; }
+            bp.funcs[fi].name = f->name;
+            bp.funcs[fi].nparams = f->params? (int)f->params->params.size() : 0;
+        }
+    }
+    for(size_t i=0;i<defs.size();++i){
+        FuncCompiler fc(bp, bp.funcs[i]);
+        fc.function(defs[i]);
+    }
+    return bp;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.hpp"
+#include "eval.hpp"
+
+/*
+ * Лінійний байткод для стекової VM (vm.hpp).
+ * Кожна інструкція — 8 байт: код операції + один операнд `a`
+ * (індекс константи, слот локальної змінної, адреса переходу або індекс функції).
+ * Операції типізовані за анотаціями typecheck_program: I* працюють з int64,
+ * D* — з double, тож обробник читає потрібний член Value без перевірок і перетворень.
+ */
+#define BC_OPCODES(X) \
+    X(CONST)  /* push consts[a] */                         \
+    X(LOAD)   /* push slot[a] */                           \
+    X(STORE)  /* slot[a] = top (значення лишається) */     \
+    X(POP)                                                 \
+    X(IADD) X(ISUB) X(IMUL) X(IDIV) X(IMOD) X(INEG)        \
+    X(ILT) X(IGT) X(ILE) X(IGE) X(IEQ) X(INE)              \
+    X(DADD) X(DSUB) X(DMUL) X(DDIV) X(DNEG)                \
+    X(DLT) X(DGT) X(DLE) X(DGE) X(DEQ) X(DNE)              \
+    X(NOT)                                                 \
+    X(I2D) X(D2I) X(I2B) X(D2B) /* з CastNode; bool -> int не потребує коду */ \
+    X(JMP)    /* ip = a */                                 \
+    X(JMPF)   /* pop; if false: ip = a */                  \
+    X(ANDJ)   /* top false: ip = a (false лишається); інакше pop */ \
+    X(ORJ)    /* top true:  ip = a (true лишається);  інакше pop */ \
+    X(CALL)   /* виклик funcs[a], аргументи вже на стеку */  \
+    X(TAILCALL) /* return funcs[a](...): аргументи замінюють поточний кадр */ \
+    X(RET)                                                 \
+    X(ARR1)   /* pop n; slot[a] = новий масив n */         \
+    X(ARR2)   /* pop c, r; slot[a] = новий масив r x c */  \
+    X(XLOAD1) /* i -> slot[a][i] */                        \
+    X(XLOAD2) /* i j -> slot[a][i][j] */                   \
+    X(XSTORE1) /* i v -> v; slot[a][i] = v */              \
+    X(XSTORE2) /* i j v -> v; slot[a][i][j] = v */         \
+    X(ROWS) X(COLS) /* push len(slot[a]) / len(slot[a], 1) */ \
+    X(AMARK)  /* slot[a] = кількість живих масивів (початок блоку) */ \
+    X(AFREE)  /* звільнити масиви, створені після AMARK у slot[a] */
+
+enum class BcOp : uint8_t {
+#define X(n) n,
+    BC_OPCODES(X)
+#undef X
+};
+
+struct Instr { BcOp op; int32_t a; };
+
+struct BcFunc {
+    std::string name;
+    int nparams=0;   // параметри займають слоти [0, nparams)
+    int nslots=0;    // параметри + всі локальні змінні + мітки AMARK
+    int max_stack=0; // максимальна глибина стеку операндів
+    std::vector<Instr> code;
+};
+
+struct BcProgram {
+    std::vector<BcFunc> funcs;
+    std::vector<Value> consts;
+    std::unordered_map<std::string,int> index;
+    int find(std::string_view name) const { auto it=index.find(std::string(name)); return it==index.end()? -1 : it->second; }
+};
+
+/* p має бути розв'язана resolve_program (слоти беруться з AST) і типізована typecheck_program */
+BcProgram compile_program(Program* p);
+const char* bc_op_name(BcOp op);
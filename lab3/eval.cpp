@@ -1,137 +1,501 @@
 #include "eval.hpp"
-#include <cmath>
+#include <iomanip>
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <pthread.h>
+#include <utility>
 
-void collect_functions(World& w, Program* p){
+FuncTable collect_functions(Program* p){
+    FuncTable t;
     for(auto* it : p->items){
-        if(auto* f = dynamic_cast<FuncDefNode*>(it)){
-            w.funcs[f->name] = Func{ f };
+        if(it->kind == NodeKind::FuncDef){
+            auto* f = as<FuncDefNode>(it);
+            if(f->id >= (int)t.defs.size()) t.defs.resize(f->id + 1);
+            t.defs[f->id] = f;
         }
     }
+    for(auto* f : t.defs) t.by_name[f->name] = f->id;
+    return t;
 }
 
+World::World(const FuncTable& t): table(&t), funcs(t.defs.size()){
+    stack.reserve(WORLD_STACK_SIZE);
+    for(size_t i=0;i<funcs.size();++i) funcs[i].def = t.defs[i];
+}
+
+void enable_memo(World& w, size_t entries){
+    w.memo_size = entries;
+    for(auto& fn : w.funcs){
+        size_t n = fn.def->params? fn.def->params->params.size() : 0;
+        // нативний самовиклик оминув би кеш, тож такі функції лишаються в інтерпретаторі
+        fn.memo = entries > 0 && fn.def->pure && n >= 1 && n <= MEMO_MAX_ARGS;
+        if(fn.memo) fn.jit_tried = true;
+    }
+}
+
+void print_memo_stats(std::ostream& out, const World& w){
+    out << std::left << std::setw(16) << "function" << std::right << std::setw(12) << "hits"
+        << std::setw(12) << "misses" << std::setw(12) << "evictions" << std::setw(9) << "hit%" << "\n";
+    for(auto& fn : w.funcs){
+        if(!fn.memo) continue;
+        uint64_t total = fn.memo_hits + fn.memo_misses;
+        out << std::left << std::setw(16) << fn.def->name << std::right << std::setw(12) << fn.memo_hits
+            << std::setw(12) << fn.memo_misses << std::setw(12) << fn.memo_evictions << std::setw(9)
+            << std::fixed << std::setprecision(1) << (total? 100.0 * fn.memo_hits / total : 0.0) << "\n";
+    }
+}
+
+/* Запис кешу для аргументів у args[0..n): збіг ключа — влучання */
+static MemoEntry& memo_slot(World& w, Func& fn, const Value* args, size_t n){
+    if(fn.memo_table.empty()) fn.memo_table.resize(w.memo_size);
+    uint64_t h = 0x9E3779B97F4A7C15ull;
+    for(size_t i=0;i<n;++i){ h ^= args[i].bits(); h *= 0xFF51AFD7ED558CCDull; h ^= h >> 32; }
+    return fn.memo_table[h % fn.memo_table.size()];
+}
+
+static bool memo_match(const MemoEntry& m, const Value* args, size_t n){
+    if(!m.used) return false;
+    for(size_t i=0;i<n;++i) if(m.key[i] != args[i].bits()) return false;
+    return true;
+}
+
+std::unique_ptr<Array> new_array(int64_t rows, int64_t cols, int rank){
+    if(rows < 0 || cols < 0) throw std::runtime_error("Negative array size");
+    if(cols && rows > ARRAY_MAX_ELEMS / cols) throw std::runtime_error("Array too large");
+    auto a = std::make_unique<Array>();
+    a->rows = rows; a->cols = cols; a->rank = rank;
+    a->data.resize(size_t(rows * cols));
+    return a;
+}
+
+void Array::index_error(int64_t i, int64_t j) const {
+    if(rank == 1) throw std::runtime_error("Index out of bounds: ["+std::to_string(i)+"] of "+std::to_string(rows));
+    throw std::runtime_error("Index out of bounds: ["+std::to_string(i)+"]["+std::to_string(j)+"] of "
+                             +std::to_string(rows)+"x"+std::to_string(cols));
+}
+
+void depth_error(const World& w){
+    if(w.depth < w.max_depth)
+        throw std::runtime_error("Call depth limit exceeded (C stack exhausted at depth "+std::to_string(w.depth)+")");
+    throw std::runtime_error("Call depth limit exceeded (max-depth="+std::to_string(w.max_depth)+")");
+}
+
+/* Межі стеку потоку з pthread_getattr_np (для головного потоку glibc
+   враховує RLIMIT_STACK); один раз на потік */
+const char* native_stack_limit(){
+    static thread_local const char* limit = []() -> const char* {
+        pthread_attr_t attr;
+        if(pthread_getattr_np(pthread_self(), &attr) != 0) return nullptr;
+        void* addr = nullptr; size_t size = 0;
+        int rc = pthread_attr_getstack(&attr, &addr, &size);
+        pthread_attr_destroy(&attr);
+        if(rc != 0 || size <= 2 * NATIVE_STACK_RESERVE) return nullptr;
+        return (const char*)addr + NATIVE_STACK_RESERVE;
+    }();
+    return limit;
+}
+
+/* Аргументи виклику обчислюються прямо на вершину стеку; повертає їхній початок */
+static size_t push_args(World& w, CallNode* c){
+    size_t at = w.sp, n = c->args? c->args->args.size() : 0;
+    w.ensure(at + n);
+    for(size_t i=0;i<n;++i){
+        Value v = eval_expr(w, c->args->args[i]);
+        w.stack[w.sp++] = v;
+    }
+    return at;
+}
+
+static Value run_frame(World& w, Func* fn, size_t base);
+
+static void exec_parallel_for(World& w, ForNode* fr);
+
 /* ГОЛОВНЕ: приймаємо AST* */
 void exec_node(World& w, AST* n){
     if(w.has_return) return;
+    if(w.prof && n->kind != NodeKind::Block) w.prof->stmt(n->line);
 
-    if(auto* d = dynamic_cast<DeclNode*>(n)){
-        Value init = d->init ? eval_expr(w, d->init) : Value::num(0);
-        if(!w.env.decl(d->name, init)) throw std::runtime_error("Redeclaration: "+d->name);
+    switch(n->kind){
+    case NodeKind::Decl: {
+        auto* d = as<DeclNode>(n);
+        if(d->rank){
+            int64_t rows = eval_expr(w, d->dims[0]).i(), cols = d->rank == 2? eval_expr(w, d->dims[1]).i() : 1;
+            w.arrays.push_back(new_array(rows, cols, d->rank));
+            w.slot(d->slot) = Value::array(w.arrays.back().get());
+            return;
+        }
+        w.slot(d->slot) = eval_expr(w, d->init); // typecheck_program гарантує ініціалізатор
         return;
     }
-    if(auto* es = dynamic_cast<ExprStmtNode*>(n)){ eval_expr(w, es->expr); return; }
-    if(auto* r = dynamic_cast<ReturnNode*>(n)){
-        w.return_value = r->expr? eval_expr(w, r->expr): Value::num(0);
+    case NodeKind::ExprStmt: eval_expr(w, as<ExprStmtNode>(n)->expr); return;
+    case NodeKind::Return: {
+        auto* r = as<ReturnNode>(n);
+        if(CallNode* c = tail_call(r)){
+            // return f(...): кадр звільняється до виклику, run_frame продовжить у тому ж кадрі
+            w.tail_args = push_args(w, c);
+            w.tail = &w.funcs[c->target->id];
+        } else w.return_value = eval_expr(w, r->expr);
         w.has_return = true;
         return;
     }
-    if(auto* iff = dynamic_cast<IfNode*>(n)){
-        if(eval_expr(w, iff->cond).as_bool()){
+    case NodeKind::If: {
+        auto* iff = as<IfNode>(n);
+        if(eval_expr(w, iff->cond).b()){
             exec_node(w, iff->thenN);
         } else if(iff->elseN){
             exec_node(w, iff->elseN);
         }
         return;
     }
-    if(auto* wh = dynamic_cast<WhileNode*>(n)){
-        while(!w.has_return && eval_expr(w, wh->cond).as_bool()){
+    case NodeKind::While: {
+        auto* wh = as<WhileNode>(n);
+        while(!w.has_return && eval_expr(w, wh->cond).b()){
             exec_node(w, wh->body);
+            w.cur->backedges++;
+            if(w.prof) w.prof->loop(wh->line);
         }
         return;
     }
-    if(auto* fr = dynamic_cast<ForNode*>(n)){
+    case NodeKind::For: {
+        auto* fr = as<ForNode>(n);
+        if(fr->parallel){ exec_parallel_for(w, fr); return; }
         if(fr->init) eval_expr(w, fr->init);
-        while(!w.has_return && (!fr->cond || eval_expr(w, fr->cond).as_bool())){
+        while(!w.has_return && (!fr->cond || eval_expr(w, fr->cond).b())){
             exec_node(w, fr->body);
             if(fr->step) eval_expr(w, fr->step);
+            w.cur->backedges++;
+            if(w.prof) w.prof->loop(fr->line);
         }
         return;
     }
-    if(auto* bl = dynamic_cast<BlockNode*>(n)){
-        w.env.push();
-        for(auto* s: bl->stmts){
+    case NodeKind::Block: {
+        size_t mark = w.arrays.size();
+        for(auto* s: as<BlockNode>(n)->stmts){
             exec_node(w, s);
             if(w.has_return) break;
         }
-        w.env.pop();
+        if(w.arrays.size() != mark) w.arrays.resize(mark);
         return;
     }
+    default:
+        return;
+    }
+}
+
+/* Нейтральне значення редукції й зведення двох частин (int — за модулем 2^64, як int_add) */
+static Value red_identity(const Reduction& r){
+    bool add = r.op == Op::Add;
+    return r.type == Type::Int? Value::integer(add? 0 : 1) : Value::num(add? 0.0 : 1.0);
+}
+static Value red_combine(const Reduction& r, Value a, Value b){
+    if(r.type == Type::Int) return Value::integer(r.op == Op::Add? int_add(a.i(), b.i()) : int_mul(a.i(), b.i()));
+    return Value::num(r.op == Op::Add? a.d() + b.d() : a.d() * b.d());
+}
+
+/* Потік пулу для parallel for: власний стек, масиви, JIT і кеш над тим самим FuncTable */
+static World& helper(World& w, unsigned t){
+    while(w.helpers.size() <= t){
+        auto h = std::make_unique<World>(*w.table);
+        h->jit_mode = w.jit_mode;
+        h->max_depth = w.max_depth;
+        h->helper = true;
+        enable_memo(*h, w.memo_size);
+        w.helpers.push_back(std::move(h));
+    }
+    return *w.helpers[t];
 }
 
-static Value apply_bin(const std::string& op, const Value& A, const Value& B){
-    if(op=="+") return Value::num(A.as_num()+B.as_num());
-    if(op=="-") return Value::num(A.as_num()-B.as_num());
-    if(op=="*") return Value::num(A.as_num()*B.as_num());
-    if(op=="/") return Value::num(A.as_num()/B.as_num());
-    if(op=="%") return Value::num(std::fmod(A.as_num(),B.as_num()));
-    if(op=="<") return Value::boolean(A.as_num()<B.as_num());
-    if(op==">") return Value::boolean(A.as_num()>B.as_num());
-    if(op=="<=") return Value::boolean(A.as_num()<=B.as_num());
-    if(op==">=") return Value::boolean(A.as_num()>=B.as_num());
-    if(op=="==") return Value::boolean(A.as_num()==B.as_num());
-    if(op=="!=") return Value::boolean(A.as_num()!=B.as_num());
-    if(op=="&&") return Value::boolean(A.as_bool() && B.as_bool());
-    if(op=="||") return Value::boolean(A.as_bool() || B.as_bool());
-    throw std::runtime_error("Unknown binop: "+op);
+/*
+ * parallel for: ітерації [0, count) діляться на min(count, PAR_CHUNKS) частин.
+ * Частина виконується в кадрі-копії поточного (зовнішні змінні лише читаються —
+ * typecheck_program), редукційні змінні в ній стартують з нейтрального значення,
+ * а наприкінці кожна частина віддає свої значення. Після всіх частин вони
+ * зводяться до початкових у порядку номерів — результат не залежить ні від
+ * кількості потоків, ні від того, хто яку частину вкрав. Масиви спільні:
+ * різні ітерації мають писати різні елементи. Помилка в ітерації зупиняє
+ * роздачу частин і кидається з викликача (з найменшої частини серед тих, що впали).
+ * Під --profile і у вкладеному parallel for частини виконуються тут же по черзі.
+ */
+static void exec_parallel_for(World& w, ForNode* fr){
+    ParLoop l;
+    par_loop(fr, l); // форму гарантує typecheck_program
+    int64_t lo = eval_expr(w, l.init->rhs).i(), hi = eval_expr(w, l.hi).i();
+    uint64_t count = par_trip_count(l, lo, hi);
+    size_t chunks = (size_t)std::min<uint64_t>(count, PAR_CHUNKS);
+    const auto& reds = fr->reductions;
+    size_t nr = reds.size();
+    int iv = l.init->slot;
+    std::vector<Value> part(chunks * nr);
+
+    auto run_chunk = [&](World& x, size_t k){
+        // перші count % chunks частин на ітерацію довші
+        uint64_t q = count / chunks, rem = count % chunks;
+        uint64_t b = k * q + std::min<uint64_t>(k, rem), e = b + q + (k < rem);
+        for(size_t r=0;r<nr;++r) x.slot(reds[r].slot) = red_identity(reds[r]);
+        for(uint64_t t=b;t<e;++t){
+            x.slot(iv) = Value::integer(int_add(lo, int_mul((int64_t)t, l.step)));
+            exec_node(x, fr->body);
+            x.cur->backedges++;
+            if(x.prof) x.prof->loop(fr->line);
+        }
+        for(size_t r=0;r<nr;++r) part[k*nr + r] = x.slot(reds[r].slot);
+    };
+
+    std::vector<Value> start(nr);
+    for(size_t r=0;r<nr;++r) start[r] = w.slot(reds[r].slot);
+    if(!w.pool && !w.helper && !w.prof && w.threads != 1 && chunks > 1) w.pool = std::make_unique<WorkPool>(w.threads);
+    if(w.helper || w.prof || !w.pool || w.pool->size() == 1){
+        for(size_t k=0;k<chunks;++k) run_chunk(w, k);
+    } else {
+        unsigned n = w.pool->size();
+        for(unsigned t=0;t<n;++t) helper(w, t);
+        size_t nslots = (size_t)w.cur->def->nslots;
+        std::vector<char> ready(n, 0);
+        std::mutex err_m;
+        size_t err_chunk = SIZE_MAX;
+        std::exception_ptr err;
+        std::atomic<bool> failed{false};
+        w.pool->run(chunks, [&](size_t k, unsigned t){
+            if(failed.load(std::memory_order_relaxed)) return;
+            World& h = *w.helpers[t];
+            if(!ready[t]){
+                // кадр-копія: ті самі слоти, що бачить тіло циклу в w
+                h.ensure(nslots);
+                std::copy(w.stack.begin() + w.fp, w.stack.begin() + w.fp + nslots, h.stack.begin());
+                h.fp = 0; h.sp = nslots;
+                h.cur = &h.funcs[w.cur->def->id];
+                h.depth = w.depth;
+                h.stack_limit = native_stack_limit(); // потік t пулу виконує лише helper t
+                ready[t] = 1;
+            }
+            size_t mark = h.arrays.size();
+            try {
+                run_chunk(h, k);
+            } catch(...) {
+                h.fp = 0; h.sp = nslots; h.depth = w.depth; h.cur = &h.funcs[w.cur->def->id];
+                h.arrays.resize(mark);
+                h.has_return = false; h.tail = nullptr;
+                std::lock_guard<std::mutex> lk(err_m);
+                if(k < err_chunk){ err_chunk = k; err = std::current_exception(); }
+                failed = true;
+            }
+        });
+        if(err) std::rethrow_exception(err);
+    }
+    for(size_t r=0;r<nr;++r){
+        Value acc = start[r];
+        for(size_t k=0;k<chunks;++k) acc = red_combine(reds[r], acc, part[k*nr + r]);
+        w.slot(reds[r].slot) = acc;
+    }
+    // як після послідовного циклу: перше значення, що не проходить умову
+    w.slot(iv) = Value::integer(int_add(lo, int_mul((int64_t)count, l.step)));
 }
 
-static Value apply_un(const std::string& op, const Value& X){
-    if(op=="!") return Value::boolean(!X.as_bool());
-    if(op=="neg") return Value::num(-X.as_num());
-    throw std::runtime_error("Unknown unop: "+op);
+/* Операнди вже однакового типу (CastNode з typecheck_program) — окремі шляхи
+   для int і double без жодних перетворень */
+static Value apply_int(Op op, int64_t a, int64_t b){
+    switch(op){
+    case Op::Add: return Value::integer(int_add(a,b));
+    case Op::Sub: return Value::integer(int_sub(a,b));
+    case Op::Mul: return Value::integer(int_mul(a,b));
+    case Op::Div:
+        if(b == 0) throw std::runtime_error("Division by zero");
+        return Value::integer(int_div(a,b));
+    case Op::Mod:
+        if(b == 0) throw std::runtime_error("Division by zero");
+        return Value::integer(int_mod(a,b));
+    case Op::Lt: return Value::boolean(a<b);
+    case Op::Gt: return Value::boolean(a>b);
+    case Op::Le: return Value::boolean(a<=b);
+    case Op::Ge: return Value::boolean(a>=b);
+    case Op::Eq: return Value::boolean(a==b);
+    case Op::Ne: return Value::boolean(a!=b);
+    default: break;
+    }
+    throw std::runtime_error(std::string("Unknown binop: ")+op_str(op));
+}
+
+static Value apply_double(Op op, double a, double b){
+    switch(op){
+    case Op::Add: return Value::num(a+b);
+    case Op::Sub: return Value::num(a-b);
+    case Op::Mul: return Value::num(a*b);
+    case Op::Div: return Value::num(a/b);
+    case Op::Lt: return Value::boolean(a<b);
+    case Op::Gt: return Value::boolean(a>b);
+    case Op::Le: return Value::boolean(a<=b);
+    case Op::Ge: return Value::boolean(a>=b);
+    case Op::Eq: return Value::boolean(a==b);
+    case Op::Ne: return Value::boolean(a!=b);
+    default: break;
+    }
+    throw std::runtime_error(std::string("Unknown binop: ")+op_str(op));
+}
+
+/* bool уже лежить як int 0/1, тож bool -> int — те саме значення */
+static Value apply_cast(Type to, Type from, const Value& x){
+    switch(to){
+    case Type::Bool: return Value::boolean(from == Type::Double? x.d() != 0 : x.i() != 0);
+    case Type::Int: return from == Type::Double? Value::integer(d2i(x.d())) : x;
+    case Type::Double: return from == Type::Double? x : Value::num((double)x.i());
+    default: break;
+    }
+    throw std::runtime_error("Unknown cast");
+}
+
+/* Індекси обчислюються зліва направо; межі перевіряє Array::at */
+static Value& element(World& w, IndexNode* x){
+    int64_t i = eval_expr(w, x->i).i(), j = x->j? eval_expr(w, x->j).i() : 0;
+    return w.slot(x->slot).a()->at(i, j);
 }
 
 Value eval_expr(World& w, ExprNode* e){
-    if(auto* a = dynamic_cast<AssignNode*>(e)){
-        Value v = eval_expr(w, a->rhs);
-        if(!w.env.set(a->name, v)) throw std::runtime_error("Undeclared: "+a->name);
-        return v;
-    }
-    if(auto* b = dynamic_cast<BinOpNode*>(e)){
-        auto L = eval_expr(w, b->a);
-        if(b->op=="&&"){
-            if(!L.as_bool()) return Value::boolean(false);
-            return Value::boolean(eval_expr(w,b->b).as_bool());
+    switch(e->kind){
+    case NodeKind::Assign: {
+        auto* a = as<AssignNode>(e);
+        return w.slot(a->slot) = eval_expr(w, a->rhs);
+    }
+    case NodeKind::BinOp: {
+        auto* b = as<BinOpNode>(e);
+        if(b->op==Op::And) return Value::boolean(eval_expr(w,b->a).b() && eval_expr(w,b->b).b());
+        if(b->op==Op::Or) return Value::boolean(eval_expr(w,b->a).b() || eval_expr(w,b->b).b());
+        Value L = eval_expr(w, b->a);
+        Value R = eval_expr(w, b->b);
+        return b->a->type == Type::Double? apply_double(b->op, L.d(), R.d()) : apply_int(b->op, L.i(), R.i());
+    }
+    case NodeKind::UnaryOp: {
+        auto* u = as<UnaryOpNode>(e);
+        Value x = eval_expr(w, u->x);
+        if(u->op==Op::Not) return Value::boolean(!x.b());
+        return u->type == Type::Double? Value::num(-x.d()) : Value::integer(int_neg(x.i()));
+    }
+    case NodeKind::Cast: {
+        auto* c = as<CastNode>(e);
+        return apply_cast(c->type, c->x->type, eval_expr(w, c->x));
+    }
+    case NodeKind::Number: {
+        auto* num = as<NumberNode>(e);
+        return num->type == Type::Int? Value::integer(num->i) : Value::num(num->v);
+    }
+    case NodeKind::Bool: return Value::boolean(as<BoolNode>(e)->v);
+    case NodeKind::VarRef: return w.slot(as<VarRefNode>(e)->slot);
+    case NodeKind::Call: {
+        auto* c = as<CallNode>(e);
+        size_t base = push_args(w, c);
+        return run_frame(w, &w.funcs[c->target->id], base);
+    }
+    case NodeKind::Index: return element(w, as<IndexNode>(e));
+    case NodeKind::IndexAssign: {
+        auto* a = as<IndexAssignNode>(e);
+        Value& el = element(w, a->at); // дані масиву не переміщуються, тож посилання переживе rhs
+        return el = eval_expr(w, a->rhs);
+    }
+    case NodeKind::Len: {
+        auto* l = as<LenNode>(e);
+        Array* a = w.slot(l->slot).a();
+        return Value::integer(l->dim? a->cols : a->rows);
+    }
+    default:
+        throw std::runtime_error("Unknown expr node");
+    }
+}
+
+/* Виконує fn з аргументами в stack[base..]; хвостові виклики повторюють
+   цикл у тому ж кадрі, тож глибина не росте. Після виходу вершина стеку
+   повертається до base. При винятку стан відновлює call_func. */
+static Value run_frame(World& w, Func* fn, size_t base){
+    if(w.depth >= w.max_depth || (const char*)__builtin_frame_address(0) < w.stack_limit) depth_error(w);
+    w.depth++;
+    size_t prev_fp = w.fp; Func* prev_cur = w.cur;
+    if(w.prof) w.prof->enter(fn);
+    Value ret;
+    // мемоізація: ключ — аргументи першої функції, хвостові виклики лише продовжують її
+    MemoEntry* memo = nullptr; uint64_t key[MEMO_MAX_ARGS] = {};
+    if(fn->memo){
+        size_t n = fn->def->params->params.size();
+        MemoEntry& m = memo_slot(w, *fn, &w.stack[base], n);
+        if(memo_match(m, &w.stack[base], n)){
+            fn->memo_hits++;
+            if(w.prof) w.prof->leave();
+            w.sp = base; w.depth--;
+            return m.v;
         }
-        if(b->op=="||"){
-            if(L.as_bool()) return Value::boolean(true);
-            return Value::boolean(eval_expr(w,b->b).as_bool());
+        fn->memo_misses++;
+        for(size_t i=0;i<n;++i) key[i] = w.stack[base+i].bits();
+        memo = &m;
+    }
+    Func* first = fn;
+    for(;;){
+        FuncDefNode* f = fn->def;
+        size_t n = f->params? f->params->params.size() : 0;
+
+        // другий рівень: гаряча функція виконується як машинний код
+        if(!fn->native && !fn->jit_tried && w.jit_mode != JitMode::Off){
+            fn->calls++;
+            if(w.jit_mode == JitMode::All || fn->calls >= JIT_HOT_CALLS || fn->backedges >= JIT_HOT_BACKEDGES){
+                fn->jit_tried = true;
+                jit_compile(w, *fn);
+            }
         }
-        auto R = eval_expr(w, b->b);
-        return apply_bin(b->op, L, R);
-    }
-    if(auto* u = dynamic_cast<UnaryOpNode*>(e)) return apply_un(u->op, eval_expr(w,u->x));
-    if(auto* n = dynamic_cast<NumberNode*>(e)) return Value::num(n->v);
-    if(auto* b = dynamic_cast<BoolNode*>(e)) return Value::boolean(b->v);
-    if(auto* v = dynamic_cast<VarRefNode*>(e)){
-        auto got = w.env.get(v->name);
-        if(!got) throw std::runtime_error("Undeclared: "+v->name);
-        return *got;
-    }
-    if(auto* c = dynamic_cast<CallNode*>(e)){
-        std::vector<Value> args;
-        if(c->args){
-            for(auto* ex: c->args->args) args.push_back(eval_expr(w, ex));
+        if(fn->native){
+            uint64_t r = fn->native(&w, &w.stack[base]);
+            if(w.jit_error){
+                w.jit_error = false;
+                std::rethrow_exception(std::exchange(w.jit_exc, nullptr));
+            }
+            ret = Value::from_bits(r);
+        } else {
+            w.ensure(base + f->nslots);
+            w.fp = base; w.sp = base + f->nslots;
+            std::fill(w.stack.begin() + base + n, w.stack.begin() + w.sp, Value());
+            w.cur = fn;
+            exec_node(w, f->body);
+            ret = w.has_return? w.return_value : Value::zero(f->ret);
+            w.has_return = false;
         }
-        return call_func(w, c->name, args);
-    }
-    throw std::runtime_error("Unknown expr node");
-}
-
-Value call_func(World& w, const std::string& name, const std::vector<Value>& args){
-    auto it = w.funcs.find(name);
-    if(it==w.funcs.end()) throw std::runtime_error("Unknown function: "+name);
-    FuncDefNode* f = it->second.def;
-    size_t n = f->params? f->params->params.size() : 0;
-    if(n != args.size()) throw std::runtime_error("Arity mismatch in "+name);
-    w.env.push();
-    for(size_t i=0;i<n;++i){ w.env.decl(f->params->params[i]->name, args[i]); }
-    bool prev_ret = w.has_return; Value prev_val = w.return_value; w.has_return=false;
-    exec_node(w, f->body);
-    Value ret = w.return_value; bool had = w.has_return;
-    w.has_return = prev_ret; w.return_value = prev_val;
-    w.env.pop();
-    if(had) return ret;
-    return Value::num(0);
+        if(!w.tail) break;
+        fn = std::exchange(w.tail, nullptr);
+        if(w.prof){ w.prof->leave(); w.prof->enter(fn); }
+        size_t m = fn->def->params? fn->def->params->params.size() : 0;
+        std::memmove(&w.stack[base], &w.stack[w.tail_args], m * sizeof(Value));
+        w.sp = base + m;
+    }
+    if(w.prof) w.prof->leave();
+    w.fp = prev_fp; w.cur = prev_cur; w.sp = base;
+    w.depth--;
+    if(memo){
+        if(memo->used) first->memo_evictions++;
+        std::memcpy(memo->key, key, sizeof key);
+        memo->v = ret; memo->used = true;
+    }
+    return ret;
+}
+
+Value call_func(World& w, Func& fn, const Value* args){
+    size_t fp = w.fp, sp = w.sp, arrays = w.arrays.size(); uint32_t depth = w.depth; Func* cur = w.cur;
+    w.stack_limit = native_stack_limit();
+    size_t n = fn.def->params? fn.def->params->params.size() : 0;
+    w.ensure(sp + n);
+    std::copy(args, args + n, w.stack.begin() + sp);
+    w.sp = sp + n;
+    try {
+        return run_frame(w, &fn, sp);
+    } catch(...) {
+        w.fp = fp; w.sp = sp; w.depth = depth; w.cur = cur;
+        w.arrays.resize(arrays);
+        w.has_return = false; w.tail = nullptr;
+        throw;
+    }
+}
+
+Value call_func(World& w, Name name, const std::vector<Value>& args){
+    Func* fn = w.find(name);
+    if(!fn) throw std::runtime_error("Unknown function: "+std::string(name));
+    size_t n = fn->def->params? fn->def->params->params.size() : 0;
+    if(n != args.size()) throw std::runtime_error("Arity mismatch in "+std::string(name));
+    return call_func(w, *fn, args.data());
 }
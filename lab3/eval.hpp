@@ -2,50 +2,174 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
-#include <optional>
 #include <stdexcept>
-#include <variant>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iosfwd>
+#include <memory>
 #include "ast.hpp"
+#include "jit.hpp"
+#include "profile.hpp"
+#include "work_pool.hpp"
+
+/*
+ * 8-байтове значення без тегу: який член дійсний, визначає статичний тип
+ * виразу чи слоту (typecheck_program). bool зберігається як int64 0/1,
+ * тож усі 8 байтів завжди визначені і їх можна копіювати як сирі біти
+ * (стек VM, аргументи native-функцій JIT). Нуль будь-якого типу — усі біти 0.
+ */
+struct Array;
 
 struct Value {
-    std::variant<double,bool> v;
-    static Value num(double x){ return Value{ x }; }
-    static Value boolean(bool b){ return Value{ b }; }
-    explicit Value(double x): v(x){}
-    explicit Value(bool b): v(b){}
-    Value() : v(0.0){}
-    double as_num() const { if(auto p=std::get_if<double>(&v)) return *p; if(auto q=std::get_if<bool>(&v)) return *q?1.0:0.0; return 0.0; }
-    bool as_bool() const { if(auto p=std::get_if<bool>(&v)) return *p; if(auto q=std::get_if<double>(&v)) return *q!=0.0; return false; }
+    union { int64_t iv; double dv; Array* av; };
+    Value(): iv(0){}
+    static Value integer(int64_t x){ Value r; r.iv = x; return r; }
+    static Value num(double x){ Value r; r.dv = x; return r; }
+    static Value boolean(bool x){ Value r; r.iv = x; return r; }
+    static Value zero(Type){ return Value(); }
+    static Value array(Array* a){ Value r; r.av = a; return r; }
+    static Value from_bits(uint64_t x){ Value r; std::memcpy(&r.iv, &x, 8); return r; }
+    int64_t i() const { return iv; }
+    double d() const { return dv; }
+    bool b() const { return iv != 0; }
+    Array* a() const { return av; }
+    uint64_t bits() const { uint64_t x; std::memcpy(&x, &iv, 8); return x; }
 };
+static_assert(sizeof(Value) == 8, "Value must stay 8 bytes");
 
-struct Env {
-    std::vector<std::unordered_map<std::string,Value>> scopes;
-    Env(){ scopes.emplace_back(); }
-    void push(){ scopes.emplace_back(); }
-    void pop(){ scopes.pop_back(); }
-    bool decl(const std::string& name, const Value& v){ return scopes.back().emplace(name,v).second; }
-    bool set(const std::string& name, const Value& v){
-        for(auto it=scopes.rbegin(); it!=scopes.rend(); ++it){
-            auto f=it->find(name); if(f!=it->end()){ f->second=v; return true; }
-        } return false;
-    }
-    std::optional<Value> get(const std::string& name){
-        for(auto it=scopes.rbegin(); it!=scopes.rend(); ++it){
-            auto f=it->find(name); if(f!=it->end()) return f->second;
-        } return std::nullopt;
+/* Масив мови: rows x cols значень підряд, рядок за рядком, без тегів і
+   окремих об'єктів на елемент; одновимірний має cols == 1. Слот змінної
+   тримає лише вказівник (Value::av), тож масив передається за посиланням.
+   Власник — той, хто виконує оголошення (World::arrays, стек масивів VM). */
+constexpr int64_t ARRAY_MAX_ELEMS = int64_t(1) << 28;
+
+struct Array {
+    int64_t rows=0, cols=1; int rank=1;
+    std::vector<Value> data;
+    Value& at(int64_t i, int64_t j){
+        if((uint64_t)i >= (uint64_t)rows || (uint64_t)j >= (uint64_t)cols) index_error(i, j);
+        return data[size_t(i*cols + j)];
     }
+    [[noreturn]] void index_error(int64_t i, int64_t j) const;
 };
 
-struct Func { FuncDefNode* def{}; };
+/* Новий масив із нулів; кидає на від'ємний чи завеликий розмір */
+std::unique_ptr<Array> new_array(int64_t rows, int64_t cols, int rank);
+
+/*
+ * Цілочисельна арифметика, спільна для інтерпретатора, VM, згортки констант і JIT:
+ * переповнення — за модулем 2^64 (як у машинних add/imul), INT64_MIN / -1 == INT64_MIN,
+ * ділення на нуль перевіряє виконавець.
+ */
+inline int64_t int_add(int64_t a, int64_t b){ return (int64_t)((uint64_t)a + (uint64_t)b); }
+inline int64_t int_sub(int64_t a, int64_t b){ return (int64_t)((uint64_t)a - (uint64_t)b); }
+inline int64_t int_mul(int64_t a, int64_t b){ return (int64_t)((uint64_t)a * (uint64_t)b); }
+inline int64_t int_neg(int64_t a){ return (int64_t)(0 - (uint64_t)a); }
+inline int64_t int_div(int64_t a, int64_t b){ return b == -1? int_neg(a) : a / b; }
+inline int64_t int_mod(int64_t a, int64_t b){ return b == -1? 0 : a % b; }
+/* double -> int з відкиданням дробу; NaN і поза діапазоном -> INT64_MIN, як cvttsd2si */
+inline int64_t d2i(double x){ return (x >= -9223372036854775808.0 && x < 9223372036854775808.0)? (int64_t)x : INT64_MIN; }
+
+/* Мемоізація чистих функцій (--memoize): кеш прямого відображення на
+   memo_size записів, ключ — сирі біти аргументів. При колізії запис
+   перезаписується, тож пам'ять обмежена і пошук не алокує. */
+constexpr size_t MEMO_MAX_ARGS = 4;
+constexpr size_t MEMO_DEFAULT_SIZE = 1u << 12;
+
+struct MemoEntry {
+    uint64_t key[MEMO_MAX_ARGS];
+    Value v;
+    bool used=false;
+};
 
+/* Лічильники calls/backedges вирішують, коли компілювати функцію в native (jit.hpp) */
+struct Func {
+    FuncDefNode* def{};
+    uint32_t calls=0, backedges=0;
+    JitFn native=nullptr;
+    bool jit_tried=false;
+    bool native_tail=false; // native-код може залишити відкладений хвостовий виклик у World
+    bool memo=false;        // чиста, 1..MEMO_MAX_ARGS параметрів і --memoize
+    std::vector<MemoEntry> memo_table; // виділяється при першому виклику
+    uint64_t memo_hits=0, memo_misses=0, memo_evictions=0;
+};
+
+/* Змінні адресуються слотами з resolve_program: кадр виклику — це
+   nslots значень підряд у спільному стеку, без хешування та алокацій на блок.
+   Стек резервується один раз: аргументи обчислюються одразу на його вершину
+   і стають першими слотами кадру викликаної функції. */
+constexpr size_t WORLD_STACK_SIZE = 1u << 20;
+/* Типова межа глибини викликів. Скільки рівнів справді вміщає стек C,
+   залежить від потоку й від вкладеності виразів у кадрі (дерев'яний
+   інтерпретатор витрачає сотні байтів на кожен рівень), тож окремо діє
+   World::stack_limit */
+constexpr uint32_t DEFAULT_MAX_DEPTH = 10000;
+/* Запас стеку C, якого не займає рекурсія інтерпретатора й native-коду:
+   depth_error, обробка винятку і вкладені вирази поточного кадру */
+constexpr size_t NATIVE_STACK_RESERVE = 256u << 10;
+/* Нижня межа, нижче якої рекурсія в поточному потоці не заходить:
+   початок стеку потоку + NATIVE_STACK_RESERVE; nullptr — розмір невідомий */
+const char* native_stack_limit();
+
+/* Незмінний опис функцій програми (collect_functions): визначення за
+   FuncDefNode::id і пошук за іменем. Не змінюється під час виконання, тож
+   один FuncTable ділять усі World, що виконують ту саму програму */
+struct FuncTable {
+    std::vector<FuncDefNode*> defs; // індекс — FuncDefNode::id
+    std::unordered_map<Name,int> by_name; // останнє визначення перемагає
+    int find(Name name) const { auto it = by_name.find(name); return it == by_name.end()? -1 : it->second; }
+};
+
+/* Стан одного виконавця: стек кадрів, масиви, лічильники JIT і native-код,
+   кеш мемоізації. World належить одному потоку; AST і FuncTable лише читає */
 struct World {
-    Env env;
-    std::unordered_map<std::string,Func> funcs;
+    const FuncTable* table;
+    std::vector<Value> stack;
+    size_t fp=0; // початок поточного кадру
+    size_t sp=0; // перша вільна комірка стеку
+    std::vector<Func> funcs; // індекс — FuncDefNode::id, CallNode::target вказує сюди
     bool has_return=false; Value return_value;
+    Func* tail=nullptr; size_t tail_args=0; // відкладений хвостовий виклик (return f(...))
+    std::vector<std::unique_ptr<Array>> arrays; // живі масиви; блок звільняє оголошені в ньому при виході
+    uint32_t depth=0, max_depth=DEFAULT_MAX_DEPTH;
+    /* native_stack_limit потоку, що зараз виконує World (ставить call_func):
+       нижче цієї адреси кадр run_frame чи native-самовиклик дає depth_error */
+    const char* stack_limit=nullptr;
+    size_t memo_size=0; // записів кешу на функцію, 0 — мемоізацію вимкнено
+    Profiler* prof=nullptr; // --profile; native-код не профілюється, тож JIT тоді вимкнено
+    Func* cur=nullptr; // функція, що виконується (для лічильника циклів)
+    JitMode jit_mode=JitMode::Hot;
+    bool jit_error=false; std::exception_ptr jit_exc; // виняток, що пройшов крізь native-код
+    std::vector<ExecBuffer> jit_code;
+    /* parallel for: потоки пулу (0 — за кількістю ядер) і їхні World, створюються
+       при першому такому циклі. У World потоку пулу (helper) вкладені parallel for
+       виконуються послідовно тими самими частинами */
+    unsigned threads=0;
+    bool helper=false;
+    std::vector<std::unique_ptr<World>> helpers;
+    std::unique_ptr<WorkPool> pool; // руйнується раніше за helpers
+    explicit World(const FuncTable& t);
+    Value& slot(int i){ return stack[fp+i]; }
+    /* стек до n комірок; місткість зарезервована наперед, тож адреси не змінюються */
+    void ensure(size_t n){
+        if(n <= stack.size()) return;
+        if(n > WORLD_STACK_SIZE) throw std::runtime_error("Stack overflow");
+        stack.resize(n);
+    }
+    Func* find(Name name){ int id = table->find(name); return id < 0? nullptr : &funcs[id]; }
 };
 
-/* ОГОЛОШЕННЯ — тепер приймаємо AST* */
-void collect_functions(World& w, Program* p);
+/* ОГОЛОШЕННЯ — тепер приймаємо AST*; програма має бути розв'язана (resolve_program)
+   і типізована (typecheck_program) */
+FuncTable collect_functions(Program* p);
+/* Вмикає кеш для чистих функцій (analyze_purity); викликати після collect_functions */
+void enable_memo(World& w, size_t entries);
+void print_memo_stats(std::ostream& out, const World& w);
 void exec_node(World& w, AST* n);
 Value eval_expr(World& w, ExprNode* e);
-Value call_func(World& w, const std::string& name, const std::vector<Value>& args);
+Value call_func(World& w, Name name, const std::vector<Value>& args);
+/* Виклик з native-коду: n аргументів копіюються на вершину стеку World */
+Value call_func(World& w, Func& fn, const Value* args);
+/* Помилка перевищення max_depth чи stack_limit (спільна для інтерпретатора та JIT) */
+[[noreturn]] void depth_error(const World& w);
@@ -0,0 +1,166 @@
+#include "fast_lexer.hpp"
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+/*
+ * SWAR: вісім байтів в одному uint64_t (little-endian), результат — маска
+ * зі старшим бітом кожного байта, що підходить. Порівняння точні, без
+ * перенесень між байтами; байти з установленим старшим бітом (UTF-8)
+ * ніколи не належать до пробілів чи ідентифікаторів, як і в lexer.l.
+ */
+constexpr uint64_t ONES = 0x0101010101010101ull, HIGH = 0x8080808080808080ull;
+
+inline uint64_t load8(const char* p){ uint64_t x; std::memcpy(&x, p, 8); return x; }
+/* байт == c */
+inline uint64_t eq(uint64_t x, unsigned char c){
+    uint64_t t = x ^ (ONES * c);
+    return ~(((t & ~HIGH) + ~HIGH) | t) & HIGH;
+}
+/* байт >= c; x7 — байти без старшого біта, 1 <= c <= 0x80 */
+inline uint64_t ge(uint64_t x7, unsigned c){ return (x7 + ONES * (0x80 - c)) & HIGH; }
+inline uint64_t in_range(uint64_t x7, unsigned lo, unsigned hi){ return ge(x7, lo) & ~ge(x7, hi + 1); }
+
+/* [A-Za-z0-9_] */
+inline uint64_t ident_mask(uint64_t x){
+    uint64_t x7 = x & ~HIGH, lower = x7 | (ONES * 0x20);
+    return (in_range(x7, '0', '9') | in_range(lower, 'a', 'z') | eq(x7, '_')) & ~x & HIGH;
+}
+/* [ \t\n\v\f\r] */
+inline uint64_t space_mask(uint64_t x){
+    uint64_t x7 = x & ~HIGH;
+    return (eq(x7, ' ') | in_range(x7, '\t', '\r')) & ~x & HIGH;
+}
+inline int first(uint64_t m){ return __builtin_ctzll(m) >> 3; }
+/* рядки серед перших k байтів */
+inline int lines_before(uint64_t x, int k){ return k? __builtin_popcountll(eq(x, '\n') << (64 - 8*k)) : 0; }
+
+inline bool is_digit(char c){ return unsigned(c - '0') < 10; }
+inline bool is_alpha(char c){ return unsigned((c | 0x20) - 'a') < 26 || c == '_'; }
+inline bool is_ident(char c){ return is_alpha(c) || is_digit(c); }
+inline bool is_space(char c){ return c == ' ' || unsigned(c - '\t') < 5; }
+
+const char* skip_space(const char* p, const char* end, int& line){
+    for(; end - p >= 8; p += 8){
+        uint64_t x = load8(p), stop = ~space_mask(x) & HIGH;
+        if(stop){ int k = first(stop); line += lines_before(x, k); return p + k; }
+        line += lines_before(x, 8);
+    }
+    for(; p < end && is_space(*p); ++p) if(*p == '\n') line++;
+    return p;
+}
+
+const char* skip_ident(const char* p, const char* end){
+    for(; end - p >= 8; p += 8){
+        uint64_t stop = ~ident_mask(load8(p)) & HIGH;
+        if(stop) return p + first(stop);
+    }
+    while(p < end && is_ident(*p)) ++p;
+    return p;
+}
+
+/* Перше входження c (або end); рядки до нього додаються до line */
+const char* find(const char* p, const char* end, char c, int& line){
+    for(; end - p >= 8; p += 8){
+        uint64_t x = load8(p), hit = eq(x, (unsigned char)c);
+        if(hit){ int k = first(hit); line += lines_before(x, k); return p + k; }
+        line += lines_before(x, 8);
+    }
+    for(; p < end && *p != c; ++p) if(*p == '\n') line++;
+    return p;
+}
+
+const char* digits(const char* p, const char* end){ while(p < end && is_digit(*p)) ++p; return p; }
+
+int keyword(const char* s, size_t n, YYSTYPE* lval){
+    auto is = [&](const char* k){ return std::memcmp(s, k, n) == 0; };
+    switch(n){
+    case 2: if(is("if")) return T_IF; break;
+    case 3: if(is("int")) return T_INT; if(is("for")) return T_FOR; if(is("len")) return T_LEN; break;
+    case 4:
+        if(is("bool")) return T_BOOL;
+        if(is("else")) return T_ELSE;
+        if(is("true")){ lval->ival = 1; return T_TRUE; }
+        break;
+    case 5:
+        if(is("while")) return T_WHILE;
+        if(is("false")){ lval->ival = 0; return T_FALSE; }
+        break;
+    case 6: if(is("double")) return T_DOUBLE; if(is("return")) return T_RETURN; break;
+    case 8: if(is("parallel")) return T_PARALLEL; break;
+    case 9: if(is("reduction")) return T_REDUCTION; break;
+    }
+    return 0;
+}
+
+/* Число за правилами lexer.l: D+ — int; D+.D*, D*.D+, D+e±D+ (з експонентою чи без) — double */
+int number(FastLexer& L, YYSTYPE* lval){
+    const char* s = L.p, *end = L.end;
+    const char* q = digits(s, end);
+    bool dbl = false;
+    if(q < end && *q == '.' && (q > s || (q + 1 < end && is_digit(q[1])))){ q = digits(q + 1, end); dbl = true; }
+    if(q < end && (*q | 0x20) == 'e'){
+        const char* r = q + 1;
+        if(r < end && (*r == '+' || *r == '-')) ++r;
+        if(r < end && is_digit(*r)){ q = digits(r, end); dbl = true; }
+    }
+    L.p = q;
+    if(!dbl){
+        long long v;
+        // як strtoll у lexer.l: переповнення дає LLONG_MAX
+        if(std::from_chars(s, q, v).ec != std::errc()) v = LLONG_MAX;
+        lval->lval = v;
+        return T_NUMBER_I;
+    }
+    double d;
+    // переповнення/зникнення порядку: from_chars не пише значення, atof дає inf або 0
+    if(std::from_chars(s, q, d).ec != std::errc()) d = std::atof(std::string(s, q).c_str());
+    lval->dval = d;
+    return T_NUMBER_D;
+}
+
+} // namespace
+
+int fast_lex(FastLexer& L, YYSTYPE* lval, YYLTYPE* lloc){
+    const char* end = L.end;
+    for(;;){
+        const char* p = L.p = skip_space(L.p, end, L.line);
+        if(p == end) return 0;
+        lloc->first_line = lloc->last_line = L.line;
+        char c = *p;
+        if(c == '/' && p + 1 < end){
+            if(p[1] == '/'){ L.p = find(p + 2, end, '\n', L.line); continue; }
+            if(p[1] == '*'){
+                // незакритий коментар lexer.l не розпізнає — тоді це просто '/'
+                int line = L.line;
+                for(const char* q = p + 2; (q = find(q, end, '*', line)) != end; ++q)
+                    if(q + 1 < end && q[1] == '/'){ L.p = q + 2; L.line = line; break; }
+                if(L.p != p) continue;
+            }
+        }
+        if(is_alpha(c)){
+            const char* q = skip_ident(p + 1, end);
+            L.p = q;
+            if(int kw = keyword(p, size_t(q - p), lval)) return kw;
+            lval->sval = L.prog->names.intern(std::string_view(p, size_t(q - p))).data();
+            return T_IDENT;
+        }
+        if(is_digit(c) || (c == '.' && p + 1 < end && is_digit(p[1]))) return number(L, lval);
+        L.p = p + 1;
+        char n = p + 1 < end? p[1] : 0;
+        switch(c){
+        case '=': if(n == '='){ L.p++; return T_EQ; } break;
+        case '!': if(n == '='){ L.p++; return T_NE; } break;
+        case '<': if(n == '='){ L.p++; return T_LE; } break;
+        case '>': if(n == '='){ L.p++; return T_GE; } break;
+        case '&': if(n == '&'){ L.p++; return T_AND; } break;
+        case '|': if(n == '|'){ L.p++; return T_OR; } break;
+        }
+        return c; // як yytext[0] у lexer.l
+    }
+}
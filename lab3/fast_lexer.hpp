@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include "parser.tab.h"
+
+/*
+ * Ручний лексер (--lexer=fast) над буфером у пам'яті, зазвичай MappedFile.
+ * Видає той самий потік токенів, що й lexer.l: ті самі коди, yylval і рядки.
+ * Пробіли, коментарі й ідентифікатори сканує по 8 байтів за раз (SWAR:
+ * побайтові порівняння в одному uint64_t), числа читає std::from_chars
+ * прямо з буфера. Ідентифікатор — string_view у буфер без копії; в арену
+ * Program (Interner) потрапляє лише перше входження кожного імені, бо AST
+ * живе довше за відображення файлу.
+ */
+struct FastLexer {
+    const char* p;
+    const char* end;
+    Program* prog;
+    int line = 1;
+    FastLexer(const char* data, size_t size, Program* pr): p(data), end(data + size), prog(pr){}
+};
+
+/* Наступний токен (0 — кінець буфера), як flex_lex з lex.yy.c */
+int fast_lex(FastLexer& L, YYSTYPE* lval, YYLTYPE* lloc);
@@ -1,120 +1,745 @@
 #include "gen_c.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
 #include <sstream>
-#include <typeinfo>
+#include <unordered_map>
+#include <vector>
 
-static void emit_node(std::ostringstream& out, AST* n, int ind);
-static void emit_block(std::ostringstream& out, BlockNode* b, int ind);
+/*
+ * Масиви в C: змінна a — вказівник T* на 64-байтово вирівняний буфер рядок
+ * за рядком, a__n / a__m — кількість рядків і стовпців (ідуть за масивом і в
+ * параметрах). Малий масив зі сталими розмірами живе в стеку (_Alignas(64)),
+ * інший — у купі (mc_alloc) і звільняється при виході з блоку чи перед return.
+ * Межі індексів, як і ділення на нуль, C-бекенд не перевіряє.
+ */
 
 static void indn(std::ostringstream& out, int n){ while(n--) out << "  "; }
 
-static void emit_expr(std::ostringstream& out, AST* n){
-  if(auto* k = dynamic_cast<NumberNode*>(n)){ out << k->v; return; }
-  if(auto* b = dynamic_cast<BoolNode*>(n)){ out << (b->v ? "1" : "0"); return; }
-  if(auto* v = dynamic_cast<VarRefNode*>(n)){ out << v->name; return; }
-  if(auto* u = dynamic_cast<UnaryOpNode*>(n)){
-    if(u->op == "neg"){ out << "-("; emit_expr(out, u->x); out << ")"; }
-    else { out << u->op << "("; emit_expr(out, u->x); out << ")"; }
+static const char* c_type(Type t){
+  switch(t){
+  case Type::Double: return "double";
+  case Type::Bool: return "bool";
+  default: return "long long"; // int мови — 64-бітний, як Value
+  }
+}
+
+// main у C зобов'язана повертати int; значення приводиться неявно
+static const char* ret_type(FuncDefNode* f){ return f->name == "main"? "int" : c_type(type_of(f->retType)); }
+
+// найкоротший запис, що читається назад у те саме double (після згортки констант це важливо);
+// double-літерал завжди з крапкою чи експонентою, інакше C порахує його як int
+static void emit_num(std::ostringstream& out, const NumberNode* n){
+  char buf[40];
+  if(n->type == Type::Int){
+    if(n->i == INT64_MIN){ out << "(-9223372036854775807LL - 1)"; return; }
+    std::snprintf(buf, sizeof buf, "%lld", (long long)n->i);
+    out << buf;
     return;
   }
-  if(auto* a = dynamic_cast<AssignNode*>(n)){
-    out << a->name << " = "; emit_expr(out, a->rhs); return;
+  std::snprintf(buf, sizeof buf, "%.15g", n->v);
+  if(std::strtod(buf, nullptr) != n->v) std::snprintf(buf, sizeof buf, "%.17g", n->v);
+  out << buf;
+  if(!std::strpbrk(buf, ".eEn")) out << ".0";
+}
+
+static const char* C_ARRAY_RUNTIME =
+  "#include <stdlib.h>\n#include <string.h>\n\n"
+  "static void* mc_alloc(long long rows, long long cols, size_t size){\n"
+  "  if(rows < 0 || cols < 0){ fputs(\"Runtime error: Negative array size\\n\", stderr); exit(1); }\n"
+  "  if(cols && rows > (1LL << 28) / cols){ fputs(\"Runtime error: Array too large\\n\", stderr); exit(1); }\n"
+  "  size_t bytes = ((size_t)(rows * cols) * size + 63) & ~(size_t)63;\n"
+  "  void* p = aligned_alloc(64, bytes? bytes : 64);\n"
+  "  if(!p){ fputs(\"Runtime error: Out of memory\\n\", stderr); exit(1); }\n"
+  "  return memset(p, 0, bytes);\n"
+  "}\n\n";
+
+/* Масив до стількох байтів зі сталими розмірами розміщується в стеку */
+constexpr int64_t C_STACK_ARRAY_BYTES = 16 * 1024;
+
+namespace {
+
+using Var = std::pair<int,int>; // (depth, slot) з resolve_program: однозначно в межах видимості
+
+template<typename F> void each_call(AST* n, F&& f);
+template<typename F> void each_call_expr(ExprNode* e, F&& f){
+  if(!e) return;
+  switch(e->kind){
+  case NodeKind::Assign: each_call_expr(as<AssignNode>(e)->rhs, f); return;
+  case NodeKind::BinOp: each_call_expr(as<BinOpNode>(e)->a, f); each_call_expr(as<BinOpNode>(e)->b, f); return;
+  case NodeKind::UnaryOp: each_call_expr(as<UnaryOpNode>(e)->x, f); return;
+  case NodeKind::Cast: each_call_expr(as<CastNode>(e)->x, f); return;
+  case NodeKind::Index: each_call_expr(as<IndexNode>(e)->i, f); each_call_expr(as<IndexNode>(e)->j, f); return;
+  case NodeKind::IndexAssign: each_call_expr(as<IndexAssignNode>(e)->at, f); each_call_expr(as<IndexAssignNode>(e)->rhs, f); return;
+  case NodeKind::Call: {
+    auto* c = as<CallNode>(e);
+    if(c->args) for(auto* a: c->args->args) each_call_expr(a, f);
+    f(c);
+    return;
   }
-  if(auto* b = dynamic_cast<BinOpNode*>(n)){
-    out << "("; emit_expr(out, b->a); out << " " << b->op << " "; emit_expr(out, b->b); out << ")"; return;
+  default: return;
   }
-  if(auto* c = dynamic_cast<CallNode*>(n)){
-    out << c->name << "(";
-    if(c->args){
-      for(size_t i=0;i<c->args->args.size();++i){
-        if(i) out << ", ";
-        emit_expr(out, c->args->args[i]);
-      }
+}
+template<typename F> void each_call(AST* n, F&& f){
+  if(!n) return;
+  switch(n->kind){
+  case NodeKind::Decl: { auto* d = as<DeclNode>(n); each_call_expr(d->init, f); each_call_expr(d->dims[0], f); each_call_expr(d->dims[1], f); return; }
+  case NodeKind::ExprStmt: each_call_expr(as<ExprStmtNode>(n)->expr, f); return;
+  case NodeKind::Return: each_call_expr(as<ReturnNode>(n)->expr, f); return;
+  case NodeKind::If: { auto* iff = as<IfNode>(n); each_call_expr(iff->cond, f); each_call(iff->thenN, f); each_call(iff->elseN, f); return; }
+  case NodeKind::While: { auto* wh = as<WhileNode>(n); each_call_expr(wh->cond, f); each_call(wh->body, f); return; }
+  case NodeKind::For: {
+    auto* fr = as<ForNode>(n);
+    each_call_expr(fr->init, f); each_call_expr(fr->cond, f); each_call_expr(fr->step, f); each_call(fr->body, f);
+    return;
+  }
+  case NodeKind::Block: for(auto* s: as<BlockNode>(n)->stmts) each_call(s, f); return;
+  default: return;
+  }
+}
+
+/*
+ * Які параметри-масиви можна оголосити restrict: пара параметрів (p, q) функції
+ * може вказувати на один масив, якщо десь передано ту саму змінну на обидва місця
+ * або пару параметрів викликача, що самі можуть збігатися. Найменша нерухома точка.
+ */
+std::unordered_map<FuncDefNode*,std::vector<bool>> restrict_params(Program* p){
+  std::vector<FuncDefNode*> fs;
+  for(auto* it : p->items) if(it->kind == NodeKind::FuncDef) fs.push_back(as<FuncDefNode>(it));
+  std::map<FuncDefNode*,std::set<std::pair<int,int>>> alias;
+  for(bool changed = true; changed; ){
+    changed = false;
+    for(auto* g : fs){
+      each_call(g->body, [&](CallNode* c){
+        if(!c->args || !c->target) return;
+        auto& args = c->args->args;
+        for(size_t k=0;k<args.size();++k){
+          if(!args[k]->rank) continue;
+          auto* x = as<VarRefNode>(args[k]);
+          for(size_t l=k+1;l<args.size();++l){
+            if(!args[l]->rank) continue;
+            auto* y = as<VarRefNode>(args[l]);
+            bool same = x->depth == y->depth && x->slot == y->slot;
+            bool via = x->depth == 0 && y->depth == 0 && alias[g].count({std::min(x->slot, y->slot), std::max(x->slot, y->slot)});
+            if((same || via) && alias[c->target].insert({(int)k, (int)l}).second) changed = true;
+          }
+        }
+      });
     }
-    out << ")"; return;
   }
-  out << "0"; // fallback
+  std::unordered_map<FuncDefNode*,std::vector<bool>> res;
+  for(auto* f : fs){
+    size_t n = f->params? f->params->params.size() : 0;
+    auto& r = res[f];
+    r.assign(n, true);
+    for(auto& [k, l] : alias[f]){ r[k] = false; r[l] = false; }
+  }
+  return res;
 }
 
-static std::string c_type(const std::string& t){
-  if(t=="int") return "int";
-  if(t=="double") return "double";
-  if(t=="bool") return "int"; // bool -> int
-  return "int";
+/* Структурна рівність індексних виразів (змінні — за слотом) */
+bool same_expr(ExprNode* a, ExprNode* b){
+  if(!a || !b) return a == b;
+  if(a->kind != b->kind || a->type != b->type) return false;
+  switch(a->kind){
+  case NodeKind::Number: return as<NumberNode>(a)->i == as<NumberNode>(b)->i && as<NumberNode>(a)->v == as<NumberNode>(b)->v;
+  case NodeKind::Bool: return as<BoolNode>(a)->v == as<BoolNode>(b)->v;
+  case NodeKind::VarRef: return as<VarRefNode>(a)->depth == as<VarRefNode>(b)->depth && as<VarRefNode>(a)->slot == as<VarRefNode>(b)->slot;
+  case NodeKind::BinOp: return as<BinOpNode>(a)->op == as<BinOpNode>(b)->op && same_expr(as<BinOpNode>(a)->a, as<BinOpNode>(b)->a) && same_expr(as<BinOpNode>(a)->b, as<BinOpNode>(b)->b);
+  case NodeKind::UnaryOp: return as<UnaryOpNode>(a)->op == as<UnaryOpNode>(b)->op && same_expr(as<UnaryOpNode>(a)->x, as<UnaryOpNode>(b)->x);
+  case NodeKind::Cast: return same_expr(as<CastNode>(a)->x, as<CastNode>(b)->x);
+  default: return false;
+  }
 }
 
-static void emit_block(std::ostringstream& out, BlockNode* b, int ind){
-  indn(out,ind); out << "{\n";
-  for(auto* s : b->stmts) emit_node(out, s, ind+1);
-  indn(out,ind); out << "}\n";
+/* Звертання до змінної (depth, slot) у піддереві (крім skip): читання чи присвоєння */
+bool mentions_expr(ExprNode* e, Var v){
+  if(!e) return false;
+  switch(e->kind){
+  case NodeKind::VarRef: return Var{as<VarRefNode>(e)->depth, as<VarRefNode>(e)->slot} == v;
+  case NodeKind::Assign: { auto* a = as<AssignNode>(e); return Var{a->depth, a->slot} == v || mentions_expr(a->rhs, v); }
+  case NodeKind::BinOp: return mentions_expr(as<BinOpNode>(e)->a, v) || mentions_expr(as<BinOpNode>(e)->b, v);
+  case NodeKind::UnaryOp: return mentions_expr(as<UnaryOpNode>(e)->x, v);
+  case NodeKind::Cast: return mentions_expr(as<CastNode>(e)->x, v);
+  case NodeKind::Index: return mentions_expr(as<IndexNode>(e)->i, v) || mentions_expr(as<IndexNode>(e)->j, v);
+  case NodeKind::IndexAssign: return mentions_expr(as<IndexAssignNode>(e)->at, v) || mentions_expr(as<IndexAssignNode>(e)->rhs, v);
+  case NodeKind::Call: {
+    auto* c = as<CallNode>(e);
+    if(c->args) for(auto* a: c->args->args) if(mentions_expr(a, v)) return true;
+    return false;
+  }
+  default: return false;
+  }
+}
+bool mentions(AST* n, Var v, AST* skip = nullptr){
+  if(!n || n == skip) return false;
+  switch(n->kind){
+  case NodeKind::Decl: { auto* d = as<DeclNode>(n); return mentions_expr(d->init, v) || mentions_expr(d->dims[0], v) || mentions_expr(d->dims[1], v); }
+  case NodeKind::ExprStmt: return mentions_expr(as<ExprStmtNode>(n)->expr, v);
+  case NodeKind::Return: return mentions_expr(as<ReturnNode>(n)->expr, v);
+  case NodeKind::If: { auto* iff = as<IfNode>(n); return mentions_expr(iff->cond, v) || mentions(iff->thenN, v, skip) || mentions(iff->elseN, v, skip); }
+  case NodeKind::While: return mentions_expr(as<WhileNode>(n)->cond, v) || mentions(as<WhileNode>(n)->body, v, skip);
+  case NodeKind::For: {
+    auto* fr = as<ForNode>(n);
+    return mentions_expr(fr->init, v) || mentions_expr(fr->cond, v) || mentions_expr(fr->step, v) || mentions(fr->body, v, skip);
+  }
+  case NodeKind::Block: for(auto* s: as<BlockNode>(n)->stmts) if(mentions(s, v, skip)) return true; return false;
+  default: return false;
+  }
 }
 
-static void emit_node(std::ostringstream& out, AST* n, int ind){
-  if(auto* d = dynamic_cast<DeclNode*>(n)){
-    indn(out,ind); out << c_type(d->type) << " " << d->name;
-    if(d->init){ out << " = "; emit_expr(out, d->init); }
-    out << ";\n"; return;
+/* Чи може тіло прочитати v до присвоєння в тій самій ітерації; def — чи
+   присвоєно v на кожному шляху до поточної точки */
+struct Exposed {
+  Var v; bool exposed = false;
+  void use(ExprNode* e, bool& def){
+    if(!e || exposed) return;
+    if(e->kind == NodeKind::Assign && Var{as<AssignNode>(e)->depth, as<AssignNode>(e)->slot} == v){
+      use(as<AssignNode>(e)->rhs, def); def = true; return;
+    }
+    if(!def && mentions_expr(e, v)) exposed = true;
   }
-  if(auto* es = dynamic_cast<ExprStmtNode*>(n)){
-    indn(out,ind); emit_expr(out, es->expr); out << ";\n"; return;
+  void walk(AST* n, bool& def){
+    if(!n || exposed) return;
+    switch(n->kind){
+    case NodeKind::Decl: { auto* d = as<DeclNode>(n); use(d->init, def); use(d->dims[0], def); use(d->dims[1], def); return; }
+    case NodeKind::ExprStmt: use(as<ExprStmtNode>(n)->expr, def); return;
+    case NodeKind::Return: use(as<ReturnNode>(n)->expr, def); return;
+    case NodeKind::If: {
+      auto* iff = as<IfNode>(n);
+      use(iff->cond, def);
+      bool t = def, e = def;
+      walk(iff->thenN, t); walk(iff->elseN, e);
+      def = t && e;
+      return;
+    }
+    // тіло циклу може не виконатися жодного разу, тож його присвоєння не зараховуємо
+    case NodeKind::While: { auto* wh = as<WhileNode>(n); use(wh->cond, def); bool b = def; walk(wh->body, b); return; }
+    case NodeKind::For: {
+      auto* fr = as<ForNode>(n);
+      use(fr->init, def); use(fr->cond, def);
+      bool b = def; walk(fr->body, b); use(fr->step, b);
+      return;
+    }
+    case NodeKind::Block: for(auto* s: as<BlockNode>(n)->stmts) walk(s, def); return;
+    default: return;
+    }
   }
-  if(auto* r = dynamic_cast<ReturnNode*>(n)){
-    indn(out,ind); out << "return "; if(r->expr) emit_expr(out, r->expr); else out << "0"; out << ";\n"; return;
+};
+
+/*
+ * Аналіз залежностей циклу for i = a; i < b; i = i + c (b і c інваріантні).
+ * Ітерації незалежні, якщо:
+ *   - масив, у який пишуть, в усіх звертаннях має за одним виміром той самий
+ *     ін'єктивний за i індекс (a[i+k], m[i][*], m[*][i]) — ітерації ділять його
+ *     на неперетинні частини; параметр без restrict не може збігатися з іншим;
+ *   - зовнішній скаляр або приватний (у кожній ітерації присвоюється до читання,
+ *     як змінні вкладених циклів) — lastprivate, якщо ітерація завжди закінчується
+ *     з присвоєним значенням, інакше private, коли поза циклом його не згадують; або
+ *     int-редукція s = s + e / s = s * e — reduction; для int з -fwrapv
+ *     перестановка точна, суми double лишаються послідовними;
+ *   - немає return, масивів-оголошень і викликів нечистих функцій.
+ * Режим simd (внутрішній цикл) додатково забороняє вкладені цикли й виклики;
+ * режим parallel вимагає вкладеного циклу чи виклику, інакше потоки не окупляться.
+ */
+struct LoopDep {
+  bool parallel;
+  Var iv;
+  std::set<Var> local;                 // оголошені в тілі: свої в кожній ітерації
+  std::vector<AssignNode*> assigns;
+  std::vector<std::pair<IndexNode*,bool>> access; // звертання до масивів, true — запис
+  std::map<Var,int> reads;             // кількість читань кожного скаляра
+  std::map<Var,Name> names;
+  std::set<Var> wscalar, warray, last, priv;
+  const std::vector<bool>* restr = nullptr;
+  FuncDefNode* fn = nullptr;           // для перевірки згадок поза циклом
+  bool work = false;                   // вкладений цикл або виклик
+  std::string why;                     // перша причина відмови
+
+  explicit LoopDep(bool par): parallel(par){}
+
+  bool fail(const std::string& r){ if(why.empty()) why = r; return false; }
+  static Var var(VarRefNode* v){ return {v->depth, v->slot}; }
+
+  void expr(ExprNode* e){
+    if(!e) return;
+    switch(e->kind){
+    case NodeKind::Number: case NodeKind::Bool: case NodeKind::Len: return;
+    case NodeKind::VarRef: { auto* v = as<VarRefNode>(e); reads[var(v)]++; names[var(v)] = v->name; return; }
+    case NodeKind::Assign: { auto* a = as<AssignNode>(e); assigns.push_back(a); names[{a->depth, a->slot}] = a->name; expr(a->rhs); return; }
+    case NodeKind::BinOp: expr(as<BinOpNode>(e)->a); expr(as<BinOpNode>(e)->b); return;
+    case NodeKind::UnaryOp: expr(as<UnaryOpNode>(e)->x); return;
+    case NodeKind::Cast: expr(as<CastNode>(e)->x); return;
+    case NodeKind::Index: {
+      auto* x = as<IndexNode>(e);
+      access.push_back({x, false}); names[{x->depth, x->slot}] = x->name;
+      expr(x->i); expr(x->j);
+      return;
+    }
+    case NodeKind::IndexAssign: {
+      auto* a = as<IndexAssignNode>(e);
+      access.push_back({a->at, true}); names[{a->at->depth, a->at->slot}] = a->at->name;
+      expr(a->at->i); expr(a->at->j); expr(a->rhs);
+      return;
+    }
+    case NodeKind::Call: {
+      auto* c = as<CallNode>(e);
+      if(!parallel) fail("calls "+std::string(c->name));
+      else if(!c->target || !c->target->pure) fail("calls "+std::string(c->name)+", which is not pure");
+      work = true;
+      if(c->args) for(auto* a: c->args->args) expr(a);
+      return;
+    }
+    default: fail("unsupported expression"); return;
+    }
   }
-  if(auto* iff = dynamic_cast<IfNode*>(n)){
-    indn(out,ind); out << "if ("; emit_expr(out, iff->cond); out << ")\n";
-    emit_node(out, iff->thenN, ind);
-    if(iff->elseN){ indn(out,ind); out << "else\n"; emit_node(out, iff->elseN, ind); }
-    return;
+  void stmt(AST* n){
+    if(!n) return;
+    switch(n->kind){
+    case NodeKind::Decl: {
+      auto* d = as<DeclNode>(n);
+      if(d->rank) fail("declares array "+std::string(d->name));
+      expr(d->init); local.insert({d->depth, d->slot});
+      return;
+    }
+    case NodeKind::ExprStmt: expr(as<ExprStmtNode>(n)->expr); return;
+    case NodeKind::If: { auto* iff = as<IfNode>(n); expr(iff->cond); stmt(iff->thenN); stmt(iff->elseN); return; }
+    case NodeKind::Block: for(auto* s: as<BlockNode>(n)->stmts) stmt(s); return;
+    case NodeKind::While: case NodeKind::For:
+      if(!parallel){ fail("contains a nested loop"); return; }
+      work = true;
+      if(n->kind == NodeKind::While){ expr(as<WhileNode>(n)->cond); stmt(as<WhileNode>(n)->body); return; }
+      { auto* fr = as<ForNode>(n); expr(fr->init); expr(fr->cond); expr(fr->step); stmt(fr->body); }
+      return;
+    case NodeKind::Return: fail("returns from inside the loop"); return;
+    default: fail("unsupported statement"); return;
+    }
   }
-  if(auto* wh = dynamic_cast<WhileNode*>(n)){
-    indn(out,ind); out << "while ("; emit_expr(out, wh->cond); out << ")\n";
-    emit_node(out, wh->body, ind); return;
+
+  /* Не залежить від ітерації: без записів, i і змінних, що змінюються в циклі */
+  bool invariant(ExprNode* e){
+    if(!e) return true;
+    switch(e->kind){
+    case NodeKind::Number: case NodeKind::Bool: case NodeKind::Len: return true;
+    case NodeKind::VarRef: { Var v = var(as<VarRefNode>(e)); return v != iv && !local.count(v) && !wscalar.count(v); }
+    case NodeKind::BinOp: return invariant(as<BinOpNode>(e)->a) && invariant(as<BinOpNode>(e)->b);
+    case NodeKind::UnaryOp: return invariant(as<UnaryOpNode>(e)->x);
+    case NodeKind::Cast: return invariant(as<CastNode>(e)->x);
+    case NodeKind::Index: {
+      auto* x = as<IndexNode>(e);
+      return !warray.count({x->depth, x->slot}) && invariant(x->i) && invariant(x->j);
+    }
+    default: return false;
+    }
+  }
+  bool is_iv(ExprNode* e){ return e->kind == NodeKind::VarRef && var(as<VarRefNode>(e)) == iv; }
+  /* i, i + c, c + i, i - c */
+  bool linear(ExprNode* e){
+    if(is_iv(e)) return true;
+    if(e->kind != NodeKind::BinOp) return false;
+    auto* b = as<BinOpNode>(e);
+    if(b->op == Op::Add) return (is_iv(b->a) && invariant(b->b)) || (invariant(b->a) && is_iv(b->b));
+    return b->op == Op::Sub && is_iv(b->a) && invariant(b->b);
   }
-  if(auto* fr = dynamic_cast<ForNode*>(n)){
-    indn(out,ind); out << "for (";
-    if(fr->init) emit_expr(out, fr->init); out << "; ";
-    if(fr->cond) emit_expr(out, fr->cond); out << "; ";
-    if(fr->step) emit_expr(out, fr->step); out << ")\n";
-    emit_node(out, fr->body, ind); return;
+  /* Вимір dim масиву a в усіх звертаннях індексується тим самим лінійним за i виразом */
+  bool partitioned(Var a, int dim){
+    ExprNode* first = nullptr;
+    for(auto& [x, w] : access){
+      if(Var{x->depth, x->slot} != a) continue;
+      ExprNode* e = dim? x->j : x->i;
+      if(!first){ first = e; if(!linear(e)) return false; continue; }
+      if(!same_expr(first, e)) return false;
+    }
+    return true;
   }
-  if(auto* bl = dynamic_cast<BlockNode*>(n)){ emit_block(out, bl, ind); return; }
 
-  indn(out,ind); emit_expr(out, n); out << ";\n";
-}
+  /* v — один з операндів ланцюжка s + a + b (дужки довільні) */
+  static bool operand(ExprNode* e, Op op, Var v){
+    if(e->kind == NodeKind::VarRef) return var(as<VarRefNode>(e)) == v;
+    if(e->kind != NodeKind::BinOp || as<BinOpNode>(e)->op != op) return false;
+    return operand(as<BinOpNode>(e)->a, op, v) || operand(as<BinOpNode>(e)->b, op, v);
+  }
 
-std::string gen_c_code(Program* p){
+  void privatize(ForNode* fr){
+    for(auto& v : wscalar){
+      Exposed x{v};
+      bool def = false;
+      x.walk(fr->body, def);
+      if(x.exposed) continue;
+      if(def) last.insert(v);
+      else if(!mentions(fn->body, v, fr)) priv.insert(v);
+    }
+  }
+
+  /* true — ітерації незалежні; clauses — клаузи прагми */
+  bool check(ForNode* fr, std::string& clauses){
+    if(!fr->init || !fr->cond || !fr->step || fr->init->kind != NodeKind::Assign || fr->init->type != Type::Int)
+      return fail("not in canonical form i = a; i < b; i = i + c");
+    auto* init = as<AssignNode>(fr->init);
+    iv = {init->depth, init->slot};
+    stmt(fr->body);
+    expr(init->rhs);
+    if(!why.empty()) return false;
+    for(auto* a : assigns){
+      Var v{a->depth, a->slot};
+      if(v == iv) return fail("modifies loop variable "+std::string(a->name)+" in the body");
+      if(!local.count(v)) wscalar.insert(v);
+    }
+    for(auto& [x, w] : access) if(w) warray.insert({x->depth, x->slot});
+
+    // умова і крок
+    if(fr->cond->kind != NodeKind::BinOp) return fail("not in canonical form i = a; i < b; i = i + c");
+    auto* c = as<BinOpNode>(fr->cond);
+    if(c->op != Op::Lt && c->op != Op::Le && c->op != Op::Gt && c->op != Op::Ge) return fail("not in canonical form i = a; i < b; i = i + c");
+    if(!is_iv(c->a) || !invariant(c->b)) return fail("loop bound changes inside the loop");
+    if(fr->step->kind != NodeKind::Assign) return fail("not in canonical form i = a; i < b; i = i + c");
+    auto* st = as<AssignNode>(fr->step);
+    if(Var{st->depth, st->slot} != iv || !linear(st->rhs) || is_iv(st->rhs)) return fail("step is not i = i + c with invariant c");
+    if(!invariant(init->rhs)) return fail("not in canonical form i = a; i < b; i = i + c");
+
+    // зовнішні скаляри: приватні або int-редукції, які більше ніде не читаються
+    if(parallel) privatize(fr);
+    std::string plus, times, lastp, privp;
+    // змінна циклу в parallel for приватна; її кінцеве значення потрібне лише поза циклом
+    if(parallel && mentions(fn->body, iv, fr)) lastp = std::string(init->name);
+    for(auto& v : wscalar){
+      std::string name(names[v]);
+      if(last.count(v)){ lastp += (lastp.empty()? "" : ", ") + name; continue; }
+      if(priv.count(v)){ privp += (privp.empty()? "" : ", ") + name; continue; }
+      int n = 0; Op op = Op::Add;
+      for(auto* a : assigns){
+        if(Var{a->depth, a->slot} != v) continue;
+        if(a->rhs->kind != NodeKind::BinOp) return fail("carries "+name+" from one iteration to the next");
+        auto* b = as<BinOpNode>(a->rhs);
+        if((b->op != Op::Add && b->op != Op::Mul) || !operand(b, b->op, v) || (n && b->op != op))
+          return fail("carries "+name+" from one iteration to the next");
+        if(a->type != Type::Int) return fail("reduction on "+std::string(type_name(a->type))+" "+name+" would reorder rounding");
+        op = b->op; n++;
+      }
+      if(reads[v] != n) return fail("reads "+name+" outside its reduction");
+      std::string& list = op == Op::Add? plus : times;
+      list += (list.empty()? "" : ", ") + name;
+    }
+
+    // масиви, у які пишуть: розбиття за i хоча б одним виміром
+    bool params = false;
+    for(auto& [x, w] : access) if(x->depth == 0) params = true;
+    for(auto& a : warray){
+      int rank = 1;
+      for(auto& [x, w] : access) if(Var{x->depth, x->slot} == a && x->j) rank = 2;
+      if(!partitioned(a, 0) && !(rank == 2 && partitioned(a, 1)))
+        return fail("writes "+std::string(names[a])+" at indices not partitioned by the loop variable");
+      // параметр без restrict може збігатися з іншим параметром-масивом
+      if(a.first == 0 && params && !(*restr)[a.second]){
+        for(auto& [x, w] : access)
+          if(x->depth == 0 && x->slot != a.second) return fail("array parameters may alias");
+      }
+    }
+    if(parallel && !work) return fail("no nested loop or call: too little work per iteration");
+
+    clauses.clear();
+    if(!plus.empty()) clauses += " reduction(+:" + plus + ")";
+    if(!times.empty()) clauses += " reduction(*:" + times + ")";
+    if(!privp.empty()) clauses += " private(" + privp + ")";
+    if(!lastp.empty()) clauses += " lastprivate(" + lastp + ")";
+    return true;
+  }
+};
+
+struct CEmitter {
+  std::ostringstream& out;
+  const std::unordered_map<FuncDefNode*,std::vector<bool>>& restr;
+  FuncDefNode* fn = nullptr;
+  std::vector<std::vector<Name>> heap; // масиви в купі по блоках, звільняються в зворотному порядку
+  bool arrays = false;
+  bool in_parallel = false;            // вкладені в parallel for цикли лишаються в тому ж потоці
+  std::ostream* report = nullptr;
+
+  CEmitter(std::ostringstream& o, const std::unordered_map<FuncDefNode*,std::vector<bool>>& r): out(o), restr(r){}
+
+  void note(AST* loop, const std::string& what, const std::string& verdict){
+    if(report) *report << fn->name << ":" << loop->line << ": " << what << ": " << verdict << "\n";
+  }
+
+  /*
+   * Явний parallel for (незалежність ітерацій перевірив typecheck): ті самі
+   * min(count, PAR_CHUNKS) частин, що й в інтерпретаторі (eval.cpp), частини
+   * роздає OpenMP, а редукції зводяться після циклу в порядку номерів частин.
+   * Тож суми double не залежать від OMP_NUM_THREADS і збігаються з --run,
+   * чого reduction(+:...) OpenMP не гарантує. Змінна циклу й редукційні
+   * змінні всередині частини — локальні копії, що затіняють зовнішні.
+   * Усередині іншого паралельного циклу (in_parallel) частини йдуть у тому ж
+   * потоці по черзі — без прагми, але з тим самим поділом і зведенням, як
+   * у helper World інтерпретатора.
+   */
+  void parallel_for(ForNode* fr, int ind){
+    ParLoop l;
+    par_loop(fr, l);
+    std::string iv(l.init->name), step = std::to_string(l.step);
+    auto v = [&](const char* suffix){ return iv + "__" + suffix; };
+    std::string reds;
+    for(auto& r : fr->reductions) reds += std::string(" ") + op_str(r.op) + ":" + std::string(r.name);
+    bool nested = in_parallel;
+    note(fr, "for " + iv, std::string(nested? "serial chunks inside a parallel loop" : "parallel for") + " (explicit, "
+                          + std::to_string(PAR_CHUNKS) + " chunks" + (reds.empty()? "" : ", reduction" + reds) + ")");
+
+    indn(out,ind); out << "{\n";
+    int in = ind + 1;
+    indn(out,in); out << "long long " << v("lo") << " = "; expr(l.init->rhs); out << ", " << v("hi") << " = "; expr(l.hi); out << ";\n";
+    indn(out,in); out << "unsigned long long " << v("cnt") << " = " << v("hi") << (l.inclusive? " < " : " <= ") << v("lo") << " ? 0 : ((unsigned long long)"
+                      << v("hi") << " - (unsigned long long)" << v("lo") << (l.inclusive? "" : " - 1") << ") / " << step << " + 1;\n";
+    indn(out,in); out << "long long " << v("chunks") << " = " << v("cnt") << " < " << PAR_CHUNKS << " ? (long long)" << v("cnt") << " : " << PAR_CHUNKS << ";\n";
+    for(auto& r : fr->reductions){ indn(out,in); out << c_type(r.type) << " " << r.name << "__part[" << PAR_CHUNKS << "];\n"; }
+    if(!nested){ indn(out,in); out << "#pragma omp parallel for schedule(dynamic, 1)\n"; }
+    indn(out,in); out << "for (long long " << v("k") << " = 0; " << v("k") << " < " << v("chunks") << "; " << v("k") << "++) {\n";
+    int ck = in + 1;
+    indn(out,ck); out << "unsigned long long " << v("q") << " = " << v("cnt") << " / " << v("chunks") << ", " << v("r") << " = " << v("cnt") << " % " << v("chunks") << ";\n";
+    indn(out,ck); out << "unsigned long long " << v("b") << " = " << v("k") << " * " << v("q") << " + ((unsigned long long)" << v("k") << " < " << v("r")
+                      << " ? (unsigned long long)" << v("k") << " : " << v("r") << ");\n";
+    indn(out,ck); out << "unsigned long long " << v("e") << " = " << v("b") << " + " << v("q") << " + ((unsigned long long)" << v("k") << " < " << v("r") << ");\n";
+    for(auto& r : fr->reductions){
+      indn(out,ck); out << c_type(r.type) << " " << r.name << " = " << (r.op == Op::Add? (r.type == Type::Int? "0" : "0.0") : (r.type == Type::Int? "1" : "1.0")) << ";\n";
+    }
+    indn(out,ck); out << "for (unsigned long long " << v("t") << " = " << v("b") << "; " << v("t") << " < " << v("e") << "; " << v("t") << "++) {\n";
+    indn(out,ck+1); out << "long long " << iv << " = (long long)((unsigned long long)" << v("lo") << " + " << v("t") << " * " << step << ");\n";
+    in_parallel = true;
+    node(fr->body, ck + 1);
+    in_parallel = nested;
+    indn(out,ck); out << "}\n";
+    for(auto& r : fr->reductions){ indn(out,ck); out << r.name << "__part[" << v("k") << "] = " << r.name << ";\n"; }
+    indn(out,in); out << "}\n";
+    if(!fr->reductions.empty()){
+      indn(out,in); out << "for (long long " << v("k") << " = 0; " << v("k") << " < " << v("chunks") << "; " << v("k") << "++) {\n";
+      for(auto& r : fr->reductions){ indn(out,in+1); out << r.name << " = " << r.name << " " << op_str(r.op) << " " << r.name << "__part[" << v("k") << "];\n"; }
+      indn(out,in); out << "}\n";
+    }
+    // як після послідовного циклу: перше значення, що не проходить умову
+    indn(out,in); out << iv << " = (long long)((unsigned long long)" << v("lo") << " + " << v("cnt") << " * " << step << ");\n";
+    indn(out,ind); out << "}\n";
+  }
+
+  void index(IndexNode* x){
+    out << x->name << "[";
+    if(x->j){ out << "("; expr(x->i); out << ") * " << x->name << "__m + ("; expr(x->j); out << ")"; }
+    else expr(x->i);
+    out << "]";
+  }
+
+  void expr(AST* n){
+    switch(n->kind){
+    case NodeKind::Number: emit_num(out, as<NumberNode>(n)); return;
+    case NodeKind::Bool: out << (as<BoolNode>(n)->v ? "true" : "false"); return;
+    case NodeKind::Cast: {
+      auto* c = as<CastNode>(n);
+      out << "((" << c_type(c->type) << ")("; expr(c->x); out << "))";
+      return;
+    }
+    case NodeKind::VarRef: out << as<VarRefNode>(n)->name; return;
+    case NodeKind::UnaryOp: {
+      auto* u = as<UnaryOpNode>(n);
+      out << op_str(u->op) << "("; expr(u->x); out << ")";
+      return;
+    }
+    case NodeKind::Assign: {
+      auto* a = as<AssignNode>(n);
+      out << a->name << " = "; expr(a->rhs); return;
+    }
+    case NodeKind::BinOp: {
+      auto* b = as<BinOpNode>(n);
+      out << "("; expr(b->a); out << " " << op_str(b->op) << " "; expr(b->b); out << ")"; return;
+    }
+    case NodeKind::Call: {
+      auto* c = as<CallNode>(n);
+      out << c->name << "(";
+      if(c->args){
+        for(size_t i=0;i<c->args->args.size();++i){
+          if(i) out << ", ";
+          ExprNode* a = c->args->args[i];
+          expr(a);
+          if(a->rank){ Name v = as<VarRefNode>(a)->name; out << ", " << v << "__n"; if(a->rank == 2) out << ", " << v << "__m"; }
+        }
+      }
+      out << ")"; return;
+    }
+    case NodeKind::Index: index(as<IndexNode>(n)); return;
+    case NodeKind::IndexAssign: {
+      auto* a = as<IndexAssignNode>(n);
+      index(a->at); out << " = "; expr(a->rhs); return;
+    }
+    case NodeKind::Len: { auto* l = as<LenNode>(n); out << l->name << (l->dim? "__m" : "__n"); return; }
+    default:
+      out << "0"; // fallback
+    }
+  }
+
+  void free_heap(int ind, size_t from){
+    for(size_t b = heap.size(); b-- > from; )
+      for(auto it = heap[b].rbegin(); it != heap[b].rend(); ++it){ indn(out,ind); out << "free(" << *it << ");\n"; }
+  }
+
+  void block(BlockNode* b, int ind){
+    indn(out,ind); out << "{\n";
+    heap.emplace_back();
+    for(auto* s : b->stmts) node(s, ind+1);
+    free_heap(ind+1, heap.size()-1);
+    heap.pop_back();
+    indn(out,ind); out << "}\n";
+  }
+
+  void array_decl(DeclNode* d, int ind){
+    arrays = true;
+    const char* t = c_type(type_of(d->type));
+    bool fixed = true; int64_t elems = 1;
+    for(int k=0;k<d->rank;++k){
+      ExprNode* e = d->dims[k];
+      if(e->kind != NodeKind::Number || as<NumberNode>(e)->i < 0) { fixed = false; break; }
+      int64_t v = as<NumberNode>(e)->i;
+      if(v && elems > C_STACK_ARRAY_BYTES / 8 / v){ fixed = false; break; }
+      elems *= v;
+    }
+    indn(out,ind); out << "long long " << d->name << "__n = "; expr(d->dims[0]);
+    if(d->rank == 2){ out << ", " << d->name << "__m = "; expr(d->dims[1]); }
+    out << ";\n";
+    indn(out,ind);
+    if(fixed){
+      out << "_Alignas(64) " << t << " " << d->name << "__buf[" << (elems? elems : 1) << "] = {0};\n";
+      indn(out,ind); out << t << "* restrict " << d->name << " = " << d->name << "__buf;\n";
+      return;
+    }
+    out << t << "* restrict " << d->name << " = (" << t << "*)mc_alloc(" << d->name << "__n, "
+        << (d->rank == 2? std::string(d->name)+"__m" : std::string("1")) << ", sizeof(" << t << "));\n";
+    heap.back().push_back(d->name);
+  }
+
+  bool live_heap() const { for(auto& h : heap) if(!h.empty()) return true; return false; }
+
+  void node(AST* n, int ind){
+    switch(n->kind){
+    case NodeKind::Decl: {
+      auto* d = as<DeclNode>(n);
+      if(d->rank){ array_decl(d, ind); return; }
+      indn(out,ind); out << c_type(type_of(d->type)) << " " << d->name;
+      if(d->init){ out << " = "; expr(d->init); }
+      out << ";\n"; return;
+    }
+    case NodeKind::ExprStmt:
+      indn(out,ind); expr(as<ExprStmtNode>(n)->expr); out << ";\n"; return;
+    case NodeKind::Return: {
+      auto* r = as<ReturnNode>(n);
+      if(live_heap()){
+        // значення може читати масиви, тож обчислюємо його до free
+        indn(out,ind); out << "{\n";
+        indn(out,ind+1); out << ret_type(fn) << " mc__ret = "; expr(r->expr); out << ";\n";
+        free_heap(ind+1, 0);
+        indn(out,ind+1); out << "return mc__ret;\n";
+        indn(out,ind); out << "}\n";
+        return;
+      }
+      indn(out,ind); out << "return "; expr(r->expr); out << ";\n"; return;
+    }
+    case NodeKind::If: {
+      auto* iff = as<IfNode>(n);
+      indn(out,ind); out << "if ("; expr(iff->cond); out << ")\n";
+      node(iff->thenN, ind);
+      if(iff->elseN){ indn(out,ind); out << "else\n"; node(iff->elseN, ind); }
+      return;
+    }
+    case NodeKind::While: {
+      auto* wh = as<WhileNode>(n);
+      note(wh, "while", "serial: no induction variable");
+      indn(out,ind); out << "while ("; expr(wh->cond); out << ")\n";
+      node(wh->body, ind); return;
+    }
+    case NodeKind::For: {
+      auto* fr = as<ForNode>(n);
+      std::string clauses, why;
+      LoopDep par(true), simd(false);
+      par.restr = simd.restr = &restr.at(fn);
+      par.fn = simd.fn = fn;
+      const char* pragma = nullptr;
+      if(fr->parallel){ parallel_for(fr, ind); return; }
+      if(in_parallel) why = "inside a parallel loop";
+      else if(par.check(fr, clauses)) pragma = "parallel for";
+      else why = par.why;
+      if(!pragma){
+        if(simd.check(fr, clauses)) pragma = "simd";
+        else if(simd.why != why) why += (why.empty()? "" : "; ") + ("simd: " + simd.why);
+      }
+      std::string what = "for";
+      if(fr->init && fr->init->kind == NodeKind::Assign) what += " " + std::string(as<AssignNode>(fr->init)->name);
+      note(fr, what, pragma? pragma + clauses : "serial: " + why);
+      if(pragma){
+        // OpenMP приймає лише канонічний заголовок: i < b; i = i + c без зовнішніх дужок
+        auto* c = as<BinOpNode>(fr->cond); auto* st = as<BinOpNode>(as<AssignNode>(fr->step)->rhs);
+        // без жодної ітерації OpenMP не записує змінну циклу, а послідовно вона дорівнює a
+        auto* iv = as<AssignNode>(fr->init);
+        if(mentions(fn->body, {iv->depth, iv->slot}, fr)){ indn(out,ind); expr(iv); out << ";\n"; }
+        indn(out,ind); out << "#pragma omp " << pragma << clauses << "\n";
+        indn(out,ind); out << "for ("; expr(fr->init); out << "; ";
+        expr(c->a); out << " " << op_str(c->op) << " "; expr(c->b); out << "; ";
+        out << as<AssignNode>(fr->step)->name << " = "; expr(st->a); out << " " << op_str(st->op) << " "; expr(st->b); out << ")\n";
+        bool outer = !in_parallel;
+        if(*pragma == 'p') in_parallel = true;
+        node(fr->body, ind);
+        if(outer) in_parallel = false;
+        return;
+      }
+      indn(out,ind); out << "for (";
+      if(fr->init){ expr(fr->init); } out << "; ";
+      if(fr->cond){ expr(fr->cond); } out << "; ";
+      if(fr->step){ expr(fr->step); } out << ")\n";
+      node(fr->body, ind); return;
+    }
+    case NodeKind::Block: block(as<BlockNode>(n), ind); return;
+    default:
+      indn(out,ind); expr(n); out << ";\n";
+    }
+  }
+
+  void signature(FuncDefNode* f){
+    out << ret_type(f) << " " << f->name << "(";
+    size_t n = f->params? f->params->params.size() : 0;
+    for(size_t i=0;i<n;++i){
+      if(i) out << ", ";
+      auto* pr = f->params->params[i];
+      if(!pr->rank){ out << c_type(type_of(pr->type)) << " " << pr->name; continue; }
+      arrays = true;
+      out << c_type(type_of(pr->type)) << "* " << (restr.at(f)[i]? "restrict " : "") << pr->name
+          << ", long long " << pr->name << "__n";
+      if(pr->rank == 2) out << ", long long " << pr->name << "__m";
+    }
+    out << ")";
+  }
+};
+
+} // namespace
+
+std::string gen_c_code(Program* p, std::ostream* report){
   std::ostringstream out;
-  out << "#include <stdio.h>\n\n";
+  auto restr = restrict_params(p);
+  CEmitter em(out, restr);
+  em.report = report;
 
   // forward-декларації
   for(auto* it : p->items){
-    if(auto* f = dynamic_cast<FuncDefNode*>(it)){
-      out << c_type(f->retType) << " " << f->name << "(";
-      size_t n = f->params? f->params->params.size() : 0;
-      for(size_t i=0;i<n;++i){
-        if(i) out << ", ";
-        auto* pr = f->params->params[i];
-        out << c_type(pr->type) << " " << pr->name;
-      }
-      out << ");\n";
-    }
+    if(it->kind == NodeKind::FuncDef){ em.signature(as<FuncDefNode>(it)); out << ";\n"; }
   }
   out << "\n";
 
   // тіла функцій
   for(auto* it : p->items){
-    if(auto* f = dynamic_cast<FuncDefNode*>(it)){
-      out << c_type(f->retType) << " " << f->name << "(";
-      size_t n = f->params? f->params->params.size() : 0;
-      for(size_t i=0;i<n;++i){
-        if(i) out << ", ";
-        auto* pr = f->params->params[i];
-        out << c_type(pr->type) << " " << pr->name;
-      }
-      out << ")\n";
-      emit_block(out, f->body, 0);
+    if(it->kind == NodeKind::FuncDef){
+      auto* f = as<FuncDefNode>(it);
+      em.fn = f;
+      em.signature(f); out << "\n";
+      em.block(f->body, 0);
       out << "\n";
     }
   }
-  return out.str();
+  std::string head = "#include <stdbool.h>\n#include <stdio.h>\n";
+  head += em.arrays? C_ARRAY_RUNTIME : "\n";
+  return head + out.str();
 }
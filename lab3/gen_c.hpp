@@ -1,5 +1,13 @@
 #pragma once
 #include "ast.hpp"
+#include <ostream>
 #include <string>
 
-std::string gen_c_code(Program* p);
+/* p має бути типізована typecheck_program: типи C, цілочисельне ділення
+   й явні перетворення беруться з анотацій. Параметри-масиви стають restrict,
+   якщо жоден виклик не передає той самий масив двічі. Цикл for без залежностей
+   між ітераціями, що містить вкладений цикл чи виклик чистої функції, стає
+   #pragma omp parallel for (з reduction для int-сум і добутків), інший такий
+   цикл — #pragma omp simd; збирати з -fopenmp -fwrapv. report (якщо не null)
+   отримує по рядку на кожен цикл: func:line: for i: рішення або причина відмови */
+std::string gen_c_code(Program* p, std::ostream* report = nullptr);
@@ -0,0 +1,465 @@
+#include "jit.hpp"
+#include "eval.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define JIT_X86_64 1
+#endif
+
+ExecBuffer& ExecBuffer::operator=(ExecBuffer&& o) noexcept {
+    if(this != &o){ this->~ExecBuffer(); mem = o.mem; size = o.size; o.mem = nullptr; o.size = 0; }
+    return *this;
+}
+
+ExecBuffer::~ExecBuffer(){
+#ifdef JIT_X86_64
+    if(mem) munmap(mem, size);
+#endif
+}
+
+#ifndef JIT_X86_64
+
+bool jit_compile(World&, Func&){ return false; }
+
+#else
+
+/* Виклик з native-коду в іншу функцію: або її native-версія, або інтерпретатор.
+   Виняток не можна кидати крізь згенеровані кадри (у них немає unwind-інфо),
+   тому він зберігається у World, а native-код після кожного виклику
+   перевіряє jit_error і одразу виходить. Функції, що можуть залишити
+   відкладений хвостовий виклик, і перевищення глибини йдуть через call_func. */
+static uint64_t jit_call(World* w, Func* f, const Value* args){
+    if(f->native && !f->native_tail && w->depth < w->max_depth && (const char*)__builtin_frame_address(0) >= w->stack_limit){
+        w->depth++;
+        uint64_t r = f->native(w, args);
+        w->depth--;
+        return r;
+    }
+    try {
+        return call_func(*w, *f, args).bits();
+    } catch(...) {
+        w->jit_exc = std::current_exception();
+        w->jit_error = true;
+        return 0;
+    }
+}
+
+/* return g(...) з native-коду: аргументи переносяться на стек World,
+   а сам виклик виконає run_frame у кадрі, що звільняється */
+static void jit_tail(World* w, Func* f, const Value* args){
+    size_t n = f->def->params? f->def->params->params.size() : 0;
+    try { w->ensure(w->sp + n); } catch(...) {
+        w->jit_exc = std::current_exception();
+        w->jit_error = true;
+        return;
+    }
+    std::copy(args, args + n, w->stack.begin() + w->sp);
+    w->tail_args = w->sp;
+    w->tail = f;
+}
+
+static void jit_depth_error(World* w){
+    try { depth_error(*w); } catch(...) { w->jit_exc = std::current_exception(); }
+    w->jit_error = true;
+}
+
+/* Ділення int на нуль: та сама помилка, що й в інтерпретаторі */
+static void jit_div_zero(World* w){
+    w->jit_exc = std::make_exception_ptr(std::runtime_error("Division by zero"));
+    w->jit_error = true;
+}
+
+namespace {
+
+/*
+ * Кадр native-функції (зміщення від rbp):
+ *   [rbp-8]                 World*
+ *   [rbp-16-8*s]            слот змінної s (як у resolve_program)
+ *   [rbp-tb-8*d]            тимчасове значення глибини d; аргументи виклику
+ *                           займають сусідні тимчасові і лежать за зростанням адрес
+ * Результат виразу int/bool — у rax (bool як 0/1), double — у xmm0.
+ * Слоти й тимчасові зберігають сирі 8 байтів Value.
+ */
+struct Emitter {
+    World& w;
+    Func& self;
+    FuncDefNode* f;
+    std::vector<uint8_t> c;
+    int tb, depth=0, maxdepth=0;
+    size_t frame_at=0, entry=0;
+    bool direct_self=true; // false, якщо є return g(...): самовиклик теж може лишити хвостовий виклик
+    bool has_tail=false;
+    std::vector<size_t> to_epilogue;
+
+    Emitter(World& W, Func& F): w(W), self(F), f(F.def), tb(16 + 8*F.def->nslots){}
+
+    void b(std::initializer_list<uint8_t> bytes){ c.insert(c.end(), bytes); }
+    void u32(uint32_t v){ for(int i=0;i<4;++i) c.push_back((uint8_t)(v >> (8*i))); }
+    void u64(uint64_t v){ for(int i=0;i<8;++i) c.push_back((uint8_t)(v >> (8*i))); }
+    void patch32(size_t at, uint32_t v){ for(int i=0;i<4;++i) c[at+i] = (uint8_t)(v >> (8*i)); }
+    size_t here() const { return c.size(); }
+    void bind(size_t rel_at, size_t target){ patch32(rel_at, (uint32_t)((int64_t)target - (int64_t)(rel_at + 4))); }
+
+    static int slot_off(int s){ return -16 - 8*s; }
+    int temp_off(int d) const { return -tb - 8*d; }
+    int push_temp(){ int d = depth++; if(depth > maxdepth) maxdepth = depth; return d; }
+
+    // --- інструкції ---
+    void movsd_load(int x, int disp){ b({0xF2, 0x0F, 0x10, (uint8_t)(0x85 | (x<<3))}); u32(disp); }   // movsd xmmX, [rbp+disp]
+    void movsd_store(int disp, int x){ b({0xF2, 0x0F, 0x11, (uint8_t)(0x85 | (x<<3))}); u32(disp); }  // movsd [rbp+disp], xmmX
+    void mov_load(int disp){ b({0x48, 0x8B, 0x85}); u32(disp); }                                      // mov rax, [rbp+disp]
+    void mov_store(int disp){ b({0x48, 0x89, 0x85}); u32(disp); }                                     // mov [rbp+disp], rax
+    void sse(uint8_t pfx, uint8_t op, int dst, int src){ b({pfx, 0x0F, op, (uint8_t)(0xC0 | (dst<<3) | src)}); }
+    void mov_rax_imm(uint64_t v){ b({0x48, 0xB8}); u64(v); }
+    void movq_x_rax(int x){ b({0x66, 0x48, 0x0F, 0x6E, (uint8_t)(0xC0 | (x<<3))}); }                 // movq xmmX, rax
+    void movq_rax_x(int x){ b({0x66, 0x48, 0x0F, 0x7E, (uint8_t)(0xC0 | (x<<3))}); }                 // movq rax, xmmX
+    void load_double(double v){ uint64_t bits; std::memcpy(&bits, &v, 8); mov_rax_imm(bits); movq_x_rax(0); }
+    void zero(int x){ sse(0x66, 0x57, x, x); }                       // xorpd xmmX, xmmX
+    void setcc_rax(uint8_t cc){ b({0x0F, cc, 0xC0, 0x0F, 0xB6, 0xC0}); } // setcc al; movzx eax, al
+    size_t jcc(uint8_t cc){ b({0x0F, cc}); size_t at = here(); u32(0); return at; }
+    size_t jmp(){ b({0xE9}); size_t at = here(); u32(0); return at; }
+    void jmp_to(size_t target){ bind(jmp(), target); }
+
+    /* значення типу t між регістром результату і кадром */
+    void load(Type t, int disp){ if(t == Type::Double) movsd_load(0, disp); else mov_load(disp); }
+    void store(Type t, int disp){ if(t == Type::Double) movsd_store(disp, 0); else mov_store(disp); }
+
+    /* умова (bool 0/1 у rax): перехід, коли хибна / істинна */
+    size_t jump_if_false(){ b({0x48, 0x85, 0xC0}); return jcc(0x84); } // test rax, rax; je
+    size_t jump_if_true(){ b({0x48, 0x85, 0xC0}); return jcc(0x85); }  // test rax, rax; jne
+
+    /* маска порівняння SSE у xmmX -> bool 0/1 у rax */
+    void mask_to_bool(int x){ movq_rax_x(x); b({0x83, 0xE0, 0x01}); } // and eax, 1
+
+    void call_helper(const void* fn){ mov_rax_imm((uint64_t)(uintptr_t)fn); b({0xFF, 0xD0}); } // call rax
+    void load_world_rdi(){ b({0x48, 0x8B, 0xBD}); u32((uint32_t)-8); }                        // mov rdi, [rbp-8]
+
+    /* дільник у rcx == 0 -> jit_div_zero і вихід */
+    void check_div_zero(){
+        b({0x48, 0x85, 0xC9});                                       // test rcx, rcx
+        size_t ok = jcc(0x85);                                       // jne ok
+        load_world_rdi(); call_helper((const void*)&jit_div_zero);
+        to_epilogue.push_back(jmp());
+        bind(ok, here());
+    }
+
+    /* rcx як регістр адреси: rax може тримати результат виклику */
+    void check_error(){
+        b({0x48, 0xB9}); u64((uint64_t)(uintptr_t)&w.jit_error);    // mov rcx, &jit_error
+        b({0x80, 0x39, 0x00});                                       // cmp byte [rcx], 0
+        to_epilogue.push_back(jcc(0x85));                            // jne epilogue
+    }
+
+    /* a у rax, b у rcx */
+    bool int_bin(Op op){
+        switch(op){
+        case Op::Add: b({0x48, 0x01, 0xC8}); return true;           // add rax, rcx
+        case Op::Sub: b({0x48, 0x29, 0xC8}); return true;           // sub rax, rcx
+        case Op::Mul: b({0x48, 0x0F, 0xAF, 0xC1}); return true;     // imul rax, rcx
+        case Op::Div: case Op::Mod: {
+            check_div_zero();
+            b({0x48, 0x83, 0xF9, 0xFF});                             // cmp rcx, -1
+            size_t normal = jcc(0x85);
+            if(op == Op::Div) b({0x48, 0xF7, 0xD8});                 // neg rax (INT64_MIN лишається собою)
+            else b({0x31, 0xC0});                                    // xor eax, eax
+            size_t done = jmp();
+            bind(normal, here());
+            b({0x48, 0x99, 0x48, 0xF7, 0xF9});                       // cqo; idiv rcx
+            if(op == Op::Mod) b({0x48, 0x89, 0xD0});                 // mov rax, rdx
+            bind(done, here());
+            return true;
+        }
+        case Op::Lt: case Op::Gt: case Op::Le: case Op::Ge: case Op::Eq: case Op::Ne: {
+            b({0x48, 0x39, 0xC8});                                   // cmp rax, rcx
+            static const uint8_t cc[] = { 0x9C, 0x9F, 0x9E, 0x9D, 0x94, 0x95 }; // setl setg setle setge sete setne
+            setcc_rax(cc[(int)op - (int)Op::Lt]);
+            return true;
+        }
+        default: return false;
+        }
+    }
+
+    /* a у xmm0, b у xmm1 */
+    bool double_bin(Op op){
+        switch(op){
+        case Op::Add: sse(0xF2, 0x58, 0, 1); return true;
+        case Op::Sub: sse(0xF2, 0x5C, 0, 1); return true;
+        case Op::Mul: sse(0xF2, 0x59, 0, 1); return true;
+        case Op::Div: sse(0xF2, 0x5E, 0, 1); return true;
+        case Op::Lt: b({0xF2, 0x0F, 0xC2, 0xC1, 0x01}); mask_to_bool(0); return true; // cmpltsd xmm0, xmm1
+        case Op::Le: b({0xF2, 0x0F, 0xC2, 0xC1, 0x02}); mask_to_bool(0); return true; // cmplesd
+        case Op::Eq: b({0xF2, 0x0F, 0xC2, 0xC1, 0x00}); mask_to_bool(0); return true; // cmpeqsd
+        case Op::Ne: b({0xF2, 0x0F, 0xC2, 0xC1, 0x04}); mask_to_bool(0); return true; // cmpneqsd
+        case Op::Gt: b({0xF2, 0x0F, 0xC2, 0xC8, 0x01}); mask_to_bool(1); return true; // cmpltsd xmm1, xmm0
+        case Op::Ge: b({0xF2, 0x0F, 0xC2, 0xC8, 0x02}); mask_to_bool(1); return true; // cmplesd xmm1, xmm0
+        default: return false;
+        }
+    }
+
+    /* аргументи виклику в сусідні тимчасові за зростанням адрес; повертає зміщення
+       першого (0 — не вдалося). Тимчасові звільняє той, хто викликає */
+    int args(CallNode* call){
+        size_t n = call->args? call->args->args.size() : 0;
+        int base = depth;
+        for(size_t i=0;i<n;++i) push_temp();
+        for(size_t i=0;i<n;++i){
+            ExprNode* a = call->args->args[i];
+            if(!expr(a)) return 0;
+            store(a->type, temp_off(base + (int)(n-1-i)));
+        }
+        return temp_off(base + (int)n - 1);
+    }
+
+    /* чи є в тілі return g(...) з g != self */
+    bool foreign_tail(AST* n){
+        if(!n) return false;
+        switch(n->kind){
+        case NodeKind::Return: {
+            CallNode* c = tail_call(as<ReturnNode>(n));
+            return c && &w.funcs[c->target->id] != &self;
+        }
+        case NodeKind::If: return foreign_tail(as<IfNode>(n)->thenN) || foreign_tail(as<IfNode>(n)->elseN);
+        case NodeKind::While: return foreign_tail(as<WhileNode>(n)->body);
+        case NodeKind::For: return foreign_tail(as<ForNode>(n)->body);
+        case NodeKind::Block:
+            for(auto* s: as<BlockNode>(n)->stmts) if(foreign_tail(s)) return true;
+            return false;
+        default: return false;
+        }
+    }
+
+    bool expr(ExprNode* e){
+        switch(e->kind){
+        case NodeKind::Number: {
+            auto* num = as<NumberNode>(e);
+            if(num->type == Type::Int) mov_rax_imm((uint64_t)num->i); else load_double(num->v);
+            return true;
+        }
+        case NodeKind::Bool: mov_rax_imm(as<BoolNode>(e)->v? 1 : 0); return true;
+        case NodeKind::VarRef: load(e->type, slot_off(as<VarRefNode>(e)->slot)); return true;
+        case NodeKind::Assign: {
+            auto* a = as<AssignNode>(e);
+            if(!expr(a->rhs)) return false;
+            store(a->type, slot_off(a->slot));
+            return true;
+        }
+        case NodeKind::Cast: {
+            auto* cn = as<CastNode>(e);
+            if(!expr(cn->x)) return false;
+            bool from_d = cn->x->type == Type::Double;
+            switch(cn->type){
+            case Type::Bool:
+                if(from_d){ zero(1); b({0xF2, 0x0F, 0xC2, 0xC1, 0x04}); mask_to_bool(0); } // cmpneqsd xmm0, xmm1
+                else { b({0x48, 0x85, 0xC0}); setcc_rax(0x95); }    // test rax, rax; setne
+                return true;
+            case Type::Int:
+                if(from_d) b({0xF2, 0x48, 0x0F, 0x2C, 0xC0});       // cvttsd2si rax, xmm0 (як d2i)
+                return true;                                         // bool -> int: те саме 0/1
+            case Type::Double:
+                if(!from_d) b({0xF2, 0x48, 0x0F, 0x2A, 0xC0});      // cvtsi2sd xmm0, rax
+                return true;
+            default: return false;
+            }
+        }
+        case NodeKind::UnaryOp: {
+            auto* u = as<UnaryOpNode>(e);
+            if(!expr(u->x)) return false;
+            if(u->op == Op::Not) b({0x83, 0xF0, 0x01});              // xor eax, 1
+            else if(u->type == Type::Double){ mov_rax_imm(0x8000000000000000ull); movq_x_rax(1); sse(0x66, 0x57, 0, 1); }
+            else b({0x48, 0xF7, 0xD8});                              // neg rax
+            return true;
+        }
+        case NodeKind::BinOp: {
+            auto* bo = as<BinOpNode>(e);
+            if(bo->op == Op::And || bo->op == Op::Or){
+                // bool лише 0/1: при короткому замиканні rax уже містить результат
+                if(!expr(bo->a)) return false;
+                size_t j = bo->op == Op::And? jump_if_false() : jump_if_true();
+                if(!expr(bo->b)) return false;
+                bind(j, here());
+                return true;
+            }
+            Type t = bo->a->type;
+            if(!expr(bo->a)) return false;
+            int tmp = push_temp();
+            store(t, temp_off(tmp));
+            if(!expr(bo->b)) return false;
+            depth--;
+            if(t == Type::Double){
+                sse(0x66, 0x28, 1, 0);                               // movapd xmm1, xmm0
+                movsd_load(0, temp_off(tmp));
+                return double_bin(bo->op);
+            }
+            b({0x48, 0x89, 0xC1});                                   // mov rcx, rax
+            mov_load(temp_off(tmp));
+            return int_bin(bo->op);
+        }
+        case NodeKind::Call: {
+            auto* call = as<CallNode>(e);
+            Func* callee = &w.funcs[call->target->id];
+            int argv = args(call);
+            if(argv == 0) return false;
+            if(callee == &self && direct_self){
+                // самовиклик напряму: глибину рахуємо тут, бо run_frame його не бачить
+                b({0x48, 0xB9}); u64((uint64_t)(uintptr_t)&w.depth);     // mov rcx, &depth
+                b({0x8B, 0x01});                                         // mov eax, [rcx]
+                b({0x3B, 0x81}); u32((uint32_t)((char*)&w.max_depth - (char*)&w.depth)); // cmp eax, [rcx+max_depth]
+                size_t deep = jcc(0x83);                                 // jae deep
+                b({0x48, 0xBA}); u64((uint64_t)(uintptr_t)&w.stack_limit); // mov rdx, &stack_limit
+                b({0x48, 0x3B, 0x22});                                   // cmp rsp, [rdx]
+                size_t ok = jcc(0x83);                                   // jae ok
+                bind(deep, here());
+                load_world_rdi(); call_helper((const void*)&jit_depth_error);
+                to_epilogue.push_back(jmp());
+                bind(ok, here());
+                b({0xFF, 0x01});                                         // inc dword [rcx]
+                load_world_rdi();
+                b({0x48, 0x8D, 0xB5}); u32(argv);                        // lea rsi, [rbp+argv]
+                b({0xE8}); size_t at = here(); u32(0); bind(at, 0);      // call self
+                b({0x48, 0xB9}); u64((uint64_t)(uintptr_t)&w.depth);     // mov rcx, &depth
+                b({0xFF, 0x09});                                         // dec dword [rcx]
+            } else {
+                load_world_rdi();
+                b({0x48, 0xBE}); u64((uint64_t)(uintptr_t)callee);        // mov rsi, callee
+                b({0x48, 0x8D, 0x95}); u32(argv);                        // lea rdx, [rbp+argv]
+                call_helper((const void*)&jit_call);
+            }
+            depth -= (int)(call->args? call->args->args.size() : 0);
+            check_error();
+            if(call->type == Type::Double) movq_x_rax(0);
+            return true;
+        }
+        default: return false;
+        }
+    }
+
+    bool stmt(AST* n){
+        if(!n) return true;
+        switch(n->kind){
+        case NodeKind::Decl: {
+            auto* d = as<DeclNode>(n);
+            if(d->rank) return false; // масиви лишаються інтерпретатору
+            if(!expr(d->init)) return false;
+            store(d->init->type, slot_off(d->slot));
+            return true;
+        }
+        case NodeKind::ExprStmt: return expr(as<ExprStmtNode>(n)->expr);
+        case NodeKind::Return: {
+            auto* r = as<ReturnNode>(n);
+            if(CallNode* call = tail_call(r)){
+                // хвостовий виклик: собі — перехід на початок з новими параметрами,
+                // іншій функції — через jit_tail, виклик завершить run_frame
+                Func* callee = &w.funcs[call->target->id];
+                int argv = args(call);
+                if(argv == 0) return false;
+                depth -= (int)(call->args? call->args->args.size() : 0);
+                if(callee == &self){
+                    b({0x48, 0x8D, 0xB5}); u32(argv);                    // lea rsi, [rbp+argv]
+                    jmp_to(entry);
+                } else {
+                    load_world_rdi();
+                    b({0x48, 0xBE}); u64((uint64_t)(uintptr_t)callee);    // mov rsi, callee
+                    b({0x48, 0x8D, 0x95}); u32(argv);                    // lea rdx, [rbp+argv]
+                    call_helper((const void*)&jit_tail);
+                    to_epilogue.push_back(jmp());
+                    has_tail = true;
+                }
+                return true;
+            }
+            if(!expr(r->expr)) return false;
+            if(r->expr->type == Type::Double) movq_rax_x(0);
+            to_epilogue.push_back(jmp());
+            return true;
+        }
+        case NodeKind::If: {
+            auto* iff = as<IfNode>(n);
+            if(!expr(iff->cond)) return false;
+            size_t jf = jump_if_false();
+            if(!stmt(iff->thenN)) return false;
+            if(iff->elseN){
+                size_t je = jmp();
+                bind(jf, here());
+                if(!stmt(iff->elseN)) return false;
+                bind(je, here());
+            } else bind(jf, here());
+            return true;
+        }
+        case NodeKind::While: {
+            auto* wh = as<WhileNode>(n);
+            size_t top = here();
+            if(!expr(wh->cond)) return false;
+            size_t jf = jump_if_false();
+            if(!stmt(wh->body)) return false;
+            jmp_to(top);
+            bind(jf, here());
+            return true;
+        }
+        case NodeKind::For: {
+            auto* fr = as<ForNode>(n);
+            if(fr->parallel) return false; // пул потоків — лише в інтерпретаторі
+            if(fr->init && !expr(fr->init)) return false;
+            size_t top = here(), jf = 0;
+            bool has_cond = fr->cond != nullptr;
+            if(has_cond){ if(!expr(fr->cond)) return false; jf = jump_if_false(); }
+            if(!stmt(fr->body)) return false;
+            if(fr->step && !expr(fr->step)) return false;
+            jmp_to(top);
+            if(has_cond) bind(jf, here());
+            return true;
+        }
+        case NodeKind::Block:
+            for(auto* s: as<BlockNode>(n)->stmts) if(!stmt(s)) return false;
+            return true;
+        default: return false;
+        }
+    }
+
+    bool function(){
+        direct_self = !foreign_tail(f->body);
+        b({0x55});                                                   // push rbp
+        b({0x48, 0x89, 0xE5});                                       // mov rbp, rsp
+        b({0x48, 0x81, 0xEC}); frame_at = here(); u32(0);            // sub rsp, frame
+        b({0x48, 0x89, 0xBD}); u32((uint32_t)-8);                    // mov [rbp-8], rdi
+        entry = here();                                              // сюди переходить хвостовий самовиклик (rsi — аргументи)
+        b({0x31, 0xC0});                                             // xor eax, eax
+        for(int s=0; s<f->nslots; ++s) mov_store(slot_off(s));
+        if(f->params){
+            int i = 0;
+            for(auto* p: f->params->params){
+                b({0x48, 0x8B, 0x86}); u32(8*i++);                   // mov rax, [rsi+8*i]
+                mov_store(slot_off(p->slot));
+            }
+        }
+        if(!stmt(f->body)) return false;
+        b({0x31, 0xC0});                                             // вихід без return -> нуль будь-якого типу
+        size_t epi = here();
+        for(auto at: to_epilogue) bind(at, epi);
+        b({0x48, 0x89, 0xEC});                                       // mov rsp, rbp
+        b({0x5D, 0xC3});                                             // pop rbp; ret
+        uint32_t frame = (uint32_t)(tb + 8*maxdepth + 15) & ~15u;
+        patch32(frame_at, frame);
+        return true;
+    }
+};
+
+} // namespace
+
+bool jit_compile(World& w, Func& f){
+    Emitter em(w, f);
+    if(!em.function()) return false;
+    size_t size = (em.c.size() + 4095) & ~(size_t)4095;
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mem == MAP_FAILED) return false;
+    std::memcpy(mem, em.c.data(), em.c.size());
+    if(mprotect(mem, size, PROT_READ | PROT_EXEC) != 0){ munmap(mem, size); return false; }
+    w.jit_code.emplace_back(mem, size);
+    f.native_tail = em.has_tail;
+    f.native = reinterpret_cast<JitFn>(mem);
+    return true;
+}
+
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Другий рівень виконання для дерев'яного інтерпретатора: гарячі функції
+ * (лічильники викликів і зворотних переходів циклів у call_func/exec_node)
+ * компілюються в машинний код x86-64. Типи беруться зі статичних анотацій:
+ * int і bool (0/1) живуть у rax, double — у xmm0; слоти кадру зберігають
+ * ті самі 8 байтів, що й Value, тож аргументи передаються без перетворень.
+ * На інших платформах jit_compile завжди повертає false.
+ */
+
+struct World;
+struct Func;
+struct Value;
+
+/* Скомпільована функція: аргументи — масив Value, результат — біти Value у rax */
+using JitFn = uint64_t(*)(World* w, const Value* args);
+
+enum class JitMode { Off, Hot, All };
+
+constexpr uint32_t JIT_HOT_CALLS = 1000;
+constexpr uint32_t JIT_HOT_BACKEDGES = 10000;
+
+/* Сторінки з машинним кодом (RX), звільняються разом із World */
+struct ExecBuffer {
+    void* mem = nullptr;
+    size_t size = 0;
+    ExecBuffer() = default;
+    ExecBuffer(void* m, size_t s): mem(m), size(s){}
+    ExecBuffer(ExecBuffer&& o) noexcept: mem(o.mem), size(o.size){ o.mem = nullptr; o.size = 0; }
+    ExecBuffer& operator=(ExecBuffer&& o) noexcept;
+    ExecBuffer(const ExecBuffer&) = delete;
+    ExecBuffer& operator=(const ExecBuffer&) = delete;
+    ~ExecBuffer();
+};
+
+/* Компілює f і записує вказівник у f.native; false — функцію не підтримано */
+bool jit_compile(World& w, Func& f);
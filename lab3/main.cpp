@@ -1,3 +1,4 @@
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -10,56 +11,216 @@
 #include "eval.hpp"
 #include "ast_dot.hpp"
 #include "gen_c.hpp"
-
-// з bison
-int yyparse();
-extern std::unique_ptr<Program> g_program;
-extern FILE* yyin;
+#include "bytecode.hpp"
+#include "vm.hpp"
+#include "parse.hpp"
+#include "pipeline.hpp"
 
 int main(int argc, char** argv) {
     if (argc < 2) {
-        std::cerr << "Usage: ./mini_cpp <source.mc++> [--run] [--emit-c]\n";
+        std::cerr << "Usage: ./mini_cpp <source.mc++> [--run [--vm] [-jN]] [--emit-c [--par-report]] [-O0|-O1|-O2] [--opt-stats] [--jit=off|hot|all] [--max-depth=N] [--memoize[=N]] [--profile[=FILE]] [--lexer=flex|fast] [--lex-only] [--ast-cache] [--timings]\n"
+                  << "       ./mini_cpp <source.mc++> --dump-ast[=FILE|-] [--ast-format=dot|text|json] [--dump-depth=N] [--dump-nodes=N]\n"
+                  << "       ./mini_cpp <a.mc++> <b.mc++>... [--emit-c [--par-report]] [-O0|-O1|-O2] [-jN] [--lexer=flex|fast] [--ast-cache] [--timings]\n";
         return 1;
     }
 
-    // аргументи
-    const char* src = argv[1];
+    // аргументи: усе, що не починається з '-', — вихідні файли
+    std::vector<const char*> sources;
+    unsigned jobs = 0;
     bool do_run = false;
     bool do_emit_c = false;
-    for (int i = 2; i < argc; ++i) {
+    bool use_vm = false;
+    int opt_level = 0;
+    bool opt_stats = false;
+    JitMode jit_mode = JitMode::Hot;
+    uint32_t max_depth = DEFAULT_MAX_DEPTH;
+    size_t memo_size = 0;
+    const char* profile_out = nullptr;
+    bool timings = false;
+    bool par_report = false;
+    LexerKind lexer = LexerKind::Flex;
+    bool lex_only = false;
+    bool ast_cache = false;
+    const char* dump_out = nullptr;
+    AstDumpOptions dump;
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] != '-') sources.push_back(argv[i]);
+        if (std::strncmp(argv[i], "-j", 2) == 0) {
+            long v = std::strtol(argv[i] + 2, nullptr, 10);
+            if (v <= 0) {
+                std::cerr << "Invalid -j value: " << (argv[i] + 2) << "\n";
+                return 1;
+            }
+            jobs = (unsigned)v;
+        }
         if (std::string(argv[i]) == "--run") do_run = true;
         if (std::string(argv[i]) == "--emit-c") do_emit_c = true;
+        if (std::string(argv[i]) == "--vm") use_vm = true;
+        if (std::string(argv[i]) == "-O0") opt_level = 0;
+        if (std::string(argv[i]) == "-O1") opt_level = 1;
+        if (std::string(argv[i]) == "-O2") opt_level = 2;
+        if (std::string(argv[i]) == "--opt-stats") opt_stats = true;
+        if (std::string(argv[i]) == "--jit=off") jit_mode = JitMode::Off;
+        if (std::string(argv[i]) == "--jit=hot") jit_mode = JitMode::Hot;
+        if (std::string(argv[i]) == "--jit=all") jit_mode = JitMode::All;
+        if (std::strncmp(argv[i], "--max-depth=", 12) == 0) {
+            long v = std::strtol(argv[i] + 12, nullptr, 10);
+            if (v <= 0) {
+                std::cerr << "Invalid --max-depth value: " << (argv[i] + 12) << "\n";
+                return 1;
+            }
+            max_depth = (uint32_t)v;
+        }
+        if (std::string(argv[i]) == "--memoize") memo_size = MEMO_DEFAULT_SIZE;
+        if (std::strncmp(argv[i], "--memoize=", 10) == 0) {
+            long v = std::strtol(argv[i] + 10, nullptr, 10);
+            if (v <= 0) {
+                std::cerr << "Invalid --memoize value: " << (argv[i] + 10) << "\n";
+                return 1;
+            }
+            memo_size = (size_t)v;
+        }
+        if (std::string(argv[i]) == "--profile") profile_out = "profile.folded";
+        if (std::strncmp(argv[i], "--profile=", 10) == 0) profile_out = argv[i] + 10;
+        if (std::string(argv[i]) == "--timings") timings = true;
+        if (std::string(argv[i]) == "--par-report") par_report = true;
+        if (std::string(argv[i]) == "--lexer=flex") lexer = LexerKind::Flex;
+        if (std::string(argv[i]) == "--lexer=fast") lexer = LexerKind::Fast;
+        if (std::string(argv[i]) == "--lex-only") lex_only = true;
+        if (std::string(argv[i]) == "--ast-cache") ast_cache = true;
+        if (std::string(argv[i]) == "--dump-ast") dump_out = "";
+        if (std::strncmp(argv[i], "--dump-ast=", 11) == 0) dump_out = argv[i] + 11;
+        if (std::string(argv[i]) == "--ast-format=dot") dump.format = AstFormat::Dot;
+        if (std::string(argv[i]) == "--ast-format=text") dump.format = AstFormat::Text;
+        if (std::string(argv[i]) == "--ast-format=json") dump.format = AstFormat::Json;
+        if (std::strncmp(argv[i], "--dump-depth=", 13) == 0) {
+            long v = std::strtol(argv[i] + 13, nullptr, 10);
+            if (v <= 0) {
+                std::cerr << "Invalid --dump-depth value: " << (argv[i] + 13) << "\n";
+                return 1;
+            }
+            dump.max_depth = (uint32_t)v;
+        }
+        if (std::strncmp(argv[i], "--dump-nodes=", 13) == 0) {
+            long v = std::strtol(argv[i] + 13, nullptr, 10);
+            if (v <= 0) {
+                std::cerr << "Invalid --dump-nodes value: " << (argv[i] + 13) << "\n";
+                return 1;
+            }
+            dump.max_nodes = (size_t)v;
+        }
     }
 
-    // відкрити вхід
-    yyin = std::fopen(src, "r");
-    if (!yyin) {
-        perror("fopen");
+    // --timings: тривалість кожної фази рядком "timing <фаза> <мс>" у stderr (для bench/run.sh)
+    auto t0 = std::chrono::steady_clock::now();
+    auto phase = [&](const char* name) {
+        auto t = std::chrono::steady_clock::now();
+        if (timings)
+            std::fprintf(stderr, "timing %s %.3f\n", name, std::chrono::duration<double, std::milli>(t - t0).count());
+        t0 = t;
+    };
+
+    if (sources.empty()) {
+        std::cerr << "No source file given\n";
         return 1;
     }
+    // профілюється лише дерев'яний інтерпретатор: native-код і VM не рахують інструкцій
+    if (profile_out && use_vm) {
+        std::cerr << "--profile is not supported with --vm\n";
+        return 1;
+    }
+    // кілька файлів: розбір, перевірка і C паралельно, без виконання й вивантаження AST
+    if (sources.size() > 1) {
+        if (do_run || profile_out || dump_out) {
+            std::cerr << "--run, --profile and --dump-ast take a single source file\n";
+            return 1;
+        }
+        BatchOptions bo;
+        bo.opt_level = opt_level;
+        bo.emit_c = do_emit_c;
+        bo.par_report = par_report;
+        bo.jobs = jobs;
+        bo.lexer = lexer;
+        bo.ast_cache = ast_cache;
+        int rc = compile_batch(sources, bo, std::cerr);
+        phase("batch");
+        return rc;
+    }
+    const char* src = sources[0];
 
-    // парсинг
-    if (yyparse() != 0) {
-        std::cerr << "Parse failed\n";
-        std::fclose(yyin);
+    // --lex-only: лише токени (для bench/lexer.sh) — кількість і хеш потоку
+    if (lex_only) {
+        LexStats st;
+        std::string err;
+        if (!lex_file(src, lexer, st, err)) {
+            std::cerr << err;
+            return 2;
+        }
+        phase("lex");
+        std::printf("tokens %lld hash %016llx\n", st.tokens, (unsigned long long)st.hash);
+        return 0;
+    }
+
+    // парсинг (або --ast-cache: готовий AST з src.astc): вузли та імена в арені цієї програми
+    std::string parse_err;
+    bool cache_hit = false;
+    std::unique_ptr<Program> prog = load_program(src, parse_err, lexer, ast_cache, &cache_hit);
+    if (!prog) {
+        std::cerr << parse_err << "Parse failed\n";
         return 2;
     }
-    std::fclose(yyin);
+    std::cerr << parse_err; // попередження кешу
+    phase(cache_hit ? "cache-load" : "parse");
 
-    // Візуалізація AST -> ast.dot
-    {
-        std::ofstream out("ast.dot");
-        out << ast_to_dot(g_program.get());
+    // --dump-ast: AST до resolve пишеться у файл (чи stdout для "-") під час обходу
+    if (dump_out) {
+        static const char* default_out[] = {"ast.dot", "ast.txt", "ast.json"};
+        std::string path = *dump_out ? dump_out : default_out[(int)dump.format];
+        std::ofstream file;
+        if (path != "-") file.open(path, std::ios::binary);
+        std::ostream& out = path == "-" ? std::cout : file;
+        AstDumpStats st = dump_ast(out, prog.get(), dump);
+        out.flush();
+        if (!out) {
+            std::cerr << "Failed to write " << path << "\n";
+        } else if (path != "-") {
+            std::cerr << "AST written to " << path << " (" << st.nodes << " nodes";
+            if (st.elided) std::cerr << ", " << st.elided << " subtrees elided";
+            std::cerr << ")";
+            if (dump.format == AstFormat::Dot) std::cerr << " (use: dot -Tpng " << path << " -o ast.png)";
+            std::cerr << "\n";
+        }
+        phase("dump-ast");
     }
-    std::cerr << "AST written to ast.dot (use: dot -Tpng ast.dot -o ast.png)\n";
 
-    // Підготовка світу (функції, середовище)
-    World w;
-    collect_functions(w, g_program.get());
+    // Розв'язання змінних у слоти кадрів і перевірка типів (потрібні всім виконавцям);
+    // після оптимізації AST змінився, тому обидва проходи запускаються ще раз.
+    // Чистота функцій (для --memoize) — на остаточному AST
+    try {
+        check_program(prog.get(), opt_level, opt_stats ? &std::cerr : nullptr);
+        phase("check");
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 2;
+    }
+
+    // Підготовка світу (функції, стек кадрів)
+    FuncTable table = collect_functions(prog.get());
+    World w(table);
+    w.jit_mode = jit_mode;
+    w.max_depth = max_depth;
+    w.threads = jobs; // потоки для parallel for; 0 — усі ядра
+    Profiler prof;
+    if (profile_out && do_run) {
+        if (jit_mode != JitMode::Off) std::cerr << "note: JIT is disabled while profiling\n";
+        w.prof = &prof;
+        w.jit_mode = JitMode::Off;
+    }
+    enable_memo(w, memo_size);
 
     // Генерація C-коду (за потреби)
     if (do_emit_c) {
-        std::string code = gen_c_code(g_program.get());
+        std::string code = gen_c_code(prog.get(), par_report ? &std::cerr : nullptr);
         FILE* f = std::fopen("out.c", "wb");
         if (f) {
             std::fwrite(code.data(), 1, code.size(), f);
@@ -68,14 +229,37 @@ int main(int argc, char** argv) {
         } else {
             std::fprintf(stderr, "Failed to write out.c\n");
         }
+        phase("emit-c");
     }
 
-    // Виконання main() (за потреби)
+    // Виконання main() (за потреби): деревом AST або через байткод-VM
     if (do_run) {
         try {
             // виклик користувацької функції main без аргументів
-            Value ret = call_func(w, "main", {});
-            std::cout << "Program returned: " << ret.as_num() << "\n";
+            Value ret;
+            if (use_vm) {
+                BcProgram bp = compile_program(prog.get());
+                phase("compile-bc");
+                ret = vm_call(bp, "main", {}, max_depth);
+                phase("run");
+            } else {
+                ret = call_func(w, "main", {});
+                phase("run");
+                if (memo_size) print_memo_stats(std::cerr, w);
+                if (w.prof) {
+                    print_profile(std::cerr, prof, src);
+                    std::ofstream folded(profile_out);
+                    write_folded(folded, prof);
+                    std::cerr << "Folded stacks written to " << profile_out
+                              << " (use: flamegraph.pl --countname=ns " << profile_out << " > profile.svg)\n";
+                }
+            }
+            // Value не має тегу: друкуємо за статичним типом main (bool — як 1/0)
+            Func* mf = w.find("main");
+            if (mf && mf->def->ret == Type::Double)
+                std::cout << "Program returned: " << ret.d() << "\n";
+            else
+                std::cout << "Program returned: " << (long long)ret.i() << "\n";
         } catch (const std::exception& ex) {
             std::cerr << "Runtime error: " << ex.what() << "\n";
             return 3;
@@ -0,0 +1,27 @@
+#include "mapped_file.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile(){
+    if(mapped) munmap(const_cast<char*>(data_), size_);
+}
+
+bool MappedFile::open(const char* path, std::string& err){
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0){ err = std::string(path)+": "+std::strerror(errno)+"\n"; return false; }
+    struct stat st;
+    if(fstat(fd, &st) != 0){ err = std::string(path)+": "+std::strerror(errno)+"\n"; ::close(fd); return false; }
+    size_ = (size_t)st.st_size;
+    if(size_ == 0){ ::close(fd); return true; }
+    void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // відображення тримає файл саме
+    if(p == MAP_FAILED){ err = std::string(path)+": mmap: "+std::strerror(errno)+"\n"; size_ = 0; return false; }
+    madvise(p, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(p);
+    mapped = true;
+    return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/*
+ * Файл, відображений у пам'ять лише для читання (mmap, MADV_SEQUENTIAL):
+ * лексер читає байти напряму зі сторінкового кешу без fread і копій.
+ * Порожній файл дає порожній view без відображення. Не копіюється;
+ * view() живе, доки живий об'єкт.
+ */
+class MappedFile {
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped = false;
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    /* false і текст помилки в err, якщо файл не вдалося відкрити чи відобразити */
+    bool open(const char* path, std::string& err);
+    std::string_view view() const { return {data_, size_}; }
+};
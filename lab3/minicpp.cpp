@@ -0,0 +1,53 @@
+#include "minicpp.hpp"
+#include <stdexcept>
+#include <utility>
+
+#include "pipeline.hpp"
+
+CompiledProgram::CompiledProgram(std::unique_ptr<Program> p, const EngineOptions& o)
+    : prog_(std::move(p)), table_(collect_functions(prog_.get())), opts_(o){}
+
+std::shared_ptr<const CompiledProgram> CompiledProgram::check(std::unique_ptr<Program> p, const EngineOptions& o, std::string& err){
+    if(!p){ err += "Parse failed\n"; return nullptr; }
+    try {
+        check_program(p.get(), o.opt_level);
+    } catch(const std::exception& ex){
+        err += std::string("Error: ") + ex.what() + "\n";
+        return nullptr;
+    }
+    return std::shared_ptr<const CompiledProgram>(new CompiledProgram(std::move(p), o));
+}
+
+std::shared_ptr<const CompiledProgram> CompiledProgram::load(const char* path, const EngineOptions& o, std::string& err){
+    return check(load_program(path, err, o.lexer, o.ast_cache), o, err);
+}
+
+std::shared_ptr<const CompiledProgram> CompiledProgram::from_source(std::string_view src, const EngineOptions& o, std::string& err){
+    return check(parse_source(src, err, o.lexer), o, err);
+}
+
+size_t CompiledProgram::arity(int id) const {
+    auto* f = function(id);
+    return f->params? f->params->params.size() : 0;
+}
+
+Type CompiledProgram::param_type(int id, size_t i) const { return type_of(function(id)->params->params.at(i)->type); }
+int CompiledProgram::param_rank(int id, size_t i) const { return function(id)->params->params.at(i)->rank; }
+
+ExecContext::ExecContext(std::shared_ptr<const CompiledProgram> prog)
+    : prog_(std::move(prog)), w_(std::make_unique<World>(prog_->functions())){
+    const EngineOptions& o = prog_->options();
+    w_->jit_mode = o.jit_mode;
+    w_->max_depth = o.max_depth;
+    w_->threads = o.threads;
+    enable_memo(*w_, o.memo_size);
+}
+
+Value ExecContext::call(int id, const Value* args){
+    if(id < 0 || size_t(id) >= w_->funcs.size()) throw std::runtime_error("Unknown function id: "+std::to_string(id));
+    return call_func(*w_, w_->funcs[id], args);
+}
+
+Value ExecContext::call(std::string_view name, const std::vector<Value>& args){
+    return call_func(*w_, name, args);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast.hpp"
+#include "eval.hpp"
+#include "parse.hpp"
+
+/*
+ * libminicpp — вбудовування mc++ у застосунок (Makefile: libminicpp.a / .so).
+ * Програма компілюється один раз (розбір, resolve, typecheck, оптимізація,
+ * чистота) у CompiledProgram: після створення він незмінний, тож один
+ * shared_ptr ділять скільки завгодно потоків. Виконання — через ExecContext:
+ * власний World (стек кадрів, масиви, лічильники й native-код JIT, кеш
+ * мемоізації) поверх спільних AST і FuncTable. Контекст належить одному
+ * потоку; створюється дешево і живе довго — JIT і кеш прогріваються
+ * у ньому від виклику до виклику.
+ *
+ *   auto prog = CompiledProgram::load("rules.mc++", {}, err);
+ *   ExecContext ctx(prog);                       // у кожному потоці
+ *   int f = prog->find("score");
+ *   Value args[] = {Value::integer(3), Value::num(0.5)};
+ *   int64_t r = ctx.call(f, args).i();
+ *
+ * Помилки виконання (ділення на нуль, межа глибини, індекс) — std::runtime_error,
+ * після якого контекст придатний до наступних викликів.
+ */
+struct EngineOptions {
+    int opt_level = 1;
+    LexerKind lexer = LexerKind::Flex;
+    bool ast_cache = false;  // лише для load: <src>.astc, як --ast-cache
+    JitMode jit_mode = JitMode::Hot;
+    uint32_t max_depth = DEFAULT_MAX_DEPTH;
+    size_t memo_size = 0;    // записів кешу на чисту функцію, 0 — без мемоізації
+    unsigned threads = 0;    // потоків для parallel for у кожному ExecContext, 0 — усі ядра
+};
+
+class CompiledProgram {
+    std::unique_ptr<Program> prog_;
+    FuncTable table_;
+    EngineOptions opts_;
+    CompiledProgram(std::unique_ptr<Program> p, const EngineOptions& o);
+    static std::shared_ptr<const CompiledProgram> check(std::unique_ptr<Program> p, const EngineOptions& o, std::string& err);
+public:
+    /* nullptr і повідомлення в err, якщо розбір чи перевірка не вдалися */
+    static std::shared_ptr<const CompiledProgram> load(const char* path, const EngineOptions& o, std::string& err);
+    static std::shared_ptr<const CompiledProgram> from_source(std::string_view src, const EngineOptions& o, std::string& err);
+
+    /* id функції для ExecContext::call; -1 — немає такої */
+    int find(std::string_view name) const { return table_.find(name); }
+    size_t function_count() const { return table_.defs.size(); }
+    const FuncDefNode* function(int id) const { return table_.defs.at(size_t(id)); }
+    size_t arity(int id) const;
+    /* тип і ранг (0 — скаляр, 1/2 — масив) i-го параметра; тип результату */
+    Type param_type(int id, size_t i) const;
+    int param_rank(int id, size_t i) const;
+    Type return_type(int id) const { return function(id)->ret; }
+
+    const FuncTable& functions() const { return table_; }
+    const EngineOptions& options() const { return opts_; }
+};
+
+class ExecContext {
+    std::shared_ptr<const CompiledProgram> prog_;
+    std::unique_ptr<World> w_; // native-код JIT тримає адреси полів World, тож World не переміщується
+public:
+    explicit ExecContext(std::shared_ptr<const CompiledProgram> prog);
+
+    /* Виклик функції id з arity(id) аргументами; масиви передаються за
+       посиланням (Value::array), ними володіє викликач */
+    Value call(int id, const Value* args);
+    /* За іменем, з перевіркою кількості аргументів */
+    Value call(std::string_view name, const std::vector<Value>& args);
+
+    const CompiledProgram& program() const { return *prog_; }
+    World& world() { return *w_; }
+};
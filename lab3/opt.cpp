@@ -0,0 +1,707 @@
+#include "opt.hpp"
+#include "eval.hpp"
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <ostream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+bool is_const(ExprNode* e){ return e && (e->kind==NodeKind::Number || e->kind==NodeKind::Bool); }
+
+/* Значення літерала; читати його треба за e->type */
+Value const_of(ExprNode* e){
+    if(e->kind==NodeKind::Bool) return Value::boolean(as<BoolNode>(e)->v);
+    auto* n = as<NumberNode>(e);
+    return n->type == Type::Int? Value::integer(n->i) : Value::num(n->v);
+}
+bool const_true(ExprNode* e){ return const_of(e).b(); } // умови після typecheck_program — bool
+
+/* t — статичний тип значення v */
+ExprNode* make_const(Arena& a, const Value& v, Type t){
+    switch(t){
+    case Type::Bool: return a.make<BoolNode>(v.b());
+    case Type::Int: return a.make<NumberNode>(v.i());
+    default: return a.make<NumberNode>(v.d());
+    }
+}
+
+/* Без присвоєнь і викликів: вираз можна обчислити двічі, переставити або викинути */
+bool side_effect_free(ExprNode* e){
+    if(!e) return true;
+    switch(e->kind){
+    case NodeKind::Assign: case NodeKind::Call: case NodeKind::IndexAssign: return false;
+    case NodeKind::Index: return side_effect_free(as<IndexNode>(e)->i) && side_effect_free(as<IndexNode>(e)->j);
+    case NodeKind::BinOp: return side_effect_free(as<BinOpNode>(e)->a) && side_effect_free(as<BinOpNode>(e)->b);
+    case NodeKind::UnaryOp: return side_effect_free(as<UnaryOpNode>(e)->x);
+    case NodeKind::Cast: return side_effect_free(as<CastNode>(e)->x);
+    default: return true;
+    }
+}
+
+/* Ненульовий числовий літерал: ділення на нього не кидає помилки */
+bool nonzero_const(ExprNode* e){
+    if(!e || e->kind != NodeKind::Number) return false;
+    auto* n = as<NumberNode>(e);
+    return n->type == Type::Int? n->i != 0 : n->v != 0.0;
+}
+
+/* Може кинути помилку виконання (ділення без ненульового літерала в дільнику,
+   індексування масиву):
+   такий вираз не викидається, навіть коли його значення нікому не потрібне, —
+   інакше -O1/-O2 перетворили б помилку -O0 на звичайне повернення */
+bool may_trap(ExprNode* e){
+    if(!e) return false;
+    switch(e->kind){
+    case NodeKind::Assign: return may_trap(as<AssignNode>(e)->rhs);
+    case NodeKind::BinOp: {
+        auto* b = as<BinOpNode>(e);
+        if((b->op == Op::Div || b->op == Op::Mod) && !nonzero_const(b->b)) return true;
+        return may_trap(b->a) || may_trap(b->b);
+    }
+    case NodeKind::Index: return true; // межі перевіряє виконавець
+    case NodeKind::IndexAssign: return true;
+    case NodeKind::UnaryOp: return may_trap(as<UnaryOpNode>(e)->x);
+    case NodeKind::Cast: return may_trap(as<CastNode>(e)->x);
+    case NodeKind::Call: {
+        auto* c = as<CallNode>(e);
+        if(c->args) for(auto* a: c->args->args) if(may_trap(a)) return true;
+        return false;
+    }
+    default: return false;
+    }
+}
+
+/* Оголошення масиву падає на від'ємному чи завеликому розмірі (new_array);
+   без помилки — лише розміри-літерали в межах ARRAY_MAX_ELEMS */
+bool decl_may_trap(DeclNode* d){
+    if(may_trap(d->init) || may_trap(d->dims[0]) || may_trap(d->dims[1])) return true;
+    if(!d->rank) return false;
+    int64_t n = 1;
+    for(int k=0;k<d->rank;++k){
+        ExprNode* x = d->dims[k];
+        if(!x || x->kind != NodeKind::Number || x->type != Type::Int) return true;
+        int64_t v = as<NumberNode>(x)->i;
+        if(v < 0 || (v && n > ARRAY_MAX_ELEMS / v)) return true;
+        n *= v;
+    }
+    return false;
+}
+
+int expr_size(ExprNode* e){
+    if(!e) return 0;
+    switch(e->kind){
+    case NodeKind::Assign: return 1 + expr_size(as<AssignNode>(e)->rhs);
+    case NodeKind::BinOp: return 1 + expr_size(as<BinOpNode>(e)->a) + expr_size(as<BinOpNode>(e)->b);
+    case NodeKind::UnaryOp: return 1 + expr_size(as<UnaryOpNode>(e)->x);
+    case NodeKind::Cast: return 1 + expr_size(as<CastNode>(e)->x);
+    case NodeKind::Index: return 1 + expr_size(as<IndexNode>(e)->i) + expr_size(as<IndexNode>(e)->j);
+    case NodeKind::IndexAssign: return expr_size(as<IndexAssignNode>(e)->at) + expr_size(as<IndexAssignNode>(e)->rhs);
+    case NodeKind::Call: {
+        int n = 1; auto* c = as<CallNode>(e);
+        if(c->args) for(auto* a: c->args->args) n += expr_size(a);
+        return n;
+    }
+    default: return 1;
+    }
+}
+
+/* Глибока копія виразу разом з типами; VarRef з імен у subst замінюються копією відповідного аргументу.
+   Індексування не копіюється — inline таких тіл не бере (params_only) */
+ExprNode* clone_expr(Arena& A, ExprNode* e, const std::unordered_map<Name,ExprNode*>* subst = nullptr){
+    if(!e) return nullptr;
+    ExprNode* r;
+    switch(e->kind){
+    case NodeKind::Number: return make_const(A, const_of(e), e->type);
+    case NodeKind::Bool: return A.make<BoolNode>(as<BoolNode>(e)->v);
+    case NodeKind::VarRef: {
+        auto* v = as<VarRefNode>(e);
+        if(subst){ auto it = subst->find(v->name); if(it != subst->end()) return clone_expr(A, it->second); }
+        r = A.make<VarRefNode>(v->name);
+        break;
+    }
+    case NodeKind::Assign: { auto* a = as<AssignNode>(e); r = A.make<AssignNode>(a->name, clone_expr(A, a->rhs, subst)); break; }
+    case NodeKind::BinOp: { auto* b = as<BinOpNode>(e); r = A.make<BinOpNode>(b->op, clone_expr(A, b->a, subst), clone_expr(A, b->b, subst)); break; }
+    case NodeKind::UnaryOp: { auto* u = as<UnaryOpNode>(e); r = A.make<UnaryOpNode>(u->op, clone_expr(A, u->x, subst)); break; }
+    case NodeKind::Cast: return A.make<CastNode>(e->type, clone_expr(A, as<CastNode>(e)->x, subst));
+    case NodeKind::Call: {
+        auto* c = as<CallNode>(e);
+        ArgListNode* args = nullptr;
+        if(c->args){
+            args = A.make<ArgListNode>();
+            for(auto* x: c->args->args) args->args.push_back(clone_expr(A, x, subst));
+        }
+        r = A.make<CallNode>(c->name, args);
+        break;
+    }
+    default: return e;
+    }
+    r->type = e->type; r->rank = e->rank;
+    return r;
+}
+
+template<typename F> void each_func(Program* p, F&& f){
+    for(auto* it : p->items) if(it->kind == NodeKind::FuncDef) f(as<FuncDefNode>(it));
+}
+
+/* ---------- const-fold: обчислення константних підвиразів ---------- */
+
+/* t — тип операндів (після typecheck_program однаковий); арифметика та сама,
+   що й у виконавців (eval.hpp). Ділення на нуль лишається виконавцю, щоб
+   помилка виникла під час виконання */
+bool fold_bin(Op op, Type t, const Value& A, const Value& B, Value& r){
+    if(t != Type::Double){
+        int64_t a = A.i(), b = B.i();
+        switch(op){
+        case Op::Add: r = Value::integer(int_add(a,b)); return true;
+        case Op::Sub: r = Value::integer(int_sub(a,b)); return true;
+        case Op::Mul: r = Value::integer(int_mul(a,b)); return true;
+        case Op::Div: if(b == 0) return false; r = Value::integer(int_div(a,b)); return true;
+        case Op::Mod: if(b == 0) return false; r = Value::integer(int_mod(a,b)); return true;
+        case Op::Lt: r = Value::boolean(a<b); return true;
+        case Op::Gt: r = Value::boolean(a>b); return true;
+        case Op::Le: r = Value::boolean(a<=b); return true;
+        case Op::Ge: r = Value::boolean(a>=b); return true;
+        case Op::Eq: r = Value::boolean(a==b); return true;
+        case Op::Ne: r = Value::boolean(a!=b); return true;
+        default: return false;
+        }
+    }
+    double a = A.d(), b = B.d();
+    switch(op){
+    case Op::Add: r = Value::num(a+b); break;
+    case Op::Sub: r = Value::num(a-b); break;
+    case Op::Mul: r = Value::num(a*b); break;
+    case Op::Div: r = Value::num(a/b); break;
+    case Op::Lt: r = Value::boolean(a<b); return true;
+    case Op::Gt: r = Value::boolean(a>b); return true;
+    case Op::Le: r = Value::boolean(a<=b); return true;
+    case Op::Ge: r = Value::boolean(a>=b); return true;
+    case Op::Eq: r = Value::boolean(a==b); return true;
+    case Op::Ne: r = Value::boolean(a!=b); return true;
+    default: return false;
+    }
+    return std::isfinite(r.d()); // inf/nan лишаємо як є: їх не записати літералом у C
+}
+
+struct Folder {
+    Arena& A; int changes=0;
+    explicit Folder(Arena& a): A(a){}
+
+    ExprNode* expr(ExprNode* e){
+        if(!e) return e;
+        switch(e->kind){
+        case NodeKind::Assign: { auto* a = as<AssignNode>(e); a->rhs = expr(a->rhs); return e; }
+        case NodeKind::BinOp: {
+            auto* b = as<BinOpNode>(e);
+            b->a = expr(b->a); b->b = expr(b->b);
+            if(b->op==Op::And || b->op==Op::Or){
+                if(!is_const(b->a)) return e;
+                bool l = const_true(b->a);
+                if(b->op==Op::And && !l){ changes++; return A.make<BoolNode>(false); }
+                if(b->op==Op::Or && l){ changes++; return A.make<BoolNode>(true); }
+                if(is_const(b->b)){ changes++; return A.make<BoolNode>(const_true(b->b)); }
+                return e;
+            }
+            Value r;
+            if(is_const(b->a) && is_const(b->b) && fold_bin(b->op, b->a->type, const_of(b->a), const_of(b->b), r)){
+                changes++; return make_const(A, r, b->type);
+            }
+            return e;
+        }
+        case NodeKind::UnaryOp: {
+            auto* u = as<UnaryOpNode>(e);
+            u->x = expr(u->x);
+            if(!is_const(u->x)) return e;
+            changes++;
+            Value x = const_of(u->x);
+            if(u->op==Op::Not) return A.make<BoolNode>(!x.b());
+            return u->type==Type::Double? make_const(A, Value::num(-x.d()), u->type) : make_const(A, Value::integer(int_neg(x.i())), u->type);
+        }
+        case NodeKind::Cast: {
+            auto* c = as<CastNode>(e);
+            c->x = expr(c->x);
+            if(!is_const(c->x)) return e;
+            changes++;
+            Value x = const_of(c->x);
+            bool from_d = c->x->type == Type::Double;
+            switch(c->type){
+            case Type::Bool: return A.make<BoolNode>(from_d? x.d() != 0 : x.i() != 0);
+            case Type::Int: return A.make<NumberNode>(from_d? d2i(x.d()) : x.i());
+            default: return A.make<NumberNode>(from_d? x.d() : (double)x.i());
+            }
+        }
+        case NodeKind::Call: {
+            auto* c = as<CallNode>(e);
+            if(c->args) for(auto*& a: c->args->args) a = expr(a);
+            return e;
+        }
+        case NodeKind::Index: { auto* x = as<IndexNode>(e); x->i = expr(x->i); x->j = expr(x->j); return e; }
+        case NodeKind::IndexAssign: { auto* a = as<IndexAssignNode>(e); expr(a->at); a->rhs = expr(a->rhs); return e; }
+        default: return e;
+        }
+    }
+
+    void stmt(AST* n){
+        if(!n) return;
+        switch(n->kind){
+        case NodeKind::Decl: {
+            auto* d = as<DeclNode>(n);
+            d->init = expr(d->init); d->dims[0] = expr(d->dims[0]); d->dims[1] = expr(d->dims[1]);
+            return;
+        }
+        case NodeKind::ExprStmt: { auto* es = as<ExprStmtNode>(n); es->expr = expr(es->expr); return; }
+        case NodeKind::Return: { auto* r = as<ReturnNode>(n); r->expr = expr(r->expr); return; }
+        case NodeKind::If: { auto* iff = as<IfNode>(n); iff->cond = expr(iff->cond); stmt(iff->thenN); stmt(iff->elseN); return; }
+        case NodeKind::While: { auto* wh = as<WhileNode>(n); wh->cond = expr(wh->cond); stmt(wh->body); return; }
+        case NodeKind::For: {
+            auto* fr = as<ForNode>(n);
+            fr->init = expr(fr->init); fr->cond = expr(fr->cond); fr->step = expr(fr->step); stmt(fr->body);
+            return;
+        }
+        case NodeKind::Block: for(auto* s: as<BlockNode>(n)->stmts) stmt(s); return;
+        default: return;
+        }
+    }
+};
+
+int pass_fold(Program* p){
+    Folder f(p->arena);
+    each_func(p, [&](FuncDefNode* fn){ f.stmt(fn->body); });
+    return f.changes;
+}
+
+/* ---------- const-prop: локальні змінні, яким ніде не присвоюють ---------- */
+
+struct VarInfo { DeclNode* decl=nullptr; bool assigned=false; int uses=0; };
+
+struct Propagator {
+    Arena& A; int changes=0;
+    std::deque<VarInfo> infos;
+    std::vector<std::unordered_map<Name,VarInfo*>> scopes;
+    std::unordered_map<VarRefNode*,VarInfo*> refs;
+    std::unordered_set<DeclNode*> removable;
+    explicit Propagator(Arena& a): A(a){}
+
+    VarInfo* lookup(Name n){
+        for(auto it=scopes.rbegin(); it!=scopes.rend(); ++it){
+            auto f = it->find(n); if(f != it->end()) return f->second;
+        }
+        return nullptr;
+    }
+    void declare(Name n, DeclNode* d){ infos.push_back(VarInfo{d}); scopes.back()[n] = &infos.back(); }
+
+    /* 1) зв'язати кожен VarRef з оголошенням, позначити змінні з присвоєннями */
+    void scan_expr(ExprNode* e){
+        if(!e) return;
+        switch(e->kind){
+        case NodeKind::Assign: { auto* a = as<AssignNode>(e); scan_expr(a->rhs); if(auto* v = lookup(a->name)) v->assigned = true; return; }
+        case NodeKind::BinOp: scan_expr(as<BinOpNode>(e)->a); scan_expr(as<BinOpNode>(e)->b); return;
+        case NodeKind::UnaryOp: scan_expr(as<UnaryOpNode>(e)->x); return;
+        case NodeKind::Cast: scan_expr(as<CastNode>(e)->x); return;
+        case NodeKind::VarRef: { auto* v = as<VarRefNode>(e); if(auto* i = lookup(v->name)){ refs[v] = i; i->uses++; } return; }
+        case NodeKind::Call: { auto* c = as<CallNode>(e); if(c->args) for(auto* a: c->args->args) scan_expr(a); return; }
+        case NodeKind::Index: {
+            auto* x = as<IndexNode>(e);
+            scan_expr(x->i); scan_expr(x->j);
+            if(auto* i = lookup(x->name)) i->uses++;
+            return;
+        }
+        case NodeKind::IndexAssign: scan_expr(as<IndexAssignNode>(e)->at); scan_expr(as<IndexAssignNode>(e)->rhs); return;
+        case NodeKind::Len: if(auto* i = lookup(as<LenNode>(e)->name)) i->uses++; return;
+        default: return;
+        }
+    }
+    void scan(AST* n){
+        if(!n) return;
+        switch(n->kind){
+        case NodeKind::Decl: {
+            auto* d = as<DeclNode>(n);
+            scan_expr(d->init); scan_expr(d->dims[0]); scan_expr(d->dims[1]);
+            declare(d->name, d);
+            return;
+        }
+        case NodeKind::ExprStmt: scan_expr(as<ExprStmtNode>(n)->expr); return;
+        case NodeKind::Return: scan_expr(as<ReturnNode>(n)->expr); return;
+        case NodeKind::If: { auto* iff = as<IfNode>(n); scan_expr(iff->cond); scan(iff->thenN); scan(iff->elseN); return; }
+        case NodeKind::While: { auto* wh = as<WhileNode>(n); scan_expr(wh->cond); scan(wh->body); return; }
+        case NodeKind::For: {
+            auto* fr = as<ForNode>(n);
+            // reduction(op: s) читає s на вході й пише зведене значення після циклу —
+            // навіть із порожнім тілом s не константа і не зайве оголошення
+            for(auto& r: fr->reductions) if(auto* i = lookup(r.name)){ i->uses++; i->assigned = true; }
+            scan_expr(fr->init); scan_expr(fr->cond); scan_expr(fr->step); scan(fr->body);
+            return;
+        }
+        case NodeKind::Block:
+            scopes.emplace_back();
+            for(auto* s: as<BlockNode>(n)->stmts) scan(s);
+            scopes.pop_back();
+            return;
+        default: return;
+        }
+    }
+
+    static bool is_const_var(VarInfo* i){ return i && i->decl && !i->assigned && is_const(i->decl->init); }
+
+    /* 2) підставити значення констант */
+    ExprNode* subst(ExprNode* e){
+        if(!e) return e;
+        switch(e->kind){
+        case NodeKind::Assign: { auto* a = as<AssignNode>(e); a->rhs = subst(a->rhs); return e; }
+        case NodeKind::BinOp: { auto* b = as<BinOpNode>(e); b->a = subst(b->a); b->b = subst(b->b); return e; }
+        case NodeKind::UnaryOp: { auto* u = as<UnaryOpNode>(e); u->x = subst(u->x); return e; }
+        case NodeKind::Cast: { auto* c = as<CastNode>(e); c->x = subst(c->x); return e; }
+        case NodeKind::VarRef: {
+            auto it = refs.find(as<VarRefNode>(e));
+            if(it == refs.end() || !is_const_var(it->second)) return e;
+            it->second->uses--; changes++;
+            return clone_expr(A, it->second->decl->init);
+        }
+        case NodeKind::Call: { auto* c = as<CallNode>(e); if(c->args) for(auto*& a: c->args->args) a = subst(a); return e; }
+        case NodeKind::Index: { auto* x = as<IndexNode>(e); x->i = subst(x->i); x->j = subst(x->j); return e; }
+        case NodeKind::IndexAssign: { auto* a = as<IndexAssignNode>(e); subst(a->at); a->rhs = subst(a->rhs); return e; }
+        default: return e;
+        }
+    }
+    void rewrite(AST* n){
+        if(!n) return;
+        switch(n->kind){
+        case NodeKind::Decl: {
+            auto* d = as<DeclNode>(n);
+            d->init = subst(d->init); d->dims[0] = subst(d->dims[0]); d->dims[1] = subst(d->dims[1]);
+            return;
+        }
+        case NodeKind::ExprStmt: { auto* es = as<ExprStmtNode>(n); es->expr = subst(es->expr); return; }
+        case NodeKind::Return: { auto* r = as<ReturnNode>(n); r->expr = subst(r->expr); return; }
+        case NodeKind::If: { auto* iff = as<IfNode>(n); iff->cond = subst(iff->cond); rewrite(iff->thenN); rewrite(iff->elseN); return; }
+        case NodeKind::While: { auto* wh = as<WhileNode>(n); wh->cond = subst(wh->cond); rewrite(wh->body); return; }
+        case NodeKind::For: {
+            auto* fr = as<ForNode>(n);
+            fr->init = subst(fr->init); fr->cond = subst(fr->cond); fr->step = subst(fr->step); rewrite(fr->body);
+            return;
+        }
+        case NodeKind::Block: for(auto* s: as<BlockNode>(n)->stmts) rewrite(s); return;
+        default: return;
+        }
+    }
+
+    /* 3) прибрати оголошення, які ніхто не читає і не змінює */
+    void prune(AST* n){
+        if(!n) return;
+        switch(n->kind){
+        case NodeKind::If: prune(as<IfNode>(n)->thenN); prune(as<IfNode>(n)->elseN); return;
+        case NodeKind::While: prune(as<WhileNode>(n)->body); return;
+        case NodeKind::For: prune(as<ForNode>(n)->body); return;
+        case NodeKind::Block: {
+            auto& ss = as<BlockNode>(n)->stmts;
+            size_t k = 0;
+            for(auto* s: ss){
+                if(s->kind == NodeKind::Decl && removable.count(as<DeclNode>(s))){ changes++; continue; }
+                prune(s); ss[k++] = s;
+            }
+            ss.resize(k);
+            return;
+        }
+        default: return;
+        }
+    }
+
+    void function(FuncDefNode* f){
+        infos.clear(); scopes.clear(); refs.clear(); removable.clear();
+        scopes.emplace_back();
+        if(f->params) for(auto* p: f->params->params){ infos.push_back(VarInfo{}); scopes.back()[p->name] = &infos.back(); }
+        scan(f->body);
+        rewrite(f->body);
+        for(auto& i: infos)
+            if(i.decl && i.uses == 0 && !i.assigned && side_effect_free(i.decl->init)
+               && side_effect_free(i.decl->dims[0]) && side_effect_free(i.decl->dims[1]) && !decl_may_trap(i.decl))
+                removable.insert(i.decl);
+        prune(f->body);
+    }
+};
+
+int pass_prop(Program* p){
+    Propagator pr(p->arena);
+    each_func(p, [&](FuncDefNode* fn){ pr.function(fn); });
+    return pr.changes;
+}
+
+/* ---------- dce: код після return і гілки з константною умовою ---------- */
+
+bool always_returns(AST* n){
+    if(!n) return false;
+    switch(n->kind){
+    case NodeKind::Return: return true;
+    case NodeKind::If: { auto* iff = as<IfNode>(n); return iff->elseN && always_returns(iff->thenN) && always_returns(iff->elseN); }
+    case NodeKind::Block: for(auto* s: as<BlockNode>(n)->stmts) if(always_returns(s)) return true; return false;
+    default: return false;
+    }
+}
+
+struct Dce {
+    Arena& A; int changes=0;
+    explicit Dce(Arena& a): A(a){}
+
+    Node* or_empty(Node* n){ return n? n : A.make<BlockNode>(nullptr); }
+
+    void block(BlockNode* b){
+        auto& ss = b->stmts;
+        size_t k = 0;
+        for(size_t i=0;i<ss.size();++i){
+            AST* s = stmt(ss[i]);
+            if(!s) continue; // stmt() уже врахував зміну
+            ss[k++] = s;
+            if(always_returns(s) && i+1 < ss.size()){ changes += (int)(ss.size()-i-1); break; }
+        }
+        ss.resize(k);
+    }
+
+    /* nullptr — інструкцію можна прибрати повністю */
+    Node* stmt(AST* n){
+        switch(n->kind){
+        case NodeKind::If: {
+            auto* iff = as<IfNode>(n);
+            if(is_const(iff->cond)){
+                changes++;
+                Node* taken = const_true(iff->cond)? iff->thenN : iff->elseN;
+                return taken? stmt(taken) : nullptr;
+            }
+            iff->thenN = or_empty(stmt(iff->thenN));
+            if(iff->elseN) iff->elseN = stmt(iff->elseN);
+            return iff;
+        }
+        case NodeKind::While: {
+            auto* wh = as<WhileNode>(n);
+            if(is_const(wh->cond) && !const_true(wh->cond)){ changes++; return nullptr; }
+            wh->body = or_empty(stmt(wh->body));
+            return wh;
+        }
+        case NodeKind::For: {
+            auto* fr = as<ForNode>(n);
+            if(fr->cond && is_const(fr->cond) && !const_true(fr->cond)){
+                changes++;
+                return fr->init? A.make<ExprStmtNode>(fr->init) : nullptr;
+            }
+            fr->body = or_empty(stmt(fr->body));
+            return fr;
+        }
+        case NodeKind::Block: {
+            auto* b = as<BlockNode>(n);
+            block(b);
+            return b;
+        }
+        default: return as<Node>(n);
+        }
+    }
+};
+
+int pass_dce(Program* p){
+    Dce d(p->arena);
+    each_func(p, [&](FuncDefNode* fn){ d.block(fn->body); });
+    return d.changes;
+}
+
+/* ---------- inline: малі нерекурсивні функції { return expr; } ---------- */
+
+constexpr int INLINE_MAX_NODES = 16;
+
+void collect_calls(ExprNode* e, std::unordered_set<Name>& out);
+void collect_calls_stmt(AST* n, std::unordered_set<Name>& out){
+    if(!n) return;
+    switch(n->kind){
+    case NodeKind::Decl: { auto* d = as<DeclNode>(n); collect_calls(d->init, out); collect_calls(d->dims[0], out); collect_calls(d->dims[1], out); return; }
+    case NodeKind::ExprStmt: collect_calls(as<ExprStmtNode>(n)->expr, out); return;
+    case NodeKind::Return: collect_calls(as<ReturnNode>(n)->expr, out); return;
+    case NodeKind::If: { auto* iff = as<IfNode>(n); collect_calls(iff->cond, out); collect_calls_stmt(iff->thenN, out); collect_calls_stmt(iff->elseN, out); return; }
+    case NodeKind::While: { auto* wh = as<WhileNode>(n); collect_calls(wh->cond, out); collect_calls_stmt(wh->body, out); return; }
+    case NodeKind::For: { auto* fr = as<ForNode>(n); collect_calls(fr->init, out); collect_calls(fr->cond, out); collect_calls(fr->step, out); collect_calls_stmt(fr->body, out); return; }
+    case NodeKind::Block: for(auto* s: as<BlockNode>(n)->stmts) collect_calls_stmt(s, out); return;
+    default: return;
+    }
+}
+void collect_calls(ExprNode* e, std::unordered_set<Name>& out){
+    if(!e) return;
+    switch(e->kind){
+    case NodeKind::Assign: collect_calls(as<AssignNode>(e)->rhs, out); return;
+    case NodeKind::BinOp: collect_calls(as<BinOpNode>(e)->a, out); collect_calls(as<BinOpNode>(e)->b, out); return;
+    case NodeKind::UnaryOp: collect_calls(as<UnaryOpNode>(e)->x, out); return;
+    case NodeKind::Cast: collect_calls(as<CastNode>(e)->x, out); return;
+    case NodeKind::Call: {
+        auto* c = as<CallNode>(e); out.insert(c->name);
+        if(c->args) for(auto* a: c->args->args) collect_calls(a, out);
+        return;
+    }
+    case NodeKind::Index: collect_calls(as<IndexNode>(e)->i, out); collect_calls(as<IndexNode>(e)->j, out); return;
+    case NodeKind::IndexAssign: collect_calls(as<IndexAssignNode>(e)->at, out); collect_calls(as<IndexAssignNode>(e)->rhs, out); return;
+    default: return;
+    }
+}
+
+/* Вираз посилається лише на параметри; рахує використання кожного.
+   Індексування і len звертаються до масиву за іменем, тож такі тіла не вбудовуються */
+bool params_only(ExprNode* e, std::unordered_map<Name,int>& uses){
+    if(!e) return true;
+    switch(e->kind){
+    case NodeKind::Assign: case NodeKind::Index: case NodeKind::IndexAssign: case NodeKind::Len: return false;
+    case NodeKind::BinOp: return params_only(as<BinOpNode>(e)->a, uses) && params_only(as<BinOpNode>(e)->b, uses);
+    case NodeKind::UnaryOp: return params_only(as<UnaryOpNode>(e)->x, uses);
+    case NodeKind::Cast: return params_only(as<CastNode>(e)->x, uses);
+    case NodeKind::VarRef: { auto it = uses.find(as<VarRefNode>(e)->name); if(it == uses.end()) return false; it->second++; return true; }
+    case NodeKind::Call: {
+        auto* c = as<CallNode>(e);
+        if(c->args) for(auto* a: c->args->args) if(!params_only(a, uses)) return false;
+        return true;
+    }
+    default: return true;
+    }
+}
+
+struct Candidate { FuncDefNode* f; ExprNode* body; std::unordered_map<Name,int> uses; };
+
+struct Inliner {
+    Arena& A; int changes=0;
+    std::unordered_map<Name,Candidate> cands;
+    explicit Inliner(Arena& a): A(a){}
+
+    bool leaf(ExprNode* e){ return e->kind==NodeKind::Number || e->kind==NodeKind::Bool || e->kind==NodeKind::VarRef; }
+
+    ExprNode* expr(ExprNode* e, FuncDefNode* self){
+        if(!e) return e;
+        switch(e->kind){
+        case NodeKind::Assign: { auto* a = as<AssignNode>(e); a->rhs = expr(a->rhs, self); return e; }
+        case NodeKind::BinOp: { auto* b = as<BinOpNode>(e); b->a = expr(b->a, self); b->b = expr(b->b, self); return e; }
+        case NodeKind::UnaryOp: { auto* u = as<UnaryOpNode>(e); u->x = expr(u->x, self); return e; }
+        case NodeKind::Cast: { auto* c = as<CastNode>(e); c->x = expr(c->x, self); return e; }
+        case NodeKind::Call: {
+            auto* c = as<CallNode>(e);
+            if(c->args) for(auto*& a: c->args->args) a = expr(a, self);
+            auto it = cands.find(c->name);
+            if(it == cands.end() || it->second.f == self) return e;
+            Candidate& k = it->second;
+            size_t n = k.f->params? k.f->params->params.size() : 0;
+            size_t m = c->args? c->args->args.size() : 0;
+            if(n != m) return e; // помилку арності покаже виконавець
+            std::unordered_map<Name,ExprNode*> sub;
+            for(size_t i=0;i<n;++i){
+                ExprNode* a = c->args->args[i];
+                Name pn = k.f->params->params[i]->name;
+                // аргумент, що може впасти, лишається у виклику: параметр може не читатися
+                if(!side_effect_free(a) || may_trap(a)) return e;
+                if(k.uses[pn] > 1 && !leaf(a)) return e; // не дублюємо обчислення
+                sub[pn] = a;
+            }
+            changes++;
+            return clone_expr(A, k.body, &sub);
+        }
+        case NodeKind::Index: { auto* x = as<IndexNode>(e); x->i = expr(x->i, self); x->j = expr(x->j, self); return e; }
+        case NodeKind::IndexAssign: { auto* a = as<IndexAssignNode>(e); expr(a->at, self); a->rhs = expr(a->rhs, self); return e; }
+        default: return e;
+        }
+    }
+
+    void stmt(AST* n, FuncDefNode* self){
+        if(!n) return;
+        switch(n->kind){
+        case NodeKind::Decl: {
+            auto* d = as<DeclNode>(n);
+            d->init = expr(d->init, self); d->dims[0] = expr(d->dims[0], self); d->dims[1] = expr(d->dims[1], self);
+            return;
+        }
+        case NodeKind::ExprStmt: { auto* es = as<ExprStmtNode>(n); es->expr = expr(es->expr, self); return; }
+        case NodeKind::Return: { auto* r = as<ReturnNode>(n); r->expr = expr(r->expr, self); return; }
+        case NodeKind::If: { auto* iff = as<IfNode>(n); iff->cond = expr(iff->cond, self); stmt(iff->thenN, self); stmt(iff->elseN, self); return; }
+        case NodeKind::While: { auto* wh = as<WhileNode>(n); wh->cond = expr(wh->cond, self); stmt(wh->body, self); return; }
+        case NodeKind::For: {
+            auto* fr = as<ForNode>(n);
+            fr->init = expr(fr->init, self); fr->cond = expr(fr->cond, self); fr->step = expr(fr->step, self); stmt(fr->body, self);
+            return;
+        }
+        case NodeKind::Block: for(auto* s: as<BlockNode>(n)->stmts) stmt(s, self); return;
+        default: return;
+        }
+    }
+};
+
+int pass_inline(Program* p){
+    // останнє визначення з таким ім'ям перемагає, як у collect_functions
+    std::unordered_map<Name,FuncDefNode*> defs;
+    each_func(p, [&](FuncDefNode* f){ defs[f->name] = f; });
+
+    std::unordered_map<Name,std::unordered_set<Name>> calls;
+    for(auto& [name, f] : defs) collect_calls_stmt(f->body, calls[name]);
+    auto recursive = [&](Name start){
+        std::vector<Name> work(calls[start].begin(), calls[start].end());
+        std::unordered_set<Name> seen;
+        while(!work.empty()){
+            Name n = work.back(); work.pop_back();
+            if(n == start) return true;
+            if(!seen.insert(n).second) continue;
+            auto it = calls.find(n);
+            if(it != calls.end()) work.insert(work.end(), it->second.begin(), it->second.end());
+        }
+        return false;
+    };
+
+    Inliner in(p->arena);
+    for(auto& [name, f] : defs){
+        auto& ss = f->body->stmts;
+        if(ss.size() != 1 || ss[0]->kind != NodeKind::Return) continue;
+        ExprNode* body = as<ReturnNode>(ss[0])->expr;
+        if(!body || expr_size(body) > INLINE_MAX_NODES || recursive(name)) continue;
+        Candidate k{f, body, {}};
+        if(f->params) for(auto* pr: f->params->params) k.uses[pr->name] = 0;
+        if(!params_only(body, k.uses)) continue;
+        in.cands.emplace(name, std::move(k));
+    }
+    if(in.cands.empty()) return 0;
+    each_func(p, [&](FuncDefNode* fn){ in.stmt(fn->body, fn); });
+    return in.changes;
+}
+
+struct PassDef { const char* name; int (*run)(Program*); int min_level; };
+
+const PassDef PASSES[] = {
+    { "inline",     pass_inline, 2 },
+    { "const-fold", pass_fold,   1 },
+    { "const-prop", pass_prop,   1 },
+    { "dce",        pass_dce,    1 },
+};
+
+constexpr int MAX_ROUNDS = 8;
+
+} // namespace
+
+std::vector<PassStats> optimize_program(Program* p, int level){
+    std::vector<PassStats> stats;
+    std::vector<const PassDef*> pipeline;
+    for(auto& d : PASSES){
+        if(level >= d.min_level){ pipeline.push_back(&d); stats.push_back(PassStats{d.name}); }
+    }
+    // повторюємо конвеєр, поки хоч один прохід щось змінює
+    for(int round=0; round<MAX_ROUNDS; ++round){
+        int total = 0;
+        for(size_t i=0;i<pipeline.size();++i){
+            auto t0 = std::chrono::steady_clock::now();
+            int c = pipeline[i]->run(p);
+            auto t1 = std::chrono::steady_clock::now();
+            stats[i].runs++; stats[i].changes += c;
+            stats[i].ms += std::chrono::duration<double, std::milli>(t1-t0).count();
+            total += c;
+        }
+        if(total == 0) break;
+    }
+    return stats;
+}
+
+void print_opt_stats(std::ostream& out, const std::vector<PassStats>& stats){
+    out << std::left << std::setw(12) << "pass" << std::right << std::setw(6) << "runs"
+        << std::setw(9) << "changes" << std::setw(11) << "time(ms)" << "\n";
+    for(auto& s : stats){
+        out << std::left << std::setw(12) << s.name << std::right << std::setw(6) << s.runs
+            << std::setw(9) << s.changes << std::setw(11) << std::fixed << std::setprecision(3) << s.ms << "\n";
+    }
+}
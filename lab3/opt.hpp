@@ -0,0 +1,24 @@
+#pragma once
+#include <iosfwd>
+#include <vector>
+#include "ast.hpp"
+
+/*
+ * Оптимізація AST між yyparse() і виконанням/генерацією C.
+ *   -O0  нічого
+ *   -O1  const-fold, const-prop, dce (до нерухомої точки)
+ *   -O2  -O1 + inline малих нерекурсивних функцій виду { return expr; }
+ * Програма має бути типізована (typecheck_program): згортка враховує int-ділення.
+ * Нові вузли виділяються в арені програми. Після оптимізації слоти
+ * змінних застарівають — програму треба повторно пропустити через
+ * resolve_program і typecheck_program.
+ */
+struct PassStats {
+    const char* name;
+    int runs=0;      // скільки разів прохід запускався
+    int changes=0;   // скільки перетворень зробив
+    double ms=0;     // сумарний час
+};
+
+std::vector<PassStats> optimize_program(Program* p, int level);
+void print_opt_stats(std::ostream& out, const std::vector<PassStats>& stats);
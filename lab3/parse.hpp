@@ -0,0 +1,23 @@
+#pragma once
+#include "ast.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/* Flex — lexer.l через FILE*; Fast — fast_lex над mmap-відображенням файлу.
+   Обидва видають однаковий потік токенів. */
+enum class LexerKind { Flex, Fast };
+
+/* Розбирає файл у нову Program (реалізація — у parser.y). Реентерабельна:
+   кожен виклик має власний сканер і арену, тож різні файли можна
+   розбирати в різних потоках одночасно. При помилці повертає nullptr, а
+   повідомлення ("Parse error at line N: ...") дописує в err. */
+std::unique_ptr<Program> parse_file(const char* path, std::string& err, LexerKind lexer = LexerKind::Flex);
+/* Те саме для тексту в пам'яті (minicpp.hpp); src потрібен лише під час розбору */
+std::unique_ptr<Program> parse_source(std::string_view src, std::string& err, LexerKind lexer = LexerKind::Flex);
+
+/* Лише лексичний аналіз (--lex-only, bench/lexer.sh): кількість токенів і
+   FNV-хеш потоку (код, рядок, значення) — однаковий для обох лексерів */
+struct LexStats { long long tokens = 0; uint64_t hash = 0; };
+bool lex_file(const char* path, LexerKind lexer, LexStats& st, std::string& err);
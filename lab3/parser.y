@@ -1,6 +1,8 @@
 %{
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <vector>
 #include <memory>
 #include <string>
@@ -8,48 +10,78 @@
 %}
 
 /* Це потрапить у parser.tab.h — там потрібно знати, що таке AST */
-%code requires { #include "ast.hpp" }
+%code requires {
+#include "ast.hpp"
+#include <string>
+/* стан реентерабельного flex-сканера (як у lex.yy.c) */
+typedef void* yyscan_t;
+struct FastLexer;
+/* звідки yyparse бере токени: flex-сканер або ручний лексер (--lexer=fast) */
+struct TokenSource { yyscan_t flex = nullptr; FastLexer* fast = nullptr; };
+}
 
 /* Це піде у parser.tab.c — тут уже можна оголосити змінні/ф-ції */
 %code {
-std::unique_ptr<Program> g_program;
-void yyerror(const char* s);
-int yylex(void); 
+#include "fast_lexer.hpp"
+#include "mapped_file.hpp"
+#include "parse.hpp"
+/* з lex.yy.c (%option reentrant bison-bridge bison-locations, YY_DECL) */
+int flex_lex(YYSTYPE* yylval, YYLTYPE* yylloc, yyscan_t scanner);
+int yylex_init_extra(Program* extra, yyscan_t* scanner);
+void yyset_in(FILE* in, yyscan_t scanner);
+int yylex_destroy(yyscan_t scanner);
+static int yylex(YYSTYPE* lval, YYLTYPE* lloc, TokenSource* lex){
+    return lex->fast? fast_lex(*lex->fast, lval, lloc) : flex_lex(lval, lloc, lex->flex);
+}
+void yyerror(YYLTYPE* loc, TokenSource* lex, Program* prog, std::string* err, const char* s);
+/* усі вузли — в арені програми, що розбирається */
+template<typename T, typename... A> static T* mk(Program* p, A&&... a){ return p->arena.make<T>(std::forward<A>(a)...); }
+/* рядок початку інструкції чи функції (для --profile і діагностики) */
+static AST* at(AST* n, const YYLTYPE& l){ n->line = l.first_line; return n; }
 }
 
+%define api.pure full
 %define parse.error verbose
+%locations
+/* жодних глобальних змінних: джерело токенів, програма й текст помилки — параметри yyparse */
+%param { TokenSource* lex }
+%parse-param { Program* prog } { std::string* err }
 
 %union {
     int    ival;
     double dval;
-    char*  sval;
+    long long lval;
+    const char* sval; /* інтерноване ім'я, живе в арені prog */
     AST*   node;
     std::vector<AST*>* vec;
 }
 
 /* типізовані токени */
 %token T_INT T_DOUBLE T_BOOL T_TRUE T_FALSE
-%token T_IF T_ELSE T_WHILE T_FOR T_RETURN
+%token T_IF T_ELSE T_WHILE T_FOR T_RETURN T_LEN T_PARALLEL T_REDUCTION
 %token <sval>  T_IDENT
 %token <dval>  T_NUMBER_D
+%token <lval>  T_NUMBER_I
 %token T_EQ T_NE T_LE T_GE T_AND T_OR
 
 /* нетермінали */
 %type <node> program external decl type opt_init func_def param_list_opt param_list param
-%type <node> stmt stmt_list_opt compound expr opt_expr arg_list_opt arg_list
+%type <node> stmt stmt_list_opt compound expr opt_expr arg_list_opt arg_list index par_for par_reductions
+%type <ival> reduction_op
 
+%right '='
 %left T_OR
 %left T_AND
 %left T_EQ T_NE
 %left '<' '>' T_LE T_GE
 %left '+' '-'
 %left '*' '/' '%'
-%right '!' '='
+%right '!'
 
 %%
 program
-  : external                 { g_program = std::make_unique<Program>(); g_program->items.push_back($1); }
-  | program external         { g_program->items.push_back($2); }
+  : external                 { prog->items.push_back($1); }
+  | program external         { prog->items.push_back($2); }
   ;
 
 external
@@ -58,13 +90,19 @@ external
   ;
 
 type
-  : T_INT                    { $$ = new TypeNode("int"); }
-  | T_DOUBLE                 { $$ = new TypeNode("double"); }
-  | T_BOOL                   { $$ = new TypeNode("bool"); }
+  : T_INT                    { $$ = mk<TypeNode>(prog, "int"); }
+  | T_DOUBLE                 { $$ = mk<TypeNode>(prog, "double"); }
+  | T_BOOL                   { $$ = mk<TypeNode>(prog, "bool"); }
   ;
 
 decl
-  : type T_IDENT opt_init    { $$ = new DeclNode(as<TypeNode>($1)->name, std::string($2), as<ExprNode>($3)); free($2); }
+  : type T_IDENT opt_init    { $$ = at(mk<DeclNode>(prog, as<TypeNode>($1)->name, Name($2), as<ExprNode>($3)), @1); }
+  | type T_IDENT '[' expr ']'
+                            { auto* d = mk<DeclNode>(prog, as<TypeNode>($1)->name, Name($2), nullptr);
+                              d->dims[0] = as<ExprNode>($4); d->rank = 1; $$ = at(d, @1); }
+  | type T_IDENT '[' expr ']' '[' expr ']'
+                            { auto* d = mk<DeclNode>(prog, as<TypeNode>($1)->name, Name($2), nullptr);
+                              d->dims[0] = as<ExprNode>($4); d->dims[1] = as<ExprNode>($7); d->rank = 2; $$ = at(d, @1); }
   ;
 
 opt_init
@@ -78,70 +116,106 @@ param_list_opt
   ;
 
 param_list
-  : param                    { $$ = new ParamListNode(); as<ParamListNode>($$)->params.push_back(as<ParamNode>($1)); }
+  : param                    { $$ = mk<ParamListNode>(prog); as<ParamListNode>($$)->params.push_back(as<ParamNode>($1)); }
   | param_list ',' param     { $$ = $1; as<ParamListNode>($$)->params.push_back(as<ParamNode>($3)); }
   ;
 
 param
-  : type T_IDENT             { $$ = new ParamNode(as<TypeNode>($1)->name, std::string($2)); free($2); }
+  : type T_IDENT             { $$ = mk<ParamNode>(prog, as<TypeNode>($1)->name, Name($2)); }
+  | type T_IDENT '[' ']'     { auto* p = mk<ParamNode>(prog, as<TypeNode>($1)->name, Name($2)); p->rank = 1; $$ = p; }
+  | type T_IDENT '[' ']' '[' ']' { auto* p = mk<ParamNode>(prog, as<TypeNode>($1)->name, Name($2)); p->rank = 2; $$ = p; }
   ;
 
 func_def
   : type T_IDENT '(' param_list_opt ')' compound
-                            { $$ = new FuncDefNode(as<TypeNode>($1)->name, std::string($2), as<ParamListNode>($4), as<BlockNode>($6)); free($2); }
+                            { $$ = at(mk<FuncDefNode>(prog, as<TypeNode>($1)->name, Name($2), as<ParamListNode>($4), as<BlockNode>($6)), @2); }
   ;
 
 compound
-  : '{' stmt_list_opt '}'    { $$ = new BlockNode(as<VecNode>($2)); }
+  : '{' stmt_list_opt '}'    { $$ = at(mk<BlockNode>(prog, as<VecNode>($2)), @1); }
   ;
 
 stmt_list_opt
-  : /* empty */              { $$ = new VecNode(); }
+  : /* empty */              { $$ = mk<VecNode>(prog); }
   | stmt_list_opt stmt       { as<VecNode>($1)->items.push_back($2); $$ = $1; }
   ;
 
 stmt
   : decl ';'                 { $$ = $1; }
-  | expr ';'                 { $$ = new ExprStmtNode(as<ExprNode>($1)); }
-  | T_RETURN expr ';'        { $$ = new ReturnNode(as<ExprNode>($2)); }
-  | T_IF '(' expr ')' stmt   { $$ = new IfNode(as<ExprNode>($3), as<Node>($5), nullptr); }
+  | expr ';'                 { $$ = at(mk<ExprStmtNode>(prog, as<ExprNode>($1)), @1); }
+  | T_RETURN expr ';'        { $$ = at(mk<ReturnNode>(prog, as<ExprNode>($2)), @1); }
+  | T_IF '(' expr ')' stmt   { $$ = at(mk<IfNode>(prog, as<ExprNode>($3), as<Node>($5), nullptr), @1); }
   | T_IF '(' expr ')' stmt T_ELSE stmt
-                            { $$ = new IfNode(as<ExprNode>($3), as<Node>($5), as<Node>($7)); }
+                            { $$ = at(mk<IfNode>(prog, as<ExprNode>($3), as<Node>($5), as<Node>($7)), @1); }
   | T_WHILE '(' expr ')' stmt
-                            { $$ = new WhileNode(as<ExprNode>($3), as<Node>($5)); }
+                            { $$ = at(mk<WhileNode>(prog, as<ExprNode>($3), as<Node>($5)), @1); }
   | T_FOR '(' opt_expr ';' opt_expr ';' opt_expr ')' stmt
-                            { $$ = new ForNode(as<ExprNode>($3), as<ExprNode>($5), as<ExprNode>($7), as<Node>($9)); }
+                            { $$ = at(mk<ForNode>(prog, as<ExprNode>($3), as<ExprNode>($5), as<ExprNode>($7), as<Node>($9)), @1); }
+  | par_for stmt             { as<ForNode>($1)->body = as<Node>($2); $$ = $1; }
   | compound                 { $$ = $1; }
   ;
 
+/* parallel for (i = a; i < b; i = i + c) reduction(+: s, t) reduction(*: p) stmt */
+par_for
+  : T_PARALLEL T_FOR '(' opt_expr ';' opt_expr ';' opt_expr ')'
+                            { auto* f = mk<ForNode>(prog, as<ExprNode>($4), as<ExprNode>($6), as<ExprNode>($8), nullptr);
+                              f->parallel = true; $$ = at(f, @1); }
+  | par_reductions ')'       { $$ = $1; }
+  ;
+
+par_reductions
+  : par_for T_REDUCTION '(' reduction_op ':' T_IDENT
+                            { $$ = $1; as<ForNode>($$)->reductions.push_back({Op($4), Name($6)}); }
+  | par_reductions ',' T_IDENT
+                            { $$ = $1; auto& r = as<ForNode>($$)->reductions; r.push_back({r.back().op, Name($3)}); }
+  ;
+
+reduction_op
+  : '+'                      { $$ = int(Op::Add); }
+  | '*'                      { $$ = int(Op::Mul); }
+  ;
+
 opt_expr
   : /* empty */              { $$ = nullptr; }
   | expr                     { $$ = $1; }
   ;
 
 expr
-  : T_IDENT '=' expr         { $$ = new AssignNode(std::string($1), as<ExprNode>($3)); free($1); }
-  | expr T_OR expr           { $$ = new BinOpNode("||", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr T_AND expr          { $$ = new BinOpNode("&&", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr T_EQ expr           { $$ = new BinOpNode("==", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr T_NE expr           { $$ = new BinOpNode("!=", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr '<' expr            { $$ = new BinOpNode("<", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr '>' expr            { $$ = new BinOpNode(">", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr T_LE expr           { $$ = new BinOpNode("<=", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr T_GE expr           { $$ = new BinOpNode(">=", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr '+' expr            { $$ = new BinOpNode("+", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr '-' expr            { $$ = new BinOpNode("-", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr '*' expr            { $$ = new BinOpNode("*", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr '/' expr            { $$ = new BinOpNode("/", as<ExprNode>($1), as<ExprNode>($3)); }
-  | expr '%' expr            { $$ = new BinOpNode("%", as<ExprNode>($1), as<ExprNode>($3)); }
-  | '!' expr                 { $$ = new UnaryOpNode("!", as<ExprNode>($2)); }
-  | '-' expr %prec '!'       { $$ = new UnaryOpNode("neg", as<ExprNode>($2)); }
+  : T_IDENT '=' expr         { $$ = mk<AssignNode>(prog, Name($1), as<ExprNode>($3)); }
+  | index '=' expr           { $$ = mk<IndexAssignNode>(prog, as<IndexNode>($1), as<ExprNode>($3)); }
+  | expr T_OR expr           { $$ = mk<BinOpNode>(prog, Op::Or, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr T_AND expr          { $$ = mk<BinOpNode>(prog, Op::And, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr T_EQ expr           { $$ = mk<BinOpNode>(prog, Op::Eq, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr T_NE expr           { $$ = mk<BinOpNode>(prog, Op::Ne, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr '<' expr            { $$ = mk<BinOpNode>(prog, Op::Lt, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr '>' expr            { $$ = mk<BinOpNode>(prog, Op::Gt, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr T_LE expr           { $$ = mk<BinOpNode>(prog, Op::Le, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr T_GE expr           { $$ = mk<BinOpNode>(prog, Op::Ge, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr '+' expr            { $$ = mk<BinOpNode>(prog, Op::Add, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr '-' expr            { $$ = mk<BinOpNode>(prog, Op::Sub, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr '*' expr            { $$ = mk<BinOpNode>(prog, Op::Mul, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr '/' expr            { $$ = mk<BinOpNode>(prog, Op::Div, as<ExprNode>($1), as<ExprNode>($3)); }
+  | expr '%' expr            { $$ = mk<BinOpNode>(prog, Op::Mod, as<ExprNode>($1), as<ExprNode>($3)); }
+  | '!' expr                 { $$ = mk<UnaryOpNode>(prog, Op::Not, as<ExprNode>($2)); }
+  | '-' expr %prec '!'       { $$ = mk<UnaryOpNode>(prog, Op::Neg, as<ExprNode>($2)); }
   | '(' expr ')'             { $$ = $2; }
-  | T_IDENT '(' arg_list_opt ')' { $$ = new CallNode(std::string($1), as<ArgListNode>($3)); free($1); }
-  | T_IDENT                  { $$ = new VarRefNode(std::string($1)); free($1); }
-  | T_NUMBER_D               { $$ = new NumberNode($1); }
-  | T_TRUE                   { $$ = new BoolNode(true); }
-  | T_FALSE                  { $$ = new BoolNode(false); }
+  | T_IDENT '(' arg_list_opt ')' { $$ = mk<CallNode>(prog, Name($1), as<ArgListNode>($3)); }
+  | T_IDENT                  { $$ = mk<VarRefNode>(prog, Name($1)); }
+  | index                    { $$ = $1; }
+  | T_LEN '(' T_IDENT ')'    { $$ = mk<LenNode>(prog, Name($3), 0); }
+  | T_LEN '(' T_IDENT ',' T_NUMBER_I ')'
+                            { if($5 < 0 || $5 > 1){ yyerror(&@5, lex, prog, err, "len dimension must be 0 or 1"); YYERROR; }
+                              $$ = mk<LenNode>(prog, Name($3), int($5)); }
+  | T_NUMBER_D               { $$ = mk<NumberNode>(prog, $1); }
+  | T_NUMBER_I               { $$ = mk<NumberNode>(prog, int64_t($1)); }
+  | T_TRUE                   { $$ = mk<BoolNode>(prog, true); }
+  | T_FALSE                  { $$ = mk<BoolNode>(prog, false); }
+  ;
+
+index
+  : T_IDENT '[' expr ']'     { $$ = mk<IndexNode>(prog, Name($1), as<ExprNode>($3), nullptr); }
+  | T_IDENT '[' expr ']' '[' expr ']'
+                            { $$ = mk<IndexNode>(prog, Name($1), as<ExprNode>($3), as<ExprNode>($6)); }
   ;
 
 arg_list_opt
@@ -150,12 +224,91 @@ arg_list_opt
   ;
 
 arg_list
-  : expr                     { $$ = new ArgListNode(); as<ArgListNode>($$)->args.push_back(as<ExprNode>($1)); }
+  : expr                     { $$ = mk<ArgListNode>(prog); as<ArgListNode>($$)->args.push_back(as<ExprNode>($1)); }
   | arg_list ',' expr        { $$ = $1; as<ArgListNode>($$)->args.push_back(as<ExprNode>($3)); }
   ;
 
 %%
 
-void yyerror(const char* s){
-    std::fprintf(stderr, "Parse error: %s\n", s);
+void yyerror(YYLTYPE* loc, TokenSource*, Program*, std::string* err, const char* s){
+    *err += "Parse error at line "+std::to_string(loc->first_line)+": "+s+"\n";
+}
+
+namespace {
+
+/* Відкрите джерело токенів: FILE* для flex або відображений файл для fast_lex */
+struct Input {
+    TokenSource ts;
+    FILE* in = nullptr;
+    MappedFile map;
+    std::unique_ptr<FastLexer> fast;
+
+    bool open(const char* path, LexerKind lexer, Program* p, std::string& err){
+        if(lexer == LexerKind::Fast){
+            if(!map.open(path, err)) return false;
+            fast = std::make_unique<FastLexer>(map.view().data(), map.view().size(), p);
+            ts.fast = fast.get();
+            return true;
+        }
+        in = std::fopen(path, "r");
+        if(!in){ err = std::string(path)+": "+std::strerror(errno)+"\n"; return false; }
+        yylex_init_extra(p, &ts.flex);
+        yyset_in(in, ts.flex);
+        return true;
+    }
+    /* Текст у пам'яті: fast_lex читає його напряму, flex — через fmemopen */
+    bool open(std::string_view src, LexerKind lexer, Program* p, std::string& err){
+        // fmemopen не приймає порожній буфер, а потік токенів однаковий
+        if(lexer == LexerKind::Fast || src.empty()){
+            fast = std::make_unique<FastLexer>(src.data(), src.size(), p);
+            ts.fast = fast.get();
+            return true;
+        }
+        in = fmemopen(const_cast<char*>(src.data()), src.size(), "r");
+        if(!in){ err = std::string("fmemopen: ")+std::strerror(errno)+"\n"; return false; }
+        yylex_init_extra(p, &ts.flex);
+        yyset_in(in, ts.flex);
+        return true;
+    }
+    ~Input(){
+        if(ts.flex) yylex_destroy(ts.flex);
+        if(in) std::fclose(in);
+    }
+};
+
+} // namespace
+
+std::unique_ptr<Program> parse_file(const char* path, std::string& err, LexerKind lexer){
+    auto p = std::make_unique<Program>();
+    Input input;
+    if(!input.open(path, lexer, p.get(), err)) return nullptr;
+    if(yyparse(&input.ts, p.get(), &err) != 0) return nullptr;
+    return p;
+}
+
+std::unique_ptr<Program> parse_source(std::string_view src, std::string& err, LexerKind lexer){
+    auto p = std::make_unique<Program>();
+    Input input;
+    if(!input.open(src, lexer, p.get(), err)) return nullptr;
+    if(yyparse(&input.ts, p.get(), &err) != 0) return nullptr;
+    return p;
+}
+
+bool lex_file(const char* path, LexerKind lexer, LexStats& st, std::string& err){
+    Program p; // лише для інтернера імен
+    Input input;
+    if(!input.open(path, lexer, &p, err)) return false;
+    YYSTYPE v; YYLTYPE l;
+    // FNV-1a по коду, рядку й значенню токена
+    auto mix = [&](const void* d, size_t n){
+        for(size_t i=0;i<n;++i){ st.hash ^= static_cast<const unsigned char*>(d)[i]; st.hash *= 1099511628211ull; }
+    };
+    st.hash = 1469598103934665603ull;
+    for(int t; (t = yylex(&v, &l, &input.ts)) != 0; st.tokens++){
+        mix(&t, sizeof t); mix(&l.first_line, sizeof l.first_line);
+        if(t == T_IDENT) mix(v.sval, std::strlen(v.sval));
+        else if(t == T_NUMBER_I) mix(&v.lval, sizeof v.lval);
+        else if(t == T_NUMBER_D) mix(&v.dval, sizeof v.dval);
+    }
+    return true;
 }
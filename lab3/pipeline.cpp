@@ -0,0 +1,110 @@
+#include "pipeline.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "ast_cache.hpp"
+#include "gen_c.hpp"
+#include "mapped_file.hpp"
+#include "opt.hpp"
+#include "purity.hpp"
+#include "resolve.hpp"
+#include "typecheck.hpp"
+
+void check_program(Program* p, int opt_level, std::ostream* opt_stats){
+    resolve_program(p);
+    typecheck_program(p);
+    if(opt_level > 0){
+        auto stats = optimize_program(p, opt_level);
+        if(opt_stats) print_opt_stats(*opt_stats, stats);
+        resolve_program(p);
+        typecheck_program(p);
+    }
+    analyze_purity(p);
+}
+
+std::unique_ptr<Program> load_program(const char* path, std::string& err, LexerKind lexer, bool cache, bool* cache_hit){
+    if(cache_hit) *cache_hit = false;
+    if(!cache) return parse_file(path, err, lexer);
+    MappedFile src;
+    if(!src.open(path, err)) return nullptr;
+    std::string cpath = ast_cache_path(path);
+    if(auto p = load_ast_cache(cpath, src.view())){
+        if(cache_hit) *cache_hit = true;
+        return p;
+    }
+    auto p = parse_file(path, err, lexer);
+    std::string cerr;
+    if(p && !save_ast_cache(p.get(), cpath, src.view(), cerr)) err += "warning: AST cache not written: " + cerr + "\n";
+    return p;
+}
+
+namespace {
+
+/* foo.mc++ -> foo.c, інше ім'я — з дописаним .c */
+std::string c_path(const std::string& src){
+    const std::string ext = ".mc++";
+    if(src.size() > ext.size() && src.compare(src.size()-ext.size(), ext.size(), ext) == 0)
+        return src.substr(0, src.size()-ext.size()) + ".c";
+    return src + ".c";
+}
+
+/* Один файл від початку до кінця; повідомлення — у log, результат — код виходу */
+int compile_one(const char* src, const BatchOptions& o, std::string& log){
+    std::string err;
+    auto prog = load_program(src, err, o.lexer, o.ast_cache);
+    if(!prog){ log += err + "Parse failed\n"; return 2; }
+    std::ostringstream diag;
+    diag << err; // попередження кешу
+    try {
+        check_program(prog.get(), o.opt_level);
+        if(o.emit_c){
+            std::string code = gen_c_code(prog.get(), o.par_report? &diag : nullptr);
+            std::string dst = c_path(src);
+            FILE* f = std::fopen(dst.c_str(), "wb");
+            if(!f){ log += diag.str() + "Failed to write " + dst + "\n"; return 2; }
+            std::fwrite(code.data(), 1, code.size(), f);
+            std::fclose(f);
+            diag << "C code written to " << dst << "\n";
+        }
+    } catch(const std::exception& ex){
+        log += diag.str() + "Error: " + ex.what() + "\n";
+        return 2;
+    }
+    log += diag.str();
+    return 0;
+}
+
+} // namespace
+
+int compile_batch(const std::vector<const char*>& files, const BatchOptions& o, std::ostream& out){
+    std::vector<std::string> logs(files.size());
+    std::vector<int> rcs(files.size(), 0);
+    // пул фіксованого розміру: кожен потік бере наступний файл з лічильника,
+    // тож довгі файли не затримують решту черги
+    std::atomic<size_t> next{0};
+    auto worker = [&]{
+        for(size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < files.size(); )
+            rcs[i] = compile_one(files[i], o, logs[i]);
+    };
+    unsigned jobs = o.jobs? o.jobs : std::max(1u, std::thread::hardware_concurrency());
+    jobs = (unsigned)std::min<size_t>(jobs, files.size());
+    std::vector<std::thread> pool;
+    for(unsigned t = 1; t < jobs; ++t) pool.emplace_back(worker);
+    worker();
+    for(auto& t : pool) t.join();
+
+    int rc = 0, failed = 0;
+    for(size_t i=0;i<files.size();++i){
+        // кожен рядок діагностики з ім'ям файлу, як у компіляторів C
+        std::istringstream lines(logs[i]);
+        for(std::string line; std::getline(lines, line); ) out << files[i] << ": " << line << "\n";
+        if(rcs[i]){ rc = std::max(rc, rcs[i]); failed++; }
+    }
+    out << files.size() << " file(s), " << failed << " failed\n";
+    return rc;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "parse.hpp"
+
+/*
+ * Перевірка розібраної програми перед виконанням чи генерацією C:
+ * resolve і typecheck, за opt_level > 0 — оптимізація та повторні resolve
+ * і typecheck (AST змінився), наприкінці — чистота функцій. Статистику
+ * проходів друкує в opt_stats, якщо він не null. Кидає std::runtime_error.
+ */
+void check_program(Program* p, int opt_level, std::ostream* opt_stats = nullptr);
+
+/*
+ * parse_file з двійковим кешем (ast_cache.hpp): за cache спершу пробує
+ * <src>.astc, якщо він зроблений з того самого вмісту джерела, інакше
+ * розбирає файл і перезаписує кеш (помилка запису кешу не фатальна).
+ * cache_hit (якщо не null) — чи обійшлося без yyparse.
+ */
+std::unique_ptr<Program> load_program(const char* path, std::string& err, LexerKind lexer, bool cache, bool* cache_hit = nullptr);
+
+struct BatchOptions {
+    int opt_level = 0;
+    bool emit_c = false;     // foo.mc++ -> foo.c поруч із джерелом
+    bool par_report = false; // звіт gen_c_code про цикли, у діагностику файлу
+    unsigned jobs = 0;       // 0 — std::thread::hardware_concurrency()
+    LexerKind lexer = LexerKind::Flex;
+    bool ast_cache = false;  // --ast-cache
+};
+
+/*
+ * Пакетна компіляція: кожен файл розбирається (parse_file), перевіряється
+ * (check_program) і за потреби перекладається в C на пулі з jobs потоків.
+ * Файли незалежні — кожен має власну Program з ареною, — тож потоки не
+ * ділять жодного стану; діагностика кожного файлу збирається окремо і
+ * друкується в out у порядку аргументів. Повертає 0, якщо всі файли
+ * пройшли, інакше 2 (як main для одного файлу).
+ */
+int compile_batch(const std::vector<const char*>& files, const BatchOptions& o, std::ostream& out);
@@ -0,0 +1,107 @@
+#include "profile.hpp"
+#include "eval.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+static uint64_t now_ns(){
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+static uint64_t ticks(){ return __rdtsc(); }
+#else
+static uint64_t ticks(){ return now_ns(); }
+#endif
+
+Profiler::Profiler(): tick0(ticks()), ns0(now_ns()){}
+
+/* середня частота за весь час профілювання */
+double Profiler::ns_per_tick() const {
+    uint64_t dt = ticks() - tick0, dn = now_ns() - ns0;
+    return dt? (double)dn / dt : 1.0;
+}
+
+void Profiler::enter(Func* fn){
+    int parent = frames.empty()? 0 : frames.back().path, path = -1;
+    if(paths[parent].fn == fn) path = parent; // пряма рекурсія лишається у вузлі викликача
+    else for(int k : paths[parent].kids) if(paths[k].fn == fn){ path = k; break; }
+    if(path < 0){
+        path = (int)paths.size();
+        paths.push_back(Path{fn, parent, 0, 0, {}});
+        paths[parent].kids.push_back(path);
+    }
+    paths[path].calls++;
+    size_t id = (size_t)fn->def->id;
+    if(id >= funcs.size()) funcs.resize(id + 1);
+    FuncStats& fs = funcs[id];
+    fs.fn = fn; fs.calls++; fs.active++;
+    frames.push_back(Frame{path, ticks(), 0});
+}
+
+void Profiler::leave(){
+    uint64_t t = ticks();
+    Frame f = frames.back(); frames.pop_back();
+    uint64_t total = t - f.start, excl = total - std::min(total, f.child);
+    Path& p = paths[f.path];
+    p.excl += excl;
+    FuncStats& fs = funcs[(size_t)p.fn->def->id];
+    fs.excl += excl;
+    if(--fs.active == 0) fs.incl += total;
+    if(!frames.empty()) frames.back().child += total;
+}
+
+void print_profile(std::ostream& out, const Profiler& p, const char* source){
+    std::vector<const Profiler::FuncStats*> fs;
+    uint64_t all = 0;
+    double ms = p.ns_per_tick() / 1e6;
+    for(auto& s : p.funcs) if(s.calls){ fs.push_back(&s); all += s.excl; }
+    std::sort(fs.begin(), fs.end(), [](auto* a, auto* b){ return a->excl > b->excl; });
+
+    out << std::left << std::setw(16) << "function" << std::right << std::setw(12) << "calls"
+        << std::setw(12) << "incl(ms)" << std::setw(12) << "excl(ms)" << std::setw(8) << "excl%" << "\n";
+    for(auto* s : fs){
+        out << std::left << std::setw(16) << s->fn->def->name << std::right << std::setw(12) << s->calls
+            << std::fixed << std::setprecision(3) << std::setw(12) << s->incl * ms << std::setw(12) << s->excl * ms
+            << std::setprecision(1) << std::setw(8) << (all? 100.0 * s->excl / all : 0.0) << "\n";
+    }
+
+    std::vector<std::string> text;
+    if(source){
+        std::ifstream in(source);
+        for(std::string l; std::getline(in, l); ) text.push_back(l);
+    }
+    out << "\n" << std::setw(6) << "line" << std::setw(12) << "hits" << std::setw(12) << "loop-iters" << "  source\n";
+    size_t n = std::max(p.stmt_hits.size(), p.loop_iters.size());
+    for(size_t line = 1; line < n; ++line){
+        uint64_t h = line < p.stmt_hits.size()? p.stmt_hits[line] : 0;
+        uint64_t it = line < p.loop_iters.size()? p.loop_iters[line] : 0;
+        if(!h && !it) continue;
+        out << std::setw(6) << line << std::setw(12) << h << std::setw(12) << it << "  "
+            << (line <= text.size()? text[line-1] : std::string()) << "\n";
+    }
+    if(!p.stmt_hits.empty() && p.stmt_hits[0])
+        out << std::setw(6) << "?" << std::setw(12) << p.stmt_hits[0] << "  (інструкції, створені оптимізатором)\n";
+}
+
+/* обхід у глибину з одним буфером префікса: пам'ять O(глибина), а не O(вузли × глибина) */
+void write_folded(std::ostream& out, const Profiler& p){
+    double k = p.ns_per_tick();
+    std::string prefix;
+    std::vector<std::pair<int, size_t>> todo; // вузол і довжина префікса його батька
+    for(auto it = p.paths[0].kids.rbegin(); it != p.paths[0].kids.rend(); ++it) todo.push_back({*it, 0});
+    while(!todo.empty()){
+        auto [i, len] = todo.back(); todo.pop_back();
+        const auto& node = p.paths[(size_t)i];
+        prefix.resize(len);
+        if(len) prefix += ';';
+        prefix += node.fn->def->name;
+        if(uint64_t ns = (uint64_t)(node.excl * k)) out << prefix << " " << ns << "\n";
+        for(auto it = node.kids.rbegin(); it != node.kids.rend(); ++it) todo.push_back({*it, prefix.size()});
+    }
+}
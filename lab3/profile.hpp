@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/*
+ * Профілювальник дерев'яного інтерпретатора (--profile). run_frame викликає
+ * enter/leave для кожного кадру, exec_node — stmt для кожної інструкції та
+ * loop для кожної ітерації циклу. Час — лічильник тактів (rdtsc на x86-64,
+ * інакше steady_clock), що переводиться в наносекунди лише у звіті:
+ *   inclusive — від входу до виходу (для рекурсії рахується лише зовнішній кадр),
+ *   exclusive — мінус час викликаних функцій.
+ * Шляхи викликів зберігаються деревом (корінь — індекс 0), тож folded-стеки
+ * для flamegraph.pl будуються без повторного проходу по трасі. Пряма
+ * рекурсія згортається в один вузол (f;f;f → f), тож дерево не росте з глибиною.
+ */
+struct Func;
+
+struct Profiler {
+    struct Path { Func* fn; int parent; uint64_t calls=0, excl=0; std::vector<int> kids; };
+    struct Frame { int path; uint64_t start, child; };
+    struct FuncStats { Func* fn=nullptr; uint64_t calls=0, incl=0, excl=0; int active=0; };
+
+    std::vector<Path> paths{ Path{nullptr, -1, 0, 0, {}} };
+    std::vector<Frame> frames;
+    std::vector<FuncStats> funcs;                 // індекс — FuncDefNode::id
+    std::vector<uint64_t> stmt_hits, loop_iters;  // індекс — рядок джерела
+    uint64_t tick0, ns0;                          // для калібрування тактів у ns
+
+    Profiler();
+    double ns_per_tick() const;
+
+    void enter(Func* fn);
+    void leave();
+    void stmt(uint32_t line){ if(line >= stmt_hits.size()) stmt_hits.resize(line + 1); stmt_hits[line]++; }
+    void loop(uint32_t line){ if(line >= loop_iters.size()) loop_iters.resize(line + 1); loop_iters[line]++; }
+};
+
+/* Таблиця функцій і рядків; source — шлях до джерела для показу тексту рядків */
+void print_profile(std::ostream& out, const Profiler& p, const char* source);
+/* Рядки "main;fib;add <exclusive ns>" для flamegraph.pl --countname=ns */
+void write_folded(std::ostream& out, const Profiler& p);
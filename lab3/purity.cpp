@@ -0,0 +1,66 @@
+#include "purity.hpp"
+#include <vector>
+
+namespace {
+
+/* Чи чистий вираз за умови поточних позначок pure у викликаних функцій */
+bool pure_expr(ExprNode* e){
+    if(!e) return true;
+    switch(e->kind){
+    case NodeKind::Number: case NodeKind::Bool: case NodeKind::VarRef: return true;
+    case NodeKind::Assign: return pure_expr(as<AssignNode>(e)->rhs); // слот завжди у власному кадрі
+    case NodeKind::Cast: return pure_expr(as<CastNode>(e)->x);
+    case NodeKind::UnaryOp: return pure_expr(as<UnaryOpNode>(e)->x);
+    case NodeKind::BinOp: { auto* b = as<BinOpNode>(e); return pure_expr(b->a) && pure_expr(b->b); }
+    case NodeKind::Call: {
+        auto* c = as<CallNode>(e);
+        if(!c->target || !c->target->pure) return false;
+        if(c->args) for(auto* a: c->args->args) if(!pure_expr(a)) return false;
+        return true;
+    }
+    // масиви чистої функції — лише власні локальні (параметри-масиви роблять її нечистою)
+    case NodeKind::Len: return true;
+    case NodeKind::Index: { auto* x = as<IndexNode>(e); return pure_expr(x->i) && pure_expr(x->j); }
+    case NodeKind::IndexAssign: { auto* a = as<IndexAssignNode>(e); return pure_expr(a->at) && pure_expr(a->rhs); }
+    default: return false;
+    }
+}
+
+bool pure_stmt(AST* n){
+    if(!n) return true;
+    switch(n->kind){
+    case NodeKind::Decl: { auto* d = as<DeclNode>(n); return pure_expr(d->init) && pure_expr(d->dims[0]) && pure_expr(d->dims[1]); }
+    case NodeKind::ExprStmt: return pure_expr(as<ExprStmtNode>(n)->expr);
+    case NodeKind::Return: return pure_expr(as<ReturnNode>(n)->expr);
+    case NodeKind::If: { auto* iff = as<IfNode>(n); return pure_expr(iff->cond) && pure_stmt(iff->thenN) && pure_stmt(iff->elseN); }
+    case NodeKind::While: { auto* wh = as<WhileNode>(n); return pure_expr(wh->cond) && pure_stmt(wh->body); }
+    case NodeKind::For: {
+        auto* fr = as<ForNode>(n);
+        return pure_expr(fr->init) && pure_expr(fr->cond) && pure_expr(fr->step) && pure_stmt(fr->body);
+    }
+    case NodeKind::Block:
+        for(auto* s: as<BlockNode>(n)->stmts) if(!pure_stmt(s)) return false;
+        return true;
+    default: return false;
+    }
+}
+
+} // namespace
+
+void analyze_purity(Program* p){
+    std::vector<FuncDefNode*> fs;
+    for(auto* it : p->items){
+        if(it->kind != NodeKind::FuncDef) continue;
+        auto* f = as<FuncDefNode>(it);
+        f->pure = true;
+        // результат залежить від вмісту масиву, а не лише від бітів аргументу
+        if(f->params) for(auto* p: f->params->params) if(p->rank) f->pure = false;
+        fs.push_back(f);
+    }
+    for(bool changed = true; changed; ){
+        changed = false;
+        for(auto* f : fs){
+            if(f->pure && !pure_stmt(f->body)){ f->pure = false; changed = true; }
+        }
+    }
+}
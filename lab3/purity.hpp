@@ -0,0 +1,13 @@
+#pragma once
+#include "ast.hpp"
+
+/*
+ * Аналіз чистоти: FuncDefNode::pure = true, якщо результат функції залежить
+ * лише від аргументів — тіло читає й пише тільки слоти власного кадру
+ * (параметри та локальні змінні) і викликає лише чисті функції.
+ * Рекурсія обробляється нерухомою точкою: спершу всі функції вважаються
+ * чистими, потім знімаємо позначку, доки нічого не змінюється.
+ * Незнайомий вузол робить функцію нечистою, тож нові конструкції мови
+ * безпечні за замовчуванням. Програма має бути типізована (CallNode::target).
+ */
+void analyze_purity(Program* p);
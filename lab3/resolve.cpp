@@ -0,0 +1,96 @@
+#include "resolve.hpp"
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Resolver {
+    std::vector<std::unordered_map<Name,int>> scopes;
+    int next_slot=0, nslots=0;
+
+    void push(){ scopes.emplace_back(); }
+    void pop(){ next_slot -= (int)scopes.back().size(); scopes.pop_back(); }
+    int depth() const { return (int)scopes.size()-1; }
+    int decl(Name name){
+        if(!scopes.back().emplace(name, next_slot).second) throw std::runtime_error("Redeclaration: "+std::string(name));
+        int s = next_slot++;
+        if(next_slot > nslots) nslots = next_slot;
+        return s;
+    }
+    void lookup(Name name, int& d, int& slot){
+        for(int i=depth(); i>=0; --i){
+            auto f=scopes[i].find(name);
+            if(f!=scopes[i].end()){ d=i; slot=f->second; return; }
+        }
+        throw std::runtime_error("Undeclared: "+std::string(name));
+    }
+
+    void stmt(AST* n){
+        if(!n) return;
+        switch(n->kind){
+        case NodeKind::Decl: {
+            auto* d = as<DeclNode>(n);
+            expr(d->init); // ініціалізатор і розміри бачать лише зовнішні імена
+            expr(d->dims[0]); expr(d->dims[1]);
+            d->depth = depth(); d->slot = decl(d->name);
+            return;
+        }
+        case NodeKind::ExprStmt: expr(as<ExprStmtNode>(n)->expr); return;
+        case NodeKind::Return: expr(as<ReturnNode>(n)->expr); return;
+        case NodeKind::If: { auto* iff = as<IfNode>(n); expr(iff->cond); stmt(iff->thenN); stmt(iff->elseN); return; }
+        case NodeKind::While: { auto* wh = as<WhileNode>(n); expr(wh->cond); stmt(wh->body); return; }
+        case NodeKind::For: {
+            auto* fr = as<ForNode>(n);
+            for(auto& r: fr->reductions) lookup(r.name, r.depth, r.slot);
+            expr(fr->init); expr(fr->cond); expr(fr->step); stmt(fr->body);
+            return;
+        }
+        case NodeKind::Block:
+            push();
+            for(auto* s: as<BlockNode>(n)->stmts) stmt(s);
+            pop();
+            return;
+        default: return;
+        }
+    }
+
+    void expr(ExprNode* e){
+        if(!e) return;
+        switch(e->kind){
+        case NodeKind::Assign: { auto* a = as<AssignNode>(e); expr(a->rhs); lookup(a->name, a->depth, a->slot); return; }
+        case NodeKind::BinOp: { auto* b = as<BinOpNode>(e); expr(b->a); expr(b->b); return; }
+        case NodeKind::UnaryOp: expr(as<UnaryOpNode>(e)->x); return;
+        case NodeKind::Cast: expr(as<CastNode>(e)->x); return;
+        case NodeKind::VarRef: { auto* v = as<VarRefNode>(e); lookup(v->name, v->depth, v->slot); return; }
+        case NodeKind::Call: {
+            auto* c = as<CallNode>(e);
+            if(c->args) for(auto* a: c->args->args) expr(a);
+            return;
+        }
+        case NodeKind::Index: { auto* x = as<IndexNode>(e); expr(x->i); expr(x->j); lookup(x->name, x->depth, x->slot); return; }
+        case NodeKind::IndexAssign: { auto* a = as<IndexAssignNode>(e); expr(a->at); expr(a->rhs); return; }
+        case NodeKind::Len: { auto* l = as<LenNode>(e); lookup(l->name, l->depth, l->slot); return; }
+        default: return;
+        }
+    }
+
+    void function(FuncDefNode* f){
+        scopes.clear(); next_slot = nslots = 0;
+        push();
+        if(f->params) for(auto* p: f->params->params){ p->depth = 0; p->slot = decl(p->name); }
+        stmt(f->body);
+        pop();
+        f->nslots = nslots;
+    }
+};
+
+} // namespace
+
+void resolve_program(Program* p){
+    Resolver r;
+    for(auto* it : p->items){
+        if(it->kind == NodeKind::FuncDef) r.function(as<FuncDefNode>(it));
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "ast.hpp"
+
+/*
+ * Статичне розв'язання змінних: кожен DeclNode/ParamNode отримує фіксований
+ * (depth, slot) у кадрі своєї функції, а VarRefNode/AssignNode — копію цієї пари.
+ * Слоти блоків, що закрилися, перевикористовуються; FuncDefNode::nslots —
+ * розмір кадру. Кидає std::runtime_error на Redeclaration/Undeclared.
+ * Ідемпотентний: можна викликати повторно після перетворень AST.
+ */
+void resolve_program(Program* p);
@@ -0,0 +1,343 @@
+#include "typecheck.hpp"
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+bool numeric(Type t){ return t == Type::Int || t == Type::Double; }
+
+[[noreturn]] void type_error(const std::string& msg){ throw std::runtime_error("Type error: "+msg); }
+
+/* Тіло parallel for: що в ньому читається і пишеться (після resolve і типізації) */
+struct ParBody {
+    ForNode* fr;
+    int iv;
+    std::vector<bool> local = {}; // слоти, оголошені в тілі: у кожної ітерації свої
+
+    bool is_local(int slot) const { return slot < (int)local.size() && local[slot]; }
+    const Reduction* reduction(int slot) const {
+        for(auto& r: fr->reductions) if(r.slot == slot && !is_local(slot)) return &r;
+        return nullptr;
+    }
+    static bool mentions(ExprNode* e, int slot){
+        if(!e) return false;
+        switch(e->kind){
+        case NodeKind::VarRef: return as<VarRefNode>(e)->slot == slot;
+        case NodeKind::Assign: return as<AssignNode>(e)->slot == slot || mentions(as<AssignNode>(e)->rhs, slot);
+        case NodeKind::BinOp: return mentions(as<BinOpNode>(e)->a, slot) || mentions(as<BinOpNode>(e)->b, slot);
+        case NodeKind::UnaryOp: return mentions(as<UnaryOpNode>(e)->x, slot);
+        case NodeKind::Cast: return mentions(as<CastNode>(e)->x, slot);
+        case NodeKind::Call: {
+            auto* c = as<CallNode>(e);
+            if(c->args) for(auto* a: c->args->args) if(mentions(a, slot)) return true;
+            return false;
+        }
+        case NodeKind::Index: return mentions(as<IndexNode>(e)->i, slot) || mentions(as<IndexNode>(e)->j, slot);
+        case NodeKind::IndexAssign: return mentions(as<IndexAssignNode>(e)->at, slot) || mentions(as<IndexAssignNode>(e)->rhs, slot);
+        default: return false;
+        }
+    }
+    /* s — один з операндів ланцюжка s op a op b (дужки довільні) */
+    static bool operand(ExprNode* e, Op op, int slot){
+        if(e->kind == NodeKind::VarRef) return as<VarRefNode>(e)->slot == slot;
+        if(e->kind != NodeKind::BinOp || as<BinOpNode>(e)->op != op) return false;
+        return operand(as<BinOpNode>(e)->a, op, slot) || operand(as<BinOpNode>(e)->b, op, slot);
+    }
+    static int count(ExprNode* e, int slot){
+        if(!e) return 0;
+        switch(e->kind){
+        case NodeKind::VarRef: return as<VarRefNode>(e)->slot == slot;
+        case NodeKind::BinOp: return count(as<BinOpNode>(e)->a, slot) + count(as<BinOpNode>(e)->b, slot);
+        default: return mentions(e, slot);
+        }
+    }
+
+    void expr(ExprNode* e){
+        if(!e) return;
+        switch(e->kind){
+        case NodeKind::VarRef: {
+            auto* v = as<VarRefNode>(e);
+            if(reduction(v->slot))
+                type_error("parallel for reads reduction variable "+std::string(v->name)+" outside its update");
+            return;
+        }
+        case NodeKind::Assign: {
+            auto* a = as<AssignNode>(e);
+            if(is_local(a->slot)){ expr(a->rhs); return; }
+            if(a->slot == iv) type_error("parallel for modifies its loop variable "+std::string(a->name));
+            if(reduction(a->slot)) update(a, false);
+            type_error("parallel for writes outer variable "+std::string(a->name)
+                       +"; declare it inside the loop body or list it in reduction(...)");
+        }
+        case NodeKind::BinOp: expr(as<BinOpNode>(e)->a); expr(as<BinOpNode>(e)->b); return;
+        case NodeKind::UnaryOp: expr(as<UnaryOpNode>(e)->x); return;
+        case NodeKind::Cast: expr(as<CastNode>(e)->x); return;
+        case NodeKind::Call: { auto* c = as<CallNode>(e); if(c->args) for(auto* a: c->args->args) expr(a); return; }
+        case NodeKind::Index: expr(as<IndexNode>(e)->i); expr(as<IndexNode>(e)->j); return;
+        case NodeKind::IndexAssign: expr(as<IndexAssignNode>(e)->at); expr(as<IndexAssignNode>(e)->rhs); return;
+        default: return;
+        }
+    }
+    /* s = s op e окремою інструкцією: s рівно один раз, операндом ланцюжка того самого оператора */
+    void update(AssignNode* a, bool statement){
+        const Reduction* r = reduction(a->slot);
+        if(!statement || !operand(a->rhs, r->op, a->slot) || count(a->rhs, a->slot) != 1)
+            type_error("reduction variable "+std::string(a->name)+" must be updated by a statement "
+                       +std::string(a->name)+" = "+std::string(a->name)+" "+op_str(r->op)+" expr;");
+        skip(a->rhs, a->slot, r->op);
+    }
+    /* Ланцюжок s op a op b: перевіряються всі операнди, крім самого s */
+    void skip(ExprNode* e, int slot, Op op){
+        if(e->kind == NodeKind::VarRef && as<VarRefNode>(e)->slot == slot) return;
+        if(e->kind == NodeKind::BinOp && as<BinOpNode>(e)->op == op && mentions(e, slot)){
+            skip(as<BinOpNode>(e)->a, slot, op); skip(as<BinOpNode>(e)->b, slot, op);
+            return;
+        }
+        expr(e);
+    }
+
+    void stmt(AST* n){
+        if(!n) return;
+        switch(n->kind){
+        case NodeKind::Decl: {
+            auto* d = as<DeclNode>(n);
+            expr(d->init); expr(d->dims[0]); expr(d->dims[1]);
+            if(d->slot >= (int)local.size()) local.resize(d->slot + 1);
+            local[d->slot] = true;
+            return;
+        }
+        case NodeKind::ExprStmt: {
+            ExprNode* e = as<ExprStmtNode>(n)->expr;
+            if(e->kind == NodeKind::Assign && reduction(as<AssignNode>(e)->slot)) update(as<AssignNode>(e), true);
+            else expr(e);
+            return;
+        }
+        case NodeKind::Return: type_error("return inside parallel for");
+        case NodeKind::If: { auto* iff = as<IfNode>(n); expr(iff->cond); stmt(iff->thenN); stmt(iff->elseN); return; }
+        case NodeKind::While: { auto* wh = as<WhileNode>(n); expr(wh->cond); stmt(wh->body); return; }
+        case NodeKind::For: {
+            auto* f = as<ForNode>(n);
+            expr(f->init); expr(f->cond); expr(f->step); stmt(f->body);
+            return;
+        }
+        case NodeKind::Block: for(auto* s: as<BlockNode>(n)->stmts) stmt(s); return;
+        default: return;
+        }
+    }
+};
+
+struct Checker {
+    Arena& A;
+    std::unordered_map<Name,FuncDefNode*> funcs; // останнє визначення перемагає, як у collect_functions
+    std::vector<Type> slots; // тип кожного слоту кадру в поточній точці обходу
+    std::vector<uint8_t> ranks; // 0 — скаляр, 1/2 — масив (тип елемента в slots)
+    FuncDefNode* cur = nullptr;
+
+    explicit Checker(Arena& a): A(a){}
+
+    ExprNode* cast(ExprNode* e, Type t){ return e->type == t? e : A.make<CastNode>(t, e); }
+
+    /* Присвоєння, ініціалізація, аргумент, return */
+    ExprNode* convert(ExprNode* e, Type t, const std::string& where){
+        if(e->type == t) return e;
+        if(numeric(e->type) && numeric(t)) return cast(e, t);
+        type_error("cannot convert "+std::string(type_name(e->type))+" to "+type_name(t)+" in "+where);
+    }
+    /* Умова: число перевіряється на != 0 */
+    ExprNode* cond(ExprNode* e){
+        e = expr(e);
+        return e->type == Type::Bool? e : cast(e, Type::Bool);
+    }
+
+    /* Вираз, що має бути скаляром; масив допускається лише аргументом (any) */
+    ExprNode* expr(ExprNode* e){
+        e = any(e);
+        if(e && e->rank) type_error("array "+std::string(as<VarRefNode>(e)->name)+" used as a value");
+        return e;
+    }
+    ExprNode* index(ExprNode* e, Name a){
+        e = expr(e);
+        if(e->type != Type::Int) type_error("index of "+std::string(a)+" must be int, got "+type_name(e->type));
+        return e;
+    }
+    void array(int slot, Name a){ if(!ranks[slot]) type_error(std::string(a)+" is not an array"); }
+
+    ExprNode* any(ExprNode* e){
+        if(!e) return e;
+        switch(e->kind){
+        case NodeKind::Number: case NodeKind::Bool: return e;
+        case NodeKind::VarRef: { int s = as<VarRefNode>(e)->slot; e->type = slots[s]; e->rank = ranks[s]; return e; }
+        case NodeKind::Index: {
+            auto* x = as<IndexNode>(e);
+            array(x->slot, x->name);
+            if((x->j? 2 : 1) != ranks[x->slot])
+                type_error(std::string(x->name)+" has "+std::to_string(ranks[x->slot])+" dimension(s)");
+            x->i = index(x->i, x->name);
+            if(x->j) x->j = index(x->j, x->name);
+            x->type = slots[x->slot];
+            return e;
+        }
+        case NodeKind::IndexAssign: {
+            auto* a = as<IndexAssignNode>(e);
+            any(a->at);
+            a->type = a->at->type;
+            a->rhs = convert(expr(a->rhs), a->type, "assignment to "+std::string(a->at->name)+"[]");
+            return e;
+        }
+        case NodeKind::Len: {
+            auto* l = as<LenNode>(e);
+            array(l->slot, l->name);
+            if(l->dim >= ranks[l->slot]) type_error(std::string(l->name)+" has no dimension "+std::to_string(l->dim));
+            return e;
+        }
+        case NodeKind::Cast: { auto* c = as<CastNode>(e); c->x = expr(c->x); return e; }
+        case NodeKind::Assign: {
+            auto* a = as<AssignNode>(e);
+            if(ranks[a->slot]) type_error("cannot assign to array "+std::string(a->name));
+            a->type = slots[a->slot];
+            a->rhs = convert(expr(a->rhs), a->type, "assignment to "+std::string(a->name));
+            return e;
+        }
+        case NodeKind::UnaryOp: {
+            auto* u = as<UnaryOpNode>(e);
+            if(u->op == Op::Not){ u->x = cond(u->x); u->type = Type::Bool; return e; }
+            u->x = expr(u->x);
+            if(!numeric(u->x->type)) type_error(std::string("operator - is not defined for ")+type_name(u->x->type));
+            u->type = u->x->type;
+            return e;
+        }
+        case NodeKind::BinOp: {
+            auto* b = as<BinOpNode>(e);
+            if(b->op == Op::And || b->op == Op::Or){
+                b->a = cond(b->a); b->b = cond(b->b); b->type = Type::Bool;
+                return e;
+            }
+            b->a = expr(b->a); b->b = expr(b->b);
+            Type ta = b->a->type, tb = b->b->type;
+            bool cmp = b->op==Op::Lt || b->op==Op::Gt || b->op==Op::Le || b->op==Op::Ge || b->op==Op::Eq || b->op==Op::Ne;
+            if((b->op==Op::Eq || b->op==Op::Ne) && ta == Type::Bool && tb == Type::Bool){
+                b->a = cast(b->a, Type::Int); b->b = cast(b->b, Type::Int); b->type = Type::Bool;
+                return e;
+            }
+            if(!numeric(ta) || !numeric(tb))
+                type_error(std::string("operator ")+op_str(b->op)+" is not defined for "+type_name(ta)+" and "+type_name(tb));
+            if(b->op == Op::Mod && (ta != Type::Int || tb != Type::Int))
+                type_error(std::string("operator % requires int operands, got ")+type_name(ta)+" and "+type_name(tb));
+            Type t = (ta == Type::Double || tb == Type::Double)? Type::Double : Type::Int;
+            b->a = cast(b->a, t); b->b = cast(b->b, t);
+            b->type = cmp? Type::Bool : t;
+            return e;
+        }
+        case NodeKind::Call: {
+            auto* c = as<CallNode>(e);
+            auto it = funcs.find(c->name);
+            if(it == funcs.end()) type_error("unknown function "+std::string(c->name));
+            FuncDefNode* f = it->second;
+            size_t n = f->params? f->params->params.size() : 0;
+            size_t m = c->args? c->args->args.size() : 0;
+            if(n != m) type_error(std::string(c->name)+" expects "+std::to_string(n)+" argument(s), got "+std::to_string(m));
+            for(size_t i=0;i<n;++i){
+                auto*& a = c->args->args[i];
+                ParamNode* p = f->params->params[i];
+                std::string where = "argument "+std::to_string(i+1)+" of "+std::string(c->name);
+                if(!p->rank){ a = convert(expr(a), type_of(p->type), where); continue; }
+                // масив передається за посиланням: тип елемента і розмірність мають збігатися точно
+                a = any(a);
+                if(a->rank != p->rank || a->type != type_of(p->type))
+                    type_error(where+" must be "+std::string(p->type)+" array of "+std::to_string(p->rank)+" dimension(s)");
+            }
+            c->type = type_of(f->retType);
+            c->target = f;
+            return e;
+        }
+        default: return e;
+        }
+    }
+
+    /* parallel for: канонічний заголовок; тіло пише лише власні змінні, масиви
+       й редукції (s = s + e, де e не читає s); зовнішні скаляри лише читає */
+    void parallel(ForNode* fr){
+        ParLoop l;
+        if(!par_loop(fr, l))
+            type_error("parallel for must have the form i = a; i < b (or <=); i = i + c with int constant c > 0");
+        if(l.init->type != Type::Int || l.hi->type != Type::Int) type_error("parallel for needs an int loop variable and bound");
+        ParBody b{fr, l.init->slot};
+        if(b.mentions(l.hi, l.init->slot)) type_error("bound of parallel for depends on the loop variable");
+        for(size_t i=0;i<fr->reductions.size();++i){
+            Reduction& r = fr->reductions[i];
+            if(ranks[r.slot] || !numeric(slots[r.slot]))
+                type_error("reduction variable "+std::string(r.name)+" must be an int or double scalar");
+            if(r.slot == l.init->slot) type_error("loop variable "+std::string(r.name)+" cannot be a reduction variable");
+            for(size_t j=0;j<i;++j)
+                if(fr->reductions[j].slot == r.slot) type_error("duplicate reduction variable "+std::string(r.name));
+            r.type = slots[r.slot];
+        }
+        b.stmt(fr->body);
+    }
+
+    ExprNode* zero(Type t){
+        if(t == Type::Bool) return A.make<BoolNode>(false);
+        if(t == Type::Int) return A.make<NumberNode>(int64_t(0));
+        return A.make<NumberNode>(0.0);
+    }
+
+    void stmt(AST* n){
+        if(!n) return;
+        switch(n->kind){
+        case NodeKind::Decl: {
+            auto* d = as<DeclNode>(n);
+            Type t = type_of(d->type);
+            if(d->rank){
+                for(int k=0;k<d->rank;++k) d->dims[k] = index(d->dims[k], d->name);
+            } else d->init = d->init? convert(expr(d->init), t, "initialization of "+std::string(d->name)) : zero(t);
+            slots[d->slot] = t; ranks[d->slot] = (uint8_t)d->rank;
+            return;
+        }
+        case NodeKind::ExprStmt: { auto* es = as<ExprStmtNode>(n); es->expr = expr(es->expr); return; }
+        case NodeKind::Return: {
+            auto* r = as<ReturnNode>(n);
+            r->expr = convert(expr(r->expr), cur->ret, "return from "+std::string(cur->name));
+            return;
+        }
+        case NodeKind::If: { auto* iff = as<IfNode>(n); iff->cond = cond(iff->cond); stmt(iff->thenN); stmt(iff->elseN); return; }
+        case NodeKind::While: { auto* wh = as<WhileNode>(n); wh->cond = cond(wh->cond); stmt(wh->body); return; }
+        case NodeKind::For: {
+            auto* fr = as<ForNode>(n);
+            fr->init = expr(fr->init);
+            if(fr->cond) fr->cond = cond(fr->cond);
+            fr->step = expr(fr->step);
+            stmt(fr->body);
+            if(fr->parallel) parallel(fr);
+            return;
+        }
+        case NodeKind::Block: for(auto* s: as<BlockNode>(n)->stmts) stmt(s); return;
+        default: return;
+        }
+    }
+
+    void function(FuncDefNode* f){
+        cur = f;
+        slots.assign(f->nslots, Type::None); ranks.assign(f->nslots, 0);
+        if(f->params) for(auto* p: f->params->params){ slots[p->slot] = type_of(p->type); ranks[p->slot] = (uint8_t)p->rank; }
+        stmt(f->body);
+    }
+};
+
+} // namespace
+
+void typecheck_program(Program* p){
+    Checker c(p->arena);
+    int id = 0;
+    for(auto* it : p->items){
+        if(it->kind != NodeKind::FuncDef) continue;
+        auto* f = as<FuncDefNode>(it);
+        f->ret = type_of(f->retType);
+        f->id = id++;
+        c.funcs[f->name] = f;
+    }
+    for(auto* it : p->items){
+        if(it->kind == NodeKind::FuncDef) c.function(as<FuncDefNode>(it));
+    }
+}
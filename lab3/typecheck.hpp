@@ -0,0 +1,22 @@
+#pragma once
+#include "ast.hpp"
+
+/*
+ * Статична перевірка та виведення типів. Кожен ExprNode отримує type,
+ * FuncDefNode — ret. Правила (як у C, але без змішування bool і чисел):
+ *   - int і double змішуються вільно: int розширюється до double,
+ *     double -> int при присвоєнні/передачі/return — відкидання дробової частини;
+ *   - bool не перетворюється в число і навпаки, окрім умов (if/while/for,
+ *     &&, ||, !), де число порівнюється з нулем;
+ *   - % лише для int; ==/!= для двох bool порівнює їх як int.
+ * Усі неявні перетворення стають явними CastNode, тож у бінарних операціях
+ * обидва операнди мають однаковий тип і виконавцям не треба його перевіряти.
+ * Оголошення без ініціалізатора отримує нульовий літерал свого типу (масив
+ * init не має). Масиви — лише в індексуванні, len і як аргумент параметра
+ * тієї ж розмірності й типу елемента; індекси й розміри — int.
+ * Кожен CallNode отримує target, кожна FuncDefNode — id (порядковий номер).
+ * Програма має бути розв'язана (resolve_program). Кидає std::runtime_error
+ * на невідповідність типів, невідому функцію чи неправильну кількість аргументів.
+ * Ідемпотентна: наявні CastNode не дублюються.
+ */
+void typecheck_program(Program* p);
@@ -0,0 +1,161 @@
+#include "vm.hpp"
+#include <stdexcept>
+
+/*
+ * Цикл диспетчеризації: з GCC/Clang — computed goto (окремий непрямий
+ * перехід у кінці кожного обробника), інакше — звичайний switch.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+namespace {
+struct Frame { const BcFunc* fn; const Instr* ip; Value* base; size_t arrays; };
+}
+
+Value vm_call(const BcProgram& bp, const std::string& name, const std::vector<Value>& args, uint32_t max_depth){
+    int fi = bp.find(name);
+    if(fi < 0) throw std::runtime_error("Unknown function: "+name);
+    const BcFunc* fn = &bp.funcs[fi];
+    if((int)args.size() != fn->nparams) throw std::runtime_error("Arity mismatch in "+name);
+
+    std::vector<Value> stack(VM_STACK_SIZE);
+    std::vector<Frame> frames;
+    frames.reserve(64);
+    std::vector<std::unique_ptr<Array>> arrays; // живі масиви всіх кадрів, від старших до молодших
+    size_t amark = 0;                           // масиви поточного кадру — від amark
+    Value* const limit = stack.data() + stack.size();
+    const Value* K = bp.consts.data();
+    const BcFunc* funcs = bp.funcs.data();
+
+    Value* base = stack.data();
+    Value* sp = base;
+    if(fn->nslots + fn->max_stack > (int)stack.size()) throw std::runtime_error("VM stack overflow");
+    for(auto& a: args) *sp++ = a;
+    for(int i=fn->nparams; i<fn->nslots; ++i) *sp++ = Value();
+    const Instr* ip = fn->code.data();
+    Instr in;
+
+#ifdef VM_COMPUTED_GOTO
+    static void* const labels[] = {
+#define X(n) &&L_##n,
+        BC_OPCODES(X)
+#undef X
+    };
+#define CASE(n) L_##n:
+#define NEXT do{ in = *ip++; goto *labels[(int)in.op]; }while(0)
+    NEXT;
+#else
+#define CASE(n) case BcOp::n:
+#define NEXT continue
+    for(;;){
+    in = *ip++;
+    switch(in.op){
+#endif
+
+    CASE(CONST)  *sp++ = K[in.a]; NEXT;
+    CASE(LOAD)   *sp++ = base[in.a]; NEXT;
+    CASE(STORE)  base[in.a] = sp[-1]; NEXT;
+    CASE(POP)    --sp; NEXT;
+
+#define IBIN(n, make, expr) CASE(n){ int64_t A = sp[-2].i(), B = sp[-1].i(); sp[-2] = Value::make(expr); --sp; NEXT; }
+#define DBIN(n, make, expr) CASE(n){ double A = sp[-2].d(), B = sp[-1].d(); sp[-2] = Value::make(expr); --sp; NEXT; }
+    IBIN(IADD, integer, int_add(A,B))
+    IBIN(ISUB, integer, int_sub(A,B))
+    IBIN(IMUL, integer, int_mul(A,B))
+    CASE(IDIV){ int64_t B = sp[-1].i(); if(B == 0) throw std::runtime_error("Division by zero"); sp[-2] = Value::integer(int_div(sp[-2].i(), B)); --sp; NEXT; }
+    CASE(IMOD){ int64_t B = sp[-1].i(); if(B == 0) throw std::runtime_error("Division by zero"); sp[-2] = Value::integer(int_mod(sp[-2].i(), B)); --sp; NEXT; }
+    IBIN(ILT, boolean, A<B)
+    IBIN(IGT, boolean, A>B)
+    IBIN(ILE, boolean, A<=B)
+    IBIN(IGE, boolean, A>=B)
+    IBIN(IEQ, boolean, A==B)
+    IBIN(INE, boolean, A!=B)
+    DBIN(DADD, num, A+B)
+    DBIN(DSUB, num, A-B)
+    DBIN(DMUL, num, A*B)
+    DBIN(DDIV, num, A/B)
+    DBIN(DLT, boolean, A<B)
+    DBIN(DGT, boolean, A>B)
+    DBIN(DLE, boolean, A<=B)
+    DBIN(DGE, boolean, A>=B)
+    DBIN(DEQ, boolean, A==B)
+    DBIN(DNE, boolean, A!=B)
+#undef IBIN
+#undef DBIN
+
+    CASE(INEG)   sp[-1] = Value::integer(int_neg(sp[-1].i())); NEXT;
+    CASE(DNEG)   sp[-1] = Value::num(-sp[-1].d()); NEXT;
+    CASE(NOT)    sp[-1] = Value::boolean(!sp[-1].b()); NEXT;
+    CASE(I2D)    sp[-1] = Value::num((double)sp[-1].i()); NEXT;
+    CASE(D2I)    sp[-1] = Value::integer(d2i(sp[-1].d())); NEXT;
+    CASE(I2B)    sp[-1] = Value::boolean(sp[-1].i() != 0); NEXT;
+    CASE(D2B)    sp[-1] = Value::boolean(sp[-1].d() != 0); NEXT;
+
+    CASE(JMP)    ip = fn->code.data() + in.a; NEXT;
+    CASE(JMPF)   if(!(--sp)->b()) ip = fn->code.data() + in.a; NEXT;
+    CASE(ANDJ)   if(!sp[-1].b()) ip = fn->code.data() + in.a; else --sp; NEXT;
+    CASE(ORJ)    if(sp[-1].b()) ip = fn->code.data() + in.a; else --sp; NEXT;
+
+    CASE(CALL){
+        const BcFunc* callee = &funcs[in.a];
+        Value* nb = sp - callee->nparams;
+        if(nb + callee->nslots + callee->max_stack > limit) throw std::runtime_error("VM stack overflow");
+        if(frames.size() + 1 >= max_depth)
+            throw std::runtime_error("Call depth limit exceeded (max-depth="+std::to_string(max_depth)+")");
+        frames.push_back(Frame{fn, ip, base, amark});
+        amark = arrays.size();
+        fn = callee; base = nb; sp = base + callee->nparams;
+        for(int i=callee->nparams; i<callee->nslots; ++i) *sp++ = Value();
+        ip = callee->code.data();
+        NEXT;
+    }
+    CASE(TAILCALL){
+        // аргументи переїжджають на місце параметрів поточного кадру, frames не росте
+        const BcFunc* callee = &funcs[in.a];
+        if(base + callee->nslots + callee->max_stack > limit) throw std::runtime_error("VM stack overflow");
+        Value* args = sp - callee->nparams;
+        for(int i=0; i<callee->nparams; ++i) base[i] = args[i];
+        if(arrays.size() != amark) arrays.resize(amark); // масиви серед аргументів — лише параметри, створені до amark (tail_call)
+        fn = callee; sp = base + callee->nparams;
+        for(int i=callee->nparams; i<callee->nslots; ++i) *sp++ = Value();
+        ip = callee->code.data();
+        NEXT;
+    }
+    CASE(RET){
+        Value r = sp[-1];
+        if(frames.empty()) return r;
+        sp = base; *sp++ = r;
+        if(arrays.size() != amark) arrays.resize(amark);
+        const Frame& f = frames.back();
+        fn = f.fn; ip = f.ip; base = f.base; amark = f.arrays;
+        frames.pop_back();
+        NEXT;
+    }
+
+    CASE(ARR1){
+        arrays.push_back(new_array(sp[-1].i(), 1, 1));
+        base[in.a] = Value::array(arrays.back().get()); --sp;
+        NEXT;
+    }
+    CASE(ARR2){
+        arrays.push_back(new_array(sp[-2].i(), sp[-1].i(), 2));
+        base[in.a] = Value::array(arrays.back().get()); sp -= 2;
+        NEXT;
+    }
+    CASE(XLOAD1) sp[-1] = base[in.a].a()->at(sp[-1].i(), 0); NEXT;
+    CASE(XLOAD2) sp[-2] = base[in.a].a()->at(sp[-2].i(), sp[-1].i()); --sp; NEXT;
+    CASE(XSTORE1) base[in.a].a()->at(sp[-2].i(), 0) = sp[-1]; sp[-2] = sp[-1]; --sp; NEXT;
+    CASE(XSTORE2) base[in.a].a()->at(sp[-3].i(), sp[-2].i()) = sp[-1]; sp[-3] = sp[-1]; sp -= 2; NEXT;
+    CASE(ROWS)   *sp++ = Value::integer(base[in.a].a()->rows); NEXT;
+    CASE(COLS)   *sp++ = Value::integer(base[in.a].a()->cols); NEXT;
+    CASE(AMARK)  base[in.a] = Value::integer((int64_t)arrays.size()); NEXT;
+    CASE(AFREE)  arrays.resize((size_t)base[in.a].i()); NEXT;
+
+#ifndef VM_COMPUTED_GOTO
+    }
+    }
+#endif
+#undef CASE
+#undef NEXT
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "bytecode.hpp"
+
+/* Максимальний розмір стеку значень VM (слоти + операнди всіх кадрів). */
+constexpr size_t VM_STACK_SIZE = 1u << 20;
+
+/* max_depth — межа кількості активних кадрів, як World::max_depth */
+Value vm_call(const BcProgram& bp, const std::string& name, const std::vector<Value>& args,
+              uint32_t max_depth = DEFAULT_MAX_DEPTH);
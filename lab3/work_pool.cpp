@@ -0,0 +1,88 @@
+#include "work_pool.hpp"
+
+WorkPool::WorkPool(unsigned n){
+    if(n == 0) n = std::thread::hardware_concurrency();
+    if(n == 0) n = 1;
+    for(unsigned i=0;i<n;++i) queues.push_back(std::make_unique<Queue>());
+    for(unsigned i=1;i<n;++i) threads.emplace_back([this, i]{ loop(i); });
+}
+
+WorkPool::~WorkPool(){
+    { std::lock_guard<std::mutex> lk(m); stop = true; }
+    wake.notify_all();
+    for(auto& t : threads) t.join();
+}
+
+/* Наступна частина: спершу своя черга, потім половина чужого залишку */
+bool WorkPool::next(unsigned self, size_t& chunk, uint64_t& stolen){
+    {
+        Queue& q = *queues[self];
+        std::lock_guard<std::mutex> lk(q.m);
+        if(q.lo < q.hi){ chunk = q.lo++; return true; }
+    }
+    unsigned n = size();
+    for(unsigned k=1;k<n;++k){
+        Queue& v = *queues[(self + k) % n];
+        size_t lo, hi;
+        {
+            std::lock_guard<std::mutex> lk(v.m);
+            if(v.lo >= v.hi) continue;
+            hi = v.hi;
+            lo = v.lo + (v.hi - v.lo) / 2;
+            v.hi = lo;
+        }
+        stolen++;
+        chunk = lo;
+        if(lo + 1 < hi){
+            Queue& q = *queues[self];
+            std::lock_guard<std::mutex> lk(q.m);
+            q.lo = lo + 1; q.hi = hi;
+        }
+        return true;
+    }
+    return false;
+}
+
+void WorkPool::work(unsigned self){
+    size_t chunk;
+    uint64_t stolen = 0;
+    while(next(self, chunk, stolen)) (*job)(chunk, self);
+    if(stolen){ std::lock_guard<std::mutex> lk(m); steal_count += stolen; }
+}
+
+void WorkPool::loop(unsigned self){
+    uint64_t seen = 0;
+    for(;;){
+        {
+            std::unique_lock<std::mutex> lk(m);
+            wake.wait(lk, [&]{ return stop || generation != seen; });
+            if(stop) return;
+            seen = generation;
+        }
+        work(self);
+        std::lock_guard<std::mutex> lk(m);
+        if(--busy == 0) idle.notify_one();
+    }
+}
+
+void WorkPool::run(size_t chunks, const Body& body){
+    if(chunks == 0) return;
+    unsigned n = size();
+    // суцільні відрізки: потік k починає з частин [chunks*k/n, chunks*(k+1)/n)
+    for(unsigned k=0;k<n;++k){
+        std::lock_guard<std::mutex> lk(queues[k]->m);
+        queues[k]->lo = chunks * k / n;
+        queues[k]->hi = chunks * (k + 1) / n;
+    }
+    {
+        std::lock_guard<std::mutex> lk(m);
+        job = &body;
+        busy = n - 1;
+        generation++;
+    }
+    wake.notify_all();
+    work(0);
+    std::unique_lock<std::mutex> lk(m);
+    idle.wait(lk, [&]{ return busy == 0; });
+    job = nullptr;
+}
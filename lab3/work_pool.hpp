@@ -0,0 +1,52 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Пул потоків із крадіжкою роботи для parallel for (eval). Робота — номери
+ * частин [0, chunks). Кожен потік отримує суцільний відрізок і бере частини
+ * з його початку; звільнившись, забирає в іншого потоку верхню половину
+ * залишку (крадіжка з кінця, тож сусідні частини лишаються в одного потоку).
+ * Черга — лише відрізок [lo, hi) під власним м'ютексом: блокування одне на
+ * частину, а частина — тисячі ітерацій. Викликач run працює як потік 0,
+ * фонових потоків size() - 1; між викликами run вони сплять на умовній змінній.
+ */
+class WorkPool {
+public:
+    using Body = std::function<void(size_t chunk, unsigned worker)>;
+
+    /* threads == 0 — std::thread::hardware_concurrency() */
+    explicit WorkPool(unsigned threads);
+    ~WorkPool();
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+
+    unsigned size() const { return unsigned(queues.size()); }
+    /* body(chunk, worker) для кожної частини; повертається, коли виконано всі.
+       body не повинен кидати винятків — їх збирає викликач (exec_parallel_for) */
+    void run(size_t chunks, const Body& body);
+    /* скільки разів потоки забирали роботу в інших (для звітів бенчмарку) */
+    uint64_t steals() const { return steal_count; }
+
+private:
+    struct alignas(64) Queue { std::mutex m; size_t lo = 0, hi = 0; };
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex m;
+    std::condition_variable wake, idle;
+    const Body* job = nullptr;
+    uint64_t generation = 0;
+    unsigned busy = 0;
+    bool stop = false;
+    uint64_t steal_count = 0; // під m
+
+    bool next(unsigned self, size_t& chunk, uint64_t& stolen);
+    void work(unsigned self);
+    void loop(unsigned self);
+};
@@ -0,0 +1,312 @@
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "counters.h"
+#include "matrices.h"
+#include "work_pool.h"
+
+/*
+ * Вимір init_matrices і matrix_multiply зсередини процесу — замість ручних
+ * perf stat -d, /usr/bin/time і perf stat -e power/energy-pkg/ з фаз 1–2.
+ *   ./bench [--kernels=naive,blocked,...|all] [--sizes=N|MxNxK,...] [--reps=N] [--warmup=N]
+ *           [--threads=N] [--tile=MC,KC,NC] [--ptile=TM,TN] [--huge] [--no-pin]
+ *           [--label=TEXT] [--format=csv|json]
+ * Для кожного розміру init_matrices вимірюється reps разів (фаза init), далі
+ * кожна стратегія — warmup прогонів без виміру і reps вимірів (фаза multiply).
+ * Для кожної метрики — медіана, мінімум і стандартне відхилення; недоступна
+ * метрика (немає лічильника чи RAPL) — порожнє поле в CSV і null у JSON.
+ * label — позначка збірки (-O0, -O3...), за нею report.sh будує таблиці до/після.
+ */
+
+enum {
+    M_TIME,
+    M_GFLOPS,
+    M_CYCLES,
+    M_INSTRUCTIONS,
+    M_IPC,
+    M_L1_MISS,
+    M_LLC_MISS,
+    M_BRANCH_MISS,
+    M_JOULES,
+    METRICS
+};
+
+static const char* metric_names[METRICS] = {
+    "time_ms", "gflops", "cycles", "instructions", "ipc", "l1d_miss_pct", "llc_miss_pct", "branch_miss_pct", "joules",
+};
+
+typedef struct {
+    int ok; /* 0 — хоч в одному вимірі метрика недоступна */
+    double median, min, stddev;
+} Stat;
+
+typedef struct {
+    Counters counters;
+    Rapl rapl;
+    WorkPool* pool;
+    GemmOptions o;
+    unsigned flags;
+    int reps, warmup, json, rows;
+    const char* label;
+} Bench;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int cmp_double(const void* x, const void* y) {
+    double a = *(const double*)x, b = *(const double*)y;
+    return (a > b) - (a < b);
+}
+
+/* NAN у вибірці — метрика недоступна */
+static Stat stat_of(double* v, int n) {
+    Stat s = {0, 0.0, 0.0, 0.0};
+    for (int i = 0; i < n; i++)
+        if (isnan(v[i])) return s;
+    qsort(v, n, sizeof *v, cmp_double);
+    double mean = 0.0, sq = 0.0;
+    for (int i = 0; i < n; i++) mean += v[i] / n;
+    for (int i = 0; i < n; i++) sq += (v[i] - mean) * (v[i] - mean);
+    s.ok = 1;
+    s.median = n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+    s.min = v[0];
+    s.stddev = n > 1 ? sqrt(sq / (n - 1)) : 0.0;
+    return s;
+}
+
+static double ratio(const CounterSample* s, int num, int den, double scale) {
+    return s->ok[num] && s->ok[den] && s->value[den] > 0 ? s->value[num] / s->value[den] * scale : NAN;
+}
+
+/* Метрики одного виміру: t — секунди, flops — 0 для фази init */
+static void metrics(double* m, double t, double flops, const CounterSample* s, double joules) {
+    m[M_TIME] = t * 1e3;
+    m[M_GFLOPS] = flops > 0 && t > 0 ? flops / t * 1e-9 : NAN;
+    m[M_CYCLES] = s->ok[HW_CYCLES] ? s->value[HW_CYCLES] : NAN;
+    m[M_INSTRUCTIONS] = s->ok[HW_INSTRUCTIONS] ? s->value[HW_INSTRUCTIONS] : NAN;
+    m[M_IPC] = ratio(s, HW_INSTRUCTIONS, HW_CYCLES, 1.0);
+    m[M_L1_MISS] = ratio(s, HW_L1D_MISSES, HW_L1D_LOADS, 100.0);
+    m[M_LLC_MISS] = ratio(s, HW_LLC_MISSES, HW_LLC_LOADS, 100.0);
+    m[M_BRANCH_MISS] = ratio(s, HW_BRANCH_MISSES, HW_BRANCHES, 100.0);
+    m[M_JOULES] = joules >= 0 ? joules : NAN;
+}
+
+static void begin(Bench* b) {
+    rapl_start(&b->rapl);
+    counters_start(&b->counters);
+}
+
+static void end(Bench* b, double t0, double flops, double* m) {
+    double t = now_s() - t0;
+    CounterSample s;
+    counters_stop(&b->counters, &s);
+    metrics(m, t, flops, &s, rapl_stop(&b->rapl));
+}
+
+static void size_name(char* buf, size_t len, size_t m, size_t n, size_t k) {
+    if (m == n && n == k) snprintf(buf, len, "%zu", m);
+    else snprintf(buf, len, "%zux%zux%zu", m, n, k);
+}
+
+static void print_row(Bench* b, const char* phase, const char* kernel, const char* size, double (*samples)[METRICS]) {
+    Stat st[METRICS];
+    double v[b->reps];
+    for (int x = 0; x < METRICS; x++) {
+        for (int r = 0; r < b->reps; r++) v[r] = samples[r][x];
+        st[x] = stat_of(v, b->reps);
+    }
+    unsigned threads = b->pool ? pool_size(b->pool) : 1;
+    if (b->json) {
+        printf("%s\n    {\"label\": \"%s\", \"phase\": \"%s\", \"kernel\": \"%s\", \"size\": \"%s\", \"threads\": %u, \"reps\": %d",
+               b->rows ? "," : "", b->label, phase, kernel, size, threads, b->reps);
+        for (int x = 0; x < METRICS; x++) {
+            if (st[x].ok) printf(", \"%s\": {\"median\": %.6g, \"min\": %.6g, \"stddev\": %.6g}", metric_names[x], st[x].median, st[x].min, st[x].stddev);
+            else printf(", \"%s\": null", metric_names[x]);
+        }
+        printf("}");
+    } else {
+        printf("%s,%s,%s,%s,%u,%d", b->label, phase, kernel, size, threads, b->reps);
+        for (int x = 0; x < METRICS; x++) {
+            if (st[x].ok) printf(",%.6g,%.6g,%.6g", st[x].median, st[x].min, st[x].stddev);
+            else printf(",,,");
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+    b->rows++;
+}
+
+/* Один розмір: init_matrices reps разів, далі кожна стратегія з kinds */
+static int bench_size(Bench* b, size_t m, size_t n, size_t k, const int* kinds) {
+    char size[64];
+    size_name(size, sizeof size, m, n, k);
+    double (*samples)[METRICS] = calloc(b->reps, sizeof *samples);
+    if (!samples) return -1;
+    Matrices p;
+    int rc = 0;
+    for (int r = 0; r < b->reps && !rc; r++) {
+        if (r) free_matrices(&p);
+        begin(b);
+        double t0 = now_s();
+        rc = init_matrices(&p, m, n, k, 64, b->flags, &b->o, b->pool);
+        end(b, t0, 0.0, samples[r]);
+    }
+    if (rc) {
+        fprintf(stderr, "Cannot allocate %s\n", size);
+        free(samples);
+        return -1;
+    }
+    print_row(b, "init", "", size, samples);
+    for (int kd = 0; kd < GEMM_KINDS; kd++) {
+        if (!kinds[kd]) continue;
+        if (!gemm_available((GemmKind)kd)) {
+            fprintf(stderr, "%s is not supported on this CPU\n", gemm_name((GemmKind)kd));
+            continue;
+        }
+        for (int r = -b->warmup; r < b->reps && !rc; r++) {
+            clear_product(&p);
+            if (r >= 0) begin(b);
+            double t0 = now_s();
+            rc = matrix_multiply(&p, (GemmKind)kd, &b->o, b->pool);
+            if (r >= 0) end(b, t0, matrix_flops(&p), samples[r]);
+        }
+        if (rc) {
+            fprintf(stderr, "%s: failed\n", gemm_name((GemmKind)kd));
+            break;
+        }
+        print_row(b, "multiply", gemm_name((GemmKind)kd), size, samples);
+    }
+    free_matrices(&p);
+    free(samples);
+    return rc;
+}
+
+static void cpu_model(char* buf, size_t len) {
+    snprintf(buf, len, "unknown");
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (!f) return;
+    char line[256];
+    while (fgets(line, sizeof line, f)) {
+        char* v = strchr(line, ':');
+        if (strncmp(line, "model name", 10) != 0 || !v) continue;
+        v += strspn(v + 1, " \t") + 1;
+        v[strcspn(v, "\n")] = 0;
+        snprintf(buf, len, "%s", v);
+        // лапки й зворотні скісні не потрапляють у JSON
+        for (char* q = buf; (q = strpbrk(q, "\"\\")); q++) *q = '\'';
+        break;
+    }
+    fclose(f);
+}
+
+static const char* usage =
+    "Usage: %s [--kernels=naive,ikj,transposed,blocked,avx2|all] [--sizes=N|MxNxK,...] [--reps=N] [--warmup=N] "
+    "[--threads=N] [--tile=MC,KC,NC] [--ptile=TM,TN] [--huge] [--no-pin] [--label=TEXT] [--format=csv|json]\n";
+
+int main(int argc, char** argv) {
+    Bench b;
+    memset(&b, 0, sizeof b);
+    b.reps = 5;
+    b.warmup = 1;
+    b.label = "";
+    int kinds[GEMM_KINDS] = {0}, huge = 0, pin = 1;
+    kinds[GEMM_NAIVE] = kinds[GEMM_BLOCKED] = kinds[GEMM_AVX2] = 1;
+    const char* sizes = "800";
+    long threads = 1;
+    for (int i = 1; i < argc; i++) {
+        const char* s = argv[i];
+        if (strcmp(s, "--kernels=all") == 0) {
+            for (int kd = 0; kd < GEMM_KINDS; kd++) kinds[kd] = 1;
+        } else if (strncmp(s, "--kernels=", 10) == 0) {
+            char list[256];
+            snprintf(list, sizeof list, "%s", s + 10);
+            memset(kinds, 0, sizeof kinds);
+            for (char* t = strtok(list, ","); t; t = strtok(NULL, ",")) {
+                GemmKind kd;
+                if (gemm_parse(t, &kd)) { fprintf(stderr, "Unknown kernel: %s\n", t); return 1; }
+                kinds[kd] = 1;
+            }
+        } else if (strncmp(s, "--sizes=", 8) == 0) {
+            sizes = s + 8;
+        } else if (strncmp(s, "--reps=", 7) == 0) {
+            b.reps = atoi(s + 7);
+            if (b.reps < 1) { fprintf(stderr, "Invalid --reps: %s\n", s + 7); return 1; }
+        } else if (strncmp(s, "--warmup=", 9) == 0) {
+            b.warmup = atoi(s + 9);
+            if (b.warmup < 0) { fprintf(stderr, "Invalid --warmup: %s\n", s + 9); return 1; }
+        } else if (strncmp(s, "--threads=", 10) == 0) {
+            char* e;
+            threads = strtol(s + 10, &e, 10);
+            if (*e || threads < 0) { fprintf(stderr, "Invalid --threads: %s\n", s + 10); return 1; }
+        } else if (strncmp(s, "--tile=", 7) == 0) {
+            if (sscanf(s + 7, "%zu,%zu,%zu", &b.o.mc, &b.o.kc, &b.o.nc) != 3) { fprintf(stderr, "Invalid --tile: %s\n", s + 7); return 1; }
+        } else if (strncmp(s, "--ptile=", 8) == 0) {
+            if (sscanf(s + 8, "%zu,%zu", &b.o.tm, &b.o.tn) != 2) { fprintf(stderr, "Invalid --ptile: %s\n", s + 8); return 1; }
+        } else if (strcmp(s, "--huge") == 0) {
+            huge = 1;
+        } else if (strcmp(s, "--no-pin") == 0) {
+            pin = 0;
+        } else if (strncmp(s, "--label=", 8) == 0) {
+            b.label = s + 8;
+            if (strpbrk(b.label, ",\"\\")) { fprintf(stderr, "--label must not contain , \" or \\\n"); return 1; }
+        } else if (strcmp(s, "--format=csv") == 0 || strcmp(s, "--format=json") == 0) {
+            b.json = s[9] == 'j';
+        } else {
+            fprintf(stderr, usage, argv[0]);
+            return 1;
+        }
+    }
+
+    // до pool_create: потоки пулу успадковують лічильники (counters.h)
+    int events = counters_open(&b.counters);
+    int zones = rapl_open(&b.rapl);
+    if (threads != 1 && !(b.pool = pool_create((unsigned)threads, pin))) { fprintf(stderr, "Cannot start %ld threads\n", threads); return 1; }
+    b.flags = (b.pool ? MAT_LAZY : 0) | (huge ? MAT_HUGE : 0);
+
+    char cpu[128];
+    cpu_model(cpu, sizeof cpu);
+    fprintf(stderr, "cpu: %s\ncounters:", cpu);
+    for (int e = 0; e < HW_EVENTS; e++)
+        if (b.counters.fd[e] >= 0) fprintf(stderr, " %s", counters_name(e));
+    fprintf(stderr, "%s\nrapl: %d zone(s)%s\n", events ? "" : " unavailable (perf_event_open)", zones,
+            zones ? "" : ", energy unavailable");
+
+    if (b.json) {
+        printf("{\n  \"label\": \"%s\", \"cpu\": \"%s\", \"counters\": [", b.label, cpu);
+        const char* sep = "";
+        for (int e = 0; e < HW_EVENTS; e++) {
+            if (b.counters.fd[e] < 0) continue;
+            printf("%s\"%s\"", sep, counters_name(e));
+            sep = ", ";
+        }
+        printf("], \"rapl_zones\": %d,\n  \"results\": [", zones);
+    } else {
+        printf("label,phase,kernel,size,threads,reps");
+        for (int x = 0; x < METRICS; x++) printf(",%s_median,%s_min,%s_stddev", metric_names[x], metric_names[x], metric_names[x]);
+        printf("\n");
+    }
+
+    int rc = 0;
+    for (const char* s = sizes; *s && !rc;) {
+        char* e;
+        size_t m = strtoull(s, &e, 10), n = m, k = m;
+        if (*e == 'x') {
+            n = strtoull(e + 1, &e, 10);
+            if (*e == 'x') k = strtoull(e + 1, &e, 10);
+        }
+        if ((*e && *e != ',') || !m || !n || !k) { fprintf(stderr, "Invalid --sizes: %s\n", sizes); rc = 1; break; }
+        if (bench_size(&b, m, n, k, kinds)) rc = 1;
+        s = *e ? e + 1 : e;
+    }
+    if (b.json) printf("\n  ]\n}\n");
+
+    pool_destroy(b.pool);
+    counters_close(&b.counters);
+    return rc;
+}
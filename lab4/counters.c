@@ -0,0 +1,133 @@
+#define _DEFAULT_SOURCE
+#include "counters.h"
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define CACHE(cache, result) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | ((PERF_COUNT_HW_CACHE_RESULT_##result) << 16))
+
+static const struct {
+    const char* name; /* як у perf stat */
+    uint32_t type;
+    uint64_t config;
+} events[HW_EVENTS] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"L1-dcache-loads", PERF_TYPE_HW_CACHE, CACHE(PERF_COUNT_HW_CACHE_L1D, ACCESS)},
+    {"L1-dcache-load-misses", PERF_TYPE_HW_CACHE, CACHE(PERF_COUNT_HW_CACHE_L1D, MISS)},
+    {"LLC-loads", PERF_TYPE_HW_CACHE, CACHE(PERF_COUNT_HW_CACHE_LL, ACCESS)},
+    {"LLC-load-misses", PERF_TYPE_HW_CACHE, CACHE(PERF_COUNT_HW_CACHE_LL, MISS)},
+    {"branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+const char* counters_name(int event) { return (unsigned)event < HW_EVENTS ? events[event].name : "?"; }
+
+int counters_open(Counters* c) {
+    int opened = 0;
+    for (int e = 0; e < HW_EVENTS; e++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        attr.type = events[e].type;
+        attr.config = events[e].config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        c->fd[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (c->fd[e] >= 0) opened++;
+    }
+    return opened;
+}
+
+void counters_close(Counters* c) {
+    for (int e = 0; e < HW_EVENTS; e++) {
+        if (c->fd[e] >= 0) close(c->fd[e]);
+        c->fd[e] = -1;
+    }
+}
+
+/* RESET і ENABLE без PERF_IOC_FLAG_GROUP діють і на успадковані копії в потоках */
+void counters_start(Counters* c) {
+    for (int e = 0; e < HW_EVENTS; e++) {
+        if (c->fd[e] < 0) continue;
+        ioctl(c->fd[e], PERF_EVENT_IOC_RESET, 0);
+        ioctl(c->fd[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void counters_stop(Counters* c, CounterSample* s) {
+    for (int e = 0; e < HW_EVENTS; e++)
+        if (c->fd[e] >= 0) ioctl(c->fd[e], PERF_EVENT_IOC_DISABLE, 0);
+    for (int e = 0; e < HW_EVENTS; e++) {
+        // value, time_enabled, time_running; read сумує й живі потоки-нащадки
+        uint64_t v[3];
+        s->ok[e] = c->fd[e] >= 0 && read(c->fd[e], v, sizeof v) == (ssize_t)sizeof v && v[2] > 0;
+        s->value[e] = s->ok[e] ? (double)v[0] * ((double)v[1] / (double)v[2]) : 0.0;
+    }
+}
+
+#ifndef POWERCAP
+#define POWERCAP "/sys/class/powercap"
+#endif
+
+static int read_ull(const char* path, unsigned long long* v) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    int ok = fscanf(f, "%llu", v) == 1;
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+int rapl_open(Rapl* r) {
+    memset(r, 0, sizeof *r);
+    DIR* d = opendir(POWERCAP);
+    if (!d) return 0;
+    struct dirent* de;
+    while ((de = readdir(d)) && r->zones < RAPL_ZONES) {
+        // intel-rapl:N — пакет; intel-rapl:N:M (core, uncore, dram) уже входять у нього
+        unsigned pkg;
+        char tail;
+        if (sscanf(de->d_name, "intel-rapl:%u%c", &pkg, &tail) != 1) continue;
+        char path[160], name[32] = "";
+        snprintf(path, sizeof path, POWERCAP "/%.32s/name", de->d_name);
+        FILE* f = fopen(path, "r");
+        if (!f) continue;
+        int named = fscanf(f, "%31s", name) == 1;
+        fclose(f);
+        // psys на ноутбуках — уся платформа, разом із пакетами рахувалася б двічі
+        if (!named || strncmp(name, "package", 7) != 0) continue;
+        char* energy = r->path[r->zones];
+        snprintf(energy, sizeof r->path[0], POWERCAP "/%.32s/energy_uj", de->d_name);
+        snprintf(path, sizeof path, POWERCAP "/%.32s/max_energy_range_uj", de->d_name);
+        // energy_uj без прав root — зона недоступна
+        if (read_ull(energy, &r->start[r->zones]) || read_ull(path, &r->range[r->zones])) continue;
+        r->zones++;
+    }
+    closedir(d);
+    return r->zones;
+}
+
+void rapl_start(Rapl* r) {
+    for (int z = 0; z < r->zones; z++)
+        if (read_ull(r->path[z], &r->start[z])) r->start[z] = 0;
+}
+
+double rapl_stop(const Rapl* r) {
+    if (!r->zones) return -1.0;
+    unsigned long long uj = 0;
+    for (int z = 0; z < r->zones; z++) {
+        unsigned long long now;
+        if (read_ull(r->path[z], &now)) return -1.0;
+        uj += now >= r->start[z] ? now - r->start[z] : now + r->range[z] - r->start[z];
+    }
+    return (double)uj * 1e-6;
+}
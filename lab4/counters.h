@@ -0,0 +1,66 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+/*
+ * Апаратні лічильники через perf_event_open — ті самі події, що друкував
+ * `perf stat -d` у фазах 1–2, але навколо одного виклику, а не всієї програми.
+ * Кожна подія відкривається окремо (не групою): недоступна (LLC на AMD,
+ * віртуальна машина без PMU, perf_event_paranoid > 2) просто лишається n/a.
+ * Рахується лише простір користувача, тож sudo не потрібен.
+ * Лічильники успадковують потоки, створені ПІСЛЯ counters_open, і сумують їх
+ * із викликачем — пул (work_pool.h) треба створювати вже після відкриття.
+ */
+enum {
+    HW_CYCLES,
+    HW_INSTRUCTIONS,
+    HW_L1D_LOADS,
+    HW_L1D_MISSES,
+    HW_LLC_LOADS,
+    HW_LLC_MISSES,
+    HW_BRANCHES,
+    HW_BRANCH_MISSES,
+    HW_EVENTS
+};
+
+typedef struct {
+    int fd[HW_EVENTS]; /* -1 — подія недоступна */
+} Counters;
+
+/* Один вимір; ok[e] == 0 — подія e не рахувалася */
+typedef struct {
+    double value[HW_EVENTS];
+    int ok[HW_EVENTS];
+} CounterSample;
+
+const char* counters_name(int event);
+/* Скільки подій вдалося відкрити; 0 — perf_event_open недоступний */
+int counters_open(Counters* c);
+void counters_close(Counters* c);
+/* Обнулити й запустити */
+void counters_start(Counters* c);
+/* Зупинити й прочитати; якщо ядро мультиплексувало подію, значення масштабовано на time_enabled / time_running */
+void counters_stop(Counters* c, CounterSample* s);
+
+/*
+ * Енергія RAPL із powercap: /sys/class/powercap/intel-rapl:N/energy_uj, сума
+ * по зонах "package-N". Це енергія всього пакета процесора, а не лише цього
+ * процесу, — як power/energy-pkg/ у perf stat. Лічильник переповнюється на
+ * max_energy_range_uj, rapl_stop це враховує. На нових ядрах energy_uj читає
+ * лише root — тоді зон 0 і енергія n/a.
+ */
+#define RAPL_ZONES 8
+
+typedef struct {
+    int zones;
+    char path[RAPL_ZONES][96];
+    unsigned long long range[RAPL_ZONES];
+    unsigned long long start[RAPL_ZONES];
+} Rapl;
+
+/* Кількість доступних зон; 0 — RAPL недоступний */
+int rapl_open(Rapl* r);
+void rapl_start(Rapl* r);
+/* Джоулі від rapl_start; < 0 — недоступно */
+double rapl_stop(const Rapl* r);
+
+#endif
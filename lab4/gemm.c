@@ -0,0 +1,211 @@
+#define _DEFAULT_SOURCE
+#include "gemm_internal.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define HUGE_PAGE ((size_t)2 << 20)
+
+static size_t round_up(size_t x, size_t m) { return (x + m - 1) / m * m; }
+static size_t min_sz(size_t a, size_t b) { return a < b ? a : b; }
+
+/* Анонімний mmap без запису; huge — спершу hugetlbfs, потім THP */
+static double* map_pages(size_t* bytes, int want_huge, int* huge) {
+    *huge = 0;
+    if (want_huge) {
+        size_t hb = round_up(*bytes, HUGE_PAGE);
+#ifdef MAP_HUGETLB
+        void* p = mmap(NULL, hb, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            *bytes = hb;
+            *huge = 2;
+            return p;
+        }
+#endif
+        *bytes = hb;
+    }
+    void* p = mmap(NULL, *bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+    if (want_huge && madvise(p, *bytes, MADV_HUGEPAGE) == 0) *huge = 1;
+#endif
+    return p;
+}
+
+int mat_alloc_ex(Matrix* m, size_t rows, size_t cols, size_t align, unsigned flags) {
+    memset(m, 0, sizeof *m);
+    if (align < sizeof(double) || (align & (align - 1))) return -1;
+    size_t ld = round_up(cols ? cols : 1, align / sizeof(double));
+    if (rows && ld > (size_t)-1 / sizeof(double) / rows) return -1;
+    size_t bytes = round_up(rows * ld * sizeof(double), align);
+    if (!bytes) bytes = align;
+    double* p;
+    if (flags & (MAT_LAZY | MAT_HUGE)) {
+        if (align > (size_t)sysconf(_SC_PAGESIZE)) return -1;
+        p = map_pages(&bytes, (flags & MAT_HUGE) != 0, &m->huge);
+        if (!p) return -1;
+        m->mapped = bytes;
+    } else {
+        p = aligned_alloc(align, bytes);
+        if (!p) return -1;
+        memset(p, 0, bytes);
+    }
+    m->data = p;
+    m->rows = rows;
+    m->cols = cols;
+    m->ld = ld;
+    return 0;
+}
+
+int mat_alloc(Matrix* m, size_t rows, size_t cols, size_t align) { return mat_alloc_ex(m, rows, cols, align, 0); }
+
+void mat_free(Matrix* m) {
+    if (m->mapped) munmap(m->data, m->mapped);
+    else free(m->data);
+    memset(m, 0, sizeof *m);
+}
+
+Matrix mat_view(const Matrix* m, size_t i, size_t j, size_t rows, size_t cols) {
+    Matrix v = {&MAT(m, i, j), rows, cols, m->ld, 0, m->huge};
+    return v;
+}
+
+void gemm_work_free(GemmWork* w) {
+    free(w->pa);
+    free(w->pb);
+    memset(w, 0, sizeof *w);
+}
+
+static const char* names[GEMM_KINDS] = {"naive", "ikj", "transposed", "blocked", "avx2"};
+
+const char* gemm_name(GemmKind k) { return (unsigned)k < GEMM_KINDS ? names[k] : "?"; }
+
+int gemm_parse(const char* name, GemmKind* k) {
+    for (int i = 0; i < GEMM_KINDS; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *k = (GemmKind)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int gemm_available(GemmKind k) { return k == GEMM_AVX2 ? gemm_avx2_supported() : (unsigned)k < GEMM_KINDS; }
+
+void gemm_defaults(GemmKind k, GemmOptions* o) {
+    // blocked: плитка B kc x nc = 256 КБ (L2), рядок C і рядок B плитки — в L1;
+    // avx2: панель A mc x kc = 144 КБ (L2), смуга B kc x 8 = 16 КБ (L1), як у BLIS для Haswell
+    size_t mc = k == GEMM_AVX2 ? 72 : 64, kc = k == GEMM_AVX2 ? 256 : 128, nc = k == GEMM_AVX2 ? 4080 : 256;
+    if (!o->mc) o->mc = mc;
+    if (!o->kc) o->kc = kc;
+    if (!o->nc) o->nc = nc;
+    // плитка потоку: 144 x 256 — ціле число смуг мікроядра, для 800 x 800 — 24 плитки
+    if (!o->tm) o->tm = 144;
+    if (!o->tn) o->tn = 256;
+}
+
+static void naive(Matrix* c, const Matrix* a, const Matrix* b) {
+    size_t i, j, k;
+    for (i = 0; i < c->rows; i++) {
+        for (j = 0; j < c->cols; j++) {
+            for (k = 0; k < a->cols; k++) {
+                MAT(c, i, j) += MAT(a, i, k) * MAT(b, k, j);
+            }
+        }
+    }
+}
+
+/* c[i][j] за незмінного k оновлюється по j підряд — компілятор векторизує внутрішній цикл */
+static void ikj_range(Matrix* c, const Matrix* a, const Matrix* b,
+                      size_t i0, size_t i1, size_t k0, size_t k1, size_t j0, size_t j1) {
+    for (size_t i = i0; i < i1; i++) {
+        double* restrict ci = &MAT(c, i, 0);
+        for (size_t k = k0; k < k1; k++) {
+            double aik = MAT(a, i, k);
+            const double* restrict bk = &MAT(b, k, 0);
+            for (size_t j = j0; j < j1; j++) ci[j] += aik * bk[j];
+        }
+    }
+}
+
+/* Транспонування входить у час множення: копія B — частина цієї стратегії */
+static int transposed(Matrix* c, const Matrix* a, const Matrix* b) {
+    Matrix bt;
+    if (mat_alloc(&bt, b->cols, b->rows, 64)) return -1;
+    for (size_t k = 0; k < b->rows; k++)
+        for (size_t j = 0; j < b->cols; j++) MAT(&bt, j, k) = MAT(b, k, j);
+    for (size_t i = 0; i < c->rows; i++) {
+        const double* ai = &MAT(a, i, 0);
+        for (size_t j = 0; j < c->cols; j++) {
+            const double* bj = &MAT(&bt, j, 0);
+            double s = MAT(c, i, j);
+            for (size_t k = 0; k < a->cols; k++) s += ai[k] * bj[k];
+            MAT(c, i, j) = s;
+        }
+    }
+    mat_free(&bt);
+    return 0;
+}
+
+/*
+ * Плитки: для кожної смуги стовпців [jc, jc + nc) і глибини [pc, pc + kc) плитка
+ * B лишається в кеші, поки по ній проходять усі рядки A блоками по mc.
+ * k-блоки йдуть по зростанню, тож порядок додавання в c[i][j] той самий, що в naive.
+ */
+static void blocked(const GemmOptions* o, Matrix* c, const Matrix* a, const Matrix* b) {
+    size_t m = c->rows, n = c->cols, kk = a->cols;
+    for (size_t jc = 0; jc < n; jc += o->nc)
+        for (size_t pc = 0; pc < kk; pc += o->kc)
+            for (size_t ic = 0; ic < m; ic += o->mc)
+                ikj_range(c, a, b, ic, min_sz(ic + o->mc, m), pc, min_sz(pc + o->kc, kk), jc, min_sz(jc + o->nc, n));
+}
+
+int gemm_run(GemmKind k, const GemmOptions* o, Matrix* c, const Matrix* a, const Matrix* b, GemmWork* w) {
+    switch (k) {
+    case GEMM_NAIVE: naive(c, a, b); return 0;
+    case GEMM_IKJ: ikj_range(c, a, b, 0, c->rows, 0, a->cols, 0, c->cols); return 0;
+    case GEMM_TRANSPOSED: return transposed(c, a, b);
+    case GEMM_BLOCKED: blocked(o, c, a, b); return 0;
+    case GEMM_AVX2: return gemm_avx2(o, c, a, b, w);
+    default: return -1;
+    }
+}
+
+int gemm(GemmKind k, const GemmOptions* o, Matrix* c, const Matrix* a, const Matrix* b) {
+    if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols || !gemm_available(k)) return -1;
+    GemmOptions t = {0};
+    if (o) t = *o;
+    gemm_defaults(k, &t);
+    GemmWork w = {0};
+    int rc = gemm_run(k, &t, c, a, b, &w);
+    gemm_work_free(&w);
+    return rc;
+}
+
+size_t gemm_check(const Matrix* c, const Matrix* ref, const Matrix* a, const Matrix* b, double* max_rel) {
+    size_t bad = 0, kk = a->cols;
+    double worst = 0.0;
+    double* bound = calloc(c->cols ? c->cols : 1, sizeof(double));
+    if (!bound) return c->rows * c->cols;
+    for (size_t i = 0; i < c->rows; i++) {
+        // рядок |A| |B| тим самим i-k-j
+        memset(bound, 0, c->cols * sizeof(double));
+        for (size_t k = 0; k < kk; k++) {
+            double aik = fabs(MAT(a, i, k));
+            for (size_t j = 0; j < c->cols; j++) bound[j] += aik * fabs(MAT(b, k, j));
+        }
+        for (size_t j = 0; j < c->cols; j++) {
+            double diff = fabs(MAT(c, i, j) - MAT(ref, i, j));
+            double tol = 4.0 * (double)kk * DBL_EPSILON * bound[j];
+            double rel = diff == 0.0 ? 0.0 : tol > 0.0 ? diff / tol : INFINITY;
+            if (rel > worst || rel != rel) worst = rel != rel ? INFINITY : rel;
+            if (!(diff <= tol)) bad++;
+        }
+    }
+    free(bound);
+    if (max_rel) *max_rel = worst;
+    return bad;
+}
@@ -0,0 +1,102 @@
+#ifndef GEMM_H
+#define GEMM_H
+#include <stddef.h>
+
+/*
+ * Матриця double рядок за рядком. ld — крок між рядками в елементах (ld >= cols):
+ * його округлено так, щоб кожен рядок починався з адреси, кратної вирівнюванню
+ * з mat_alloc. Розміри й вирівнювання задаються під час виконання.
+ */
+typedef struct {
+    double* data;
+    size_t rows, cols, ld;
+    size_t mapped; /* байтів під mmap (MAT_LAZY / MAT_HUGE), 0 — aligned_alloc */
+    int huge;      /* MAT_HUGE: 2 — сторінки hugetlbfs, 1 — madvise(MADV_HUGEPAGE), 0 — звичайні */
+} Matrix;
+
+#define MAT(m, i, j) ((m)->data[(size_t)(i) * (m)->ld + (j)])
+
+/* Підматриця [i, i + rows) x [j, j + cols) над тією самою пам'яттю (не звільняти) */
+Matrix mat_view(const Matrix* m, size_t i, size_t j, size_t rows, size_t cols);
+
+/*
+ * Прапорці mat_alloc_ex. MAT_LAZY — анонімний mmap без запису: нулі дає ядро,
+ * а фізична сторінка з'являється на вузлі NUMA потоку, що першим у неї пише
+ * (first touch; див. gemm_first_touch). MAT_HUGE — те саме на великих
+ * сторінках: спершу MAP_HUGETLB (потрібні сторінки в /proc/sys/vm/nr_hugepages),
+ * інакше прозорі (THP) через madvise, інакше звичайні; що вийшло — у huge.
+ */
+enum { MAT_LAZY = 1, MAT_HUGE = 2 };
+
+/* 0 — успіх; align — степінь двійки, не менша за sizeof(double). Пам'ять обнулена */
+int mat_alloc(Matrix* m, size_t rows, size_t cols, size_t align);
+/* mat_alloc з прапорцями MAT_*; для mmap align не більше за розмір сторінки */
+int mat_alloc_ex(Matrix* m, size_t rows, size_t cols, size_t align, unsigned flags);
+void mat_free(Matrix* m);
+
+/* Стратегії C += A * B (порядок — від найповільнішої) */
+typedef enum {
+    GEMM_NAIVE,      /* i-j-k, як у вихідному matrix.c */
+    GEMM_IKJ,        /* i-k-j: внутрішній цикл іде рядком B і рядком C */
+    GEMM_TRANSPOSED, /* i-j-k над транспонованою копією B: обидва операнди підряд */
+    GEMM_BLOCKED,    /* i-k-j по плитках mc x kc x nc, що лишаються в кеші */
+    GEMM_AVX2,       /* пакування панелей + мікроядро 6x8 на AVX2/FMA */
+    GEMM_KINDS
+} GemmKind;
+
+/*
+ * Розміри плиток для GEMM_BLOCKED і GEMM_AVX2: mc рядків A, kc — глибина
+ * (стовпців A / рядків B), nc стовпців B. tm x tn — плитка C, яку в
+ * gemm_parallel рахує один потік. 0 — типове значення стратегії.
+ */
+typedef struct {
+    size_t mc, kc, nc;
+    size_t tm, tn;
+} GemmOptions;
+
+const char* gemm_name(GemmKind k);
+/* 0 — назву розпізнано */
+int gemm_parse(const char* name, GemmKind* k);
+/* 0, якщо стратегія недоступна на цьому процесорі (GEMM_AVX2 без AVX2/FMA) */
+int gemm_available(GemmKind k);
+/* Заповнює нулі в o типовими розмірами плиток стратегії k */
+void gemm_defaults(GemmKind k, GemmOptions* o);
+
+/*
+ * C += A * B; c має бути a->rows x b->cols, a->cols == b->rows.
+ * 0 — успіх, -1 — невідповідні розміри, недоступна стратегія чи нестача пам'яті.
+ * GEMM_NAIVE, IKJ, TRANSPOSED і BLOCKED додають добутки до кожного c[i][j]
+ * в одному порядку k, тож без -ffast-math дають побітово однаковий результат;
+ * AVX2 (FMA, окремий накопичувач) відрізняється в межах похибки округлення.
+ */
+int gemm(GemmKind k, const GemmOptions* o, Matrix* c, const Matrix* a, const Matrix* b);
+
+/*
+ * Багатопотоковий C += A * B: C ділиться на плитки tm x tn, кожну рахує один
+ * потік пулу (work_pool.h) послідовною стратегією k над підматрицями, з
+ * власними буферами пакування. Порядок додавання в кожен c[i][j] той самий,
+ * що й у gemm з тими самими mc/kc/nc, тож результат не залежить від кількості
+ * потоків і крадіжок. Коди повернення — як у gemm.
+ */
+struct WorkPool;
+int gemm_parallel(GemmKind k, const GemmOptions* o, struct WorkPool* pool, Matrix* c, const Matrix* a, const Matrix* b);
+
+/*
+ * First touch для gemm_parallel з тими самими o і pool: кожен потік записує
+ * нулі у свої плитки C і в рядки A, з яких ці плитки читають, — тож на
+ * NUMA-машині сторінки опиняються на вузлі потоку, що їх потім рахує
+ * (без крадіжок розподіл плиток у pool_run однаковий). Має сенс лише для
+ * MAT_LAZY / MAT_HUGE, поки в пам'ять ще ніхто не писав; A заповнюється після.
+ * Сторінка спільна для сусідніх плиток, тож точність — до сторінки.
+ */
+void gemm_first_touch(const GemmOptions* o, struct WorkPool* pool, Matrix* c, Matrix* a);
+
+/*
+ * Перевірка проти еталона: |c - ref| <= tol, де tol для кожного елемента —
+ * 4 * K * DBL_EPSILON * (|A| |B|)[i][j] (стандартна оцінка похибки суми K
+ * добутків). Повертає кількість елементів поза межею, *max_rel — найбільше
+ * відношення |c - ref| / tol (≤ 1 — у межах оцінки).
+ */
+size_t gemm_check(const Matrix* c, const Matrix* ref, const Matrix* a, const Matrix* b, double* max_rel);
+
+#endif
@@ -0,0 +1,134 @@
+#include "gemm_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * GEMM_AVX2 за схемою BLIS/GotoBLAS. Для кожної смуги стовпців B [jc, jc + nc)
+ * і глибини [pc, pc + kc) плитка B пакується в смуги по NR стовпців, далі для
+ * кожного блоку рядків A [ic, ic + mc) — панель A в смуги по MR рядків. Обидві
+ * упаковки читаються мікроядром строго послідовно. Мікроядро рахує блок C
+ * MR x NR = 6 x 8 у 12 регістрах ymm (2 на рядок) через FMA і лише тоді додає
+ * його до C. Краї доповнено нулями в упаковці, тож ядро одне на всі розміри.
+ * Інструкції AVX2/FMA дозволено лише функціям цього файлу (target), тож решта
+ * програми збирається для будь-якого x86-64, а gemm_available перевіряє CPU.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+#define MR 6
+#define NR 8
+
+int gemm_avx2_supported(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static size_t min_sz(size_t a, size_t b) { return a < b ? a : b; }
+static size_t round_up(size_t x, size_t m) { return (x + m - 1) / m * m; }
+
+/* A[i0.., p0..] mc x kc: смуга за смугою, у смузі для кожного p — MR значень стовпця */
+static void pack_a(double* restrict dst, const Matrix* a, size_t i0, size_t p0, size_t mc, size_t kc) {
+    for (size_t i = 0; i < mc; i += MR) {
+        size_t mr = min_sz(MR, mc - i);
+        for (size_t p = 0; p < kc; p++) {
+            size_t r = 0;
+            for (; r < mr; r++) *dst++ = MAT(a, i0 + i + r, p0 + p);
+            for (; r < MR; r++) *dst++ = 0.0;
+        }
+    }
+}
+
+/* B[p0.., j0..] kc x nc: смуга за смугою, у смузі для кожного p — NR значень рядка */
+static void pack_b(double* restrict dst, const Matrix* b, size_t p0, size_t j0, size_t kc, size_t nc) {
+    for (size_t j = 0; j < nc; j += NR) {
+        size_t nr = min_sz(NR, nc - j);
+        for (size_t p = 0; p < kc; p++) {
+            const double* row = &MAT(b, p0 + p, j0 + j);
+            size_t r = 0;
+            for (; r < nr; r++) *dst++ = row[r];
+            for (; r < NR; r++) *dst++ = 0.0;
+        }
+    }
+}
+
+#define ROW(r)                                                                     \
+    do {                                                                           \
+        __m256d ar = _mm256_broadcast_sd(a + r);                                   \
+        c##r##0 = _mm256_fmadd_pd(ar, b0, c##r##0);                                \
+        c##r##1 = _mm256_fmadd_pd(ar, b1, c##r##1);                                \
+    } while (0)
+
+#define STORE(r)                                                                   \
+    do {                                                                           \
+        _mm256_store_pd(t + r * NR, c##r##0);                                      \
+        _mm256_store_pd(t + r * NR + 4, c##r##1);                                  \
+    } while (0)
+
+/* C[0..mr, 0..nr] += смуга A (kc x MR) * смуга B (kc x NR); ldc — крок рядків C */
+__attribute__((target("avx2,fma")))
+static void kernel(size_t kc, const double* restrict a, const double* restrict b,
+                   double* c, size_t ldc, size_t mr, size_t nr) {
+    __m256d c00 = _mm256_setzero_pd(), c01 = c00, c10 = c00, c11 = c00, c20 = c00, c21 = c00;
+    __m256d c30 = c00, c31 = c00, c40 = c00, c41 = c00, c50 = c00, c51 = c00;
+    for (size_t p = 0; p < kc; p++) {
+        __m256d b0 = _mm256_load_pd(b), b1 = _mm256_load_pd(b + 4);
+        ROW(0); ROW(1); ROW(2); ROW(3); ROW(4); ROW(5);
+        a += MR;
+        b += NR;
+    }
+    _Alignas(32) double t[MR * NR];
+    STORE(0); STORE(1); STORE(2); STORE(3); STORE(4); STORE(5);
+    if (mr == MR && nr == NR) {
+        for (size_t r = 0; r < MR; r++) {
+            double* cr = c + r * ldc;
+            _mm256_storeu_pd(cr, _mm256_add_pd(_mm256_loadu_pd(cr), _mm256_load_pd(t + r * NR)));
+            _mm256_storeu_pd(cr + 4, _mm256_add_pd(_mm256_loadu_pd(cr + 4), _mm256_load_pd(t + r * NR + 4)));
+        }
+        return;
+    }
+    for (size_t r = 0; r < mr; r++)
+        for (size_t j = 0; j < nr; j++) c[r * ldc + j] += t[r * NR + j];
+}
+
+/* Буфер щонайменше need double, вирівняний на 64; старий вміст не потрібен */
+static double* reserve(double** p, size_t* cap, size_t need) {
+    if (*cap >= need) return *p;
+    free(*p);
+    *p = aligned_alloc(64, round_up(need * sizeof(double), 64));
+    *cap = *p ? need : 0;
+    return *p;
+}
+
+int gemm_avx2(const GemmOptions* o, Matrix* c, const Matrix* a, const Matrix* b, GemmWork* w) {
+    size_t m = c->rows, n = c->cols, kk = a->cols;
+    if (!m || !n || !kk) return 0;
+    // смуги цілі: mc кратне MR, nc кратне NR
+    size_t mc = round_up(min_sz(o->mc, m), MR), kc = min_sz(o->kc, kk), nc = round_up(min_sz(o->nc, n), NR);
+    double* pa = reserve(&w->pa, &w->na, mc * kc);
+    double* pb = reserve(&w->pb, &w->nb, kc * nc);
+    if (!pa || !pb) return -1;
+    for (size_t jc = 0; jc < n; jc += nc) {
+        size_t nb = min_sz(nc, n - jc);
+        for (size_t pc = 0; pc < kk; pc += kc) {
+            size_t kb = min_sz(kc, kk - pc);
+            pack_b(pb, b, pc, jc, kb, nb);
+            for (size_t ic = 0; ic < m; ic += mc) {
+                size_t mb = min_sz(mc, m - ic);
+                pack_a(pa, a, ic, pc, mb, kb);
+                for (size_t jr = 0; jr < nb; jr += NR)
+                    for (size_t ir = 0; ir < mb; ir += MR)
+                        kernel(kb, pa + ir * kb, pb + jr * kb, &MAT(c, ic + ir, jc + jr), c->ld,
+                               min_sz(MR, mb - ir), min_sz(NR, nb - jr));
+            }
+        }
+    }
+    return 0;
+}
+
+#else
+
+int gemm_avx2_supported(void) { return 0; }
+int gemm_avx2(const GemmOptions* o, Matrix* c, const Matrix* a, const Matrix* b, GemmWork* w) { return -1; }
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef GEMM_INTERNAL_H
+#define GEMM_INTERNAL_H
+#include "gemm.h"
+
+/*
+ * Спільне для gemm.c, gemm_avx2.c і gemm_parallel.c, не для користувачів gemm.h.
+ * GemmWork — буфери пакування мікроядра: ростуть за потреби й живуть між
+ * викликами, тож gemm_parallel дає кожному потоку свої (виділені й уперше
+ * записані ним самим — first touch) замість malloc на кожну плитку.
+ */
+typedef struct {
+    double *pa, *pb;
+    size_t na, nb; /* місткість у double */
+} GemmWork;
+
+void gemm_work_free(GemmWork* w);
+
+/* gemm без перевірок і типових значень: o уже заповнений gemm_defaults */
+int gemm_run(GemmKind k, const GemmOptions* o, Matrix* c, const Matrix* a, const Matrix* b, GemmWork* w);
+
+int gemm_avx2_supported(void);
+int gemm_avx2(const GemmOptions* o, Matrix* c, const Matrix* a, const Matrix* b, GemmWork* w);
+
+#endif
@@ -0,0 +1,75 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gemm_internal.h"
+#include "work_pool.h"
+
+/*
+ * Плитки C нумеруються по рядках: t -> (t / cols, t % cols). Потік починає з
+ * суцільного відрізка номерів (work_pool.h), тож його плитки — кілька
+ * послідовних смуг рядків, і ті самі рядки A лишаються в його кеші.
+ */
+typedef struct {
+    GemmKind kind;
+    GemmOptions o;
+    Matrix *c, *a;
+    const Matrix* b;
+    size_t rows, cols; /* плиток по вертикалі й горизонталі */
+    GemmWork* work;    /* по одному на потік */
+    atomic_int failed;
+} Tiles;
+
+static size_t min_sz(size_t a, size_t b) { return a < b ? a : b; }
+
+static void tiles_init(Tiles* t, GemmKind k, const GemmOptions* o, Matrix* c, Matrix* a, const Matrix* b) {
+    memset(t, 0, sizeof *t);
+    t->kind = k;
+    if (o) t->o = *o;
+    gemm_defaults(k, &t->o);
+    t->c = c;
+    t->a = a;
+    t->b = b;
+    t->rows = (c->rows + t->o.tm - 1) / t->o.tm;
+    t->cols = (c->cols + t->o.tn - 1) / t->o.tn;
+    atomic_init(&t->failed, 0);
+}
+
+static void tile_gemm(void* arg, size_t task, unsigned worker) {
+    Tiles* t = arg;
+    if (atomic_load_explicit(&t->failed, memory_order_relaxed)) return;
+    size_t i = task / t->cols * t->o.tm, j = task % t->cols * t->o.tn;
+    size_t m = min_sz(t->o.tm, t->c->rows - i), n = min_sz(t->o.tn, t->c->cols - j), kk = t->a->cols;
+    Matrix cv = mat_view(t->c, i, j, m, n);
+    Matrix av = mat_view(t->a, i, 0, m, kk);
+    Matrix bv = mat_view(t->b, 0, j, kk, n);
+    if (gemm_run(t->kind, &t->o, &cv, &av, &bv, &t->work[worker])) atomic_store(&t->failed, 1);
+}
+
+int gemm_parallel(GemmKind k, const GemmOptions* o, WorkPool* pool, Matrix* c, const Matrix* a, const Matrix* b) {
+    if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols || !gemm_available(k)) return -1;
+    Tiles t;
+    tiles_init(&t, k, o, c, (Matrix*)a, b);
+    // буфери пакування: виділяє й уперше пише той потік, що ними користується
+    t.work = calloc(pool_size(pool), sizeof(GemmWork));
+    if (!t.work) return -1;
+    pool_run(pool, t.rows * t.cols, tile_gemm, &t);
+    for (unsigned w = 0; w < pool_size(pool); w++) gemm_work_free(&t.work[w]);
+    free(t.work);
+    return atomic_load(&t.failed) ? -1 : 0;
+}
+
+static void tile_touch(void* arg, size_t task, unsigned worker) {
+    Tiles* t = arg;
+    size_t ti = task / t->cols, i = ti * t->o.tm, j = task % t->cols * t->o.tn;
+    size_t m = min_sz(t->o.tm, t->c->rows - i), n = min_sz(t->o.tn, t->c->cols - j);
+    for (size_t r = 0; r < m; r++) memset(&MAT(t->c, i + r, j), 0, n * sizeof(double));
+    // смуга рядків A — тому, хто рахує першу плитку цієї смуги
+    if (task % t->cols == 0 && t->a)
+        for (size_t r = 0; r < m; r++) memset(&MAT(t->a, i + r, 0), 0, t->a->cols * sizeof(double));
+}
+
+void gemm_first_touch(const GemmOptions* o, WorkPool* pool, Matrix* c, Matrix* a) {
+    Tiles t;
+    tiles_init(&t, GEMM_AVX2, o, c, a, NULL);
+    pool_run(pool, t.rows * t.cols, tile_touch, &t);
+}
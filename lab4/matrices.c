@@ -0,0 +1,35 @@
+#include "matrices.h"
+#include <string.h>
+
+int init_matrices(Matrices* p, size_t m, size_t n, size_t k, size_t align, unsigned flags,
+                  const GemmOptions* o, struct WorkPool* pool) {
+    memset(p, 0, sizeof *p);
+    if (mat_alloc_ex(&p->a, m, k, align, flags) || mat_alloc_ex(&p->b, k, n, align, flags) ||
+        mat_alloc_ex(&p->c, m, n, align, flags)) {
+        free_matrices(p);
+        return -1;
+    }
+    if (pool) gemm_first_touch(o, pool, &p->c, &p->a);
+    size_t i, j;
+    for (i = 0; i < m; i++)
+        for (j = 0; j < k; j++) MAT(&p->a, i, j) = (double)i * (double)j;
+    for (i = 0; i < k; i++)
+        for (j = 0; j < n; j++) MAT(&p->b, i, j) = (double)i / ((double)j + 1.0);
+    return 0;
+}
+
+int matrix_multiply(Matrices* p, GemmKind kind, const GemmOptions* o, struct WorkPool* pool) {
+    return pool ? gemm_parallel(kind, o, pool, &p->c, &p->a, &p->b) : gemm(kind, o, &p->c, &p->a, &p->b);
+}
+
+void clear_product(Matrices* p) {
+    for (size_t i = 0; i < p->c.rows; i++) memset(&MAT(&p->c, i, 0), 0, p->c.cols * sizeof(double));
+}
+
+double matrix_flops(const Matrices* p) { return 2.0 * (double)p->c.rows * (double)p->c.cols * (double)p->a.cols; }
+
+void free_matrices(Matrices* p) {
+    mat_free(&p->a);
+    mat_free(&p->b);
+    mat_free(&p->c);
+}
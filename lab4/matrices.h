@@ -0,0 +1,27 @@
+#ifndef MATRICES_H
+#define MATRICES_H
+#include "gemm.h"
+
+/*
+ * Задача програми: C = A * B, A — m x k, B — k x n, A[i][j] = i * j,
+ * B[i][j] = i / (j + 1), як у вихідному matrix.c. Спільна для matrix і bench,
+ * тож обидві вимірюють ті самі init_matrices і matrix_multiply.
+ */
+typedef struct {
+    Matrix a, b, c;
+} Matrices;
+
+struct WorkPool;
+
+/* flags — MAT_*; pool — розкласти сторінки A і C за потоками, що їх рахуватимуть (first touch) */
+int init_matrices(Matrices* p, size_t m, size_t n, size_t k, size_t align, unsigned flags,
+                  const GemmOptions* o, struct WorkPool* pool);
+/* C += A * B стратегією kind; pool — gemm_parallel, NULL — gemm */
+int matrix_multiply(Matrices* p, GemmKind kind, const GemmOptions* o, struct WorkPool* pool);
+/* C = 0 перед новим прогоном */
+void clear_product(Matrices* p);
+/* 2 * m * n * k — операцій з плаваючою комою в одному множенні */
+double matrix_flops(const Matrices* p);
+void free_matrices(Matrices* p);
+
+#endif
@@ -1,42 +1,125 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
-#define SIZE 800 
-
-static double a[SIZE][SIZE];
-static double b[SIZE][SIZE];
-static double c[SIZE][SIZE];
-
-void matrix_multiply() {
-    int i, j, k;
-    for (i = 0; i < SIZE; i++) {
-        for (j = 0; j < SIZE; j++) {
-            // c[i][j] = 0; 
-            for (k = 0; k < SIZE; k++) {
-                c[i][j] += a[i][k] * b[k][j];
-            }
-        }
-    }
+#include <string.h>
+#include <time.h>
+#include "matrices.h"
+#include "work_pool.h"
+
+/*
+ * Множення матриць C = A * B (A — m x k, B — k x n) однією зі стратегій gemm.h.
+ *   ./matrix [--size=N|MxNxK] [--kernel=naive|ikj|transposed|blocked|avx2|all]
+ *            [--tile=MC,KC,NC] [--align=BYTES] [--check]
+ *            [--threads=N] [--ptile=TM,TN] [--huge] [--no-pin]
+ * Типово — 800 x 800 і naive в одному потоці, як у вихідній версії (README).
+ * --check звіряє результат із naive; --kernel=all проганяє всі доступні
+ * стратегії по черзі. --threads=N (0 — усі ядра) рахує плитки C TM x TN на
+ * пулі з крадіжкою роботи (gemm_parallel); матриці тоді виділяються mmap без
+ * запису, і кожен потік уперше торкається своїх плиток (gemm_first_touch).
+ * --huge — те саме на великих сторінках; --no-pin — не прив'язувати потоки до ядер.
+ */
+
+static Matrices mx;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
 
+/* Один прогін: c = A * B стратегією kind; -1 — стратегія відмовила */
+static int run(GemmKind kind, const GemmOptions* o, WorkPool* pool, const Matrix* ref) {
+    clear_product(&mx);
+    unsigned long long steals = pool ? pool_steals(pool) : 0;
+    double t0 = now_s();
+    if (matrix_multiply(&mx, kind, o, pool)) {
+        fprintf(stderr, "%s: failed\n", gemm_name(kind));
+        return -1;
+    }
+    double t = now_s() - t0;
+    double flops = matrix_flops(&mx);
+    printf("%-10s %10.3f ms %8.2f GFLOP/s", gemm_name(kind), t * 1e3, t > 0 ? flops / t * 1e-9 : 0.0);
+    if (pool) printf("  threads %u, steals %llu", pool_size(pool), pool_steals(pool) - steals);
+    int rc = 0;
+    if (ref) {
+        double rel;
+        size_t bad = gemm_check(&mx.c, ref, &mx.a, &mx.b, &rel);
+        printf("  check: %s (max err %.3g of bound)", bad ? "FAILED" : "ok", rel);
+        if (bad) rc = -1;
+    }
+    printf("\n");
+    return rc;
+}
 
-void init_matrices() {
-    int i, j;
-    for (i = 0; i < SIZE; i++) {
-        for (j = 0; j < SIZE; j++) {
-            a[i][j] = (double)i * (double)j;
-            b[i][j] = (double)i / ((double)j + 1.0);
-            c[i][j] = 0.0;
+int main(int argc, char** argv) {
+    size_t m = 800, n = 800, k = 800, align = 64;
+    GemmKind kind = GEMM_NAIVE;
+    int all = 0, check = 0, huge = 0, pin = 1;
+    long threads = 1;
+    GemmOptions o = {0};
+    for (int i = 1; i < argc; i++) {
+        const char* s = argv[i];
+        if (strncmp(s, "--size=", 7) == 0) {
+            char* e;
+            m = n = k = strtoull(s + 7, &e, 10);
+            if (*e == 'x') {
+                n = strtoull(e + 1, &e, 10);
+                if (*e == 'x') k = strtoull(e + 1, &e, 10);
+            }
+            if (*e || !m || !n || !k) { fprintf(stderr, "Invalid --size: %s\n", s + 7); return 1; }
+        } else if (strcmp(s, "--kernel=all") == 0) {
+            all = 1;
+        } else if (strncmp(s, "--kernel=", 9) == 0) {
+            if (gemm_parse(s + 9, &kind)) { fprintf(stderr, "Unknown kernel: %s\n", s + 9); return 1; }
+        } else if (strncmp(s, "--tile=", 7) == 0) {
+            if (sscanf(s + 7, "%zu,%zu,%zu", &o.mc, &o.kc, &o.nc) != 3) { fprintf(stderr, "Invalid --tile: %s\n", s + 7); return 1; }
+        } else if (strncmp(s, "--ptile=", 8) == 0) {
+            if (sscanf(s + 8, "%zu,%zu", &o.tm, &o.tn) != 2) { fprintf(stderr, "Invalid --ptile: %s\n", s + 8); return 1; }
+        } else if (strncmp(s, "--threads=", 10) == 0) {
+            char* e;
+            threads = strtol(s + 10, &e, 10);
+            if (*e || threads < 0) { fprintf(stderr, "Invalid --threads: %s\n", s + 10); return 1; }
+        } else if (strcmp(s, "--huge") == 0) {
+            huge = 1;
+        } else if (strcmp(s, "--no-pin") == 0) {
+            pin = 0;
+        } else if (strncmp(s, "--align=", 8) == 0) {
+            align = strtoull(s + 8, NULL, 10);
+        } else if (strcmp(s, "--check") == 0) {
+            check = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--size=N|MxNxK] [--kernel=naive|ikj|transposed|blocked|avx2|all] [--tile=MC,KC,NC] [--align=BYTES] [--check] [--threads=N] [--ptile=TM,TN] [--huge] [--no-pin]\n", argv[0]);
+            return 1;
         }
     }
-}
+    if (!all && !gemm_available(kind)) { fprintf(stderr, "%s is not supported on this CPU\n", gemm_name(kind)); return 1; }
+
+    WorkPool* pool = NULL;
+    if (threads != 1 && !(pool = pool_create((unsigned)threads, pin))) { fprintf(stderr, "Cannot start %ld threads\n", threads); return 1; }
 
-int main() {
     printf("Starting initialization...\n");
-    init_matrices();
-    
+    unsigned flags = (pool ? MAT_LAZY : 0) | (huge ? MAT_HUGE : 0);
+    if (init_matrices(&mx, m, n, k, align, flags, &o, pool)) { fprintf(stderr, "Cannot allocate %zux%zux%zu (align %zu)\n", m, n, k, align); return 1; }
+    if (huge) printf("Huge pages: %s\n", mx.c.huge == 2 ? "hugetlbfs" : mx.c.huge ? "transparent (madvise)" : "unavailable");
+
+    // еталон для --check — naive на тих самих даних
+    Matrix ref = {0};
+    if (check) {
+        if (mat_alloc(&ref, m, n, 64) || matrix_multiply(&mx, GEMM_NAIVE, NULL, NULL)) { fprintf(stderr, "Cannot compute reference\n"); return 1; }
+        for (size_t i = 0; i < m; i++) memcpy(&MAT(&ref, i, 0), &MAT(&mx.c, i, 0), n * sizeof(double));
+    }
+
     printf("Starting multiplication...\n");
-    matrix_multiply(); 
-    
-    printf("Finished. C[100][100] = %f\n", c[100][100]);
-    return 0;
+    int rc = 0;
+    for (int kd = all ? 0 : kind; kd <= (all ? GEMM_KINDS - 1 : (int)kind); kd++) {
+        if (!gemm_available((GemmKind)kd)) { printf("%-10s not supported on this CPU\n", gemm_name((GemmKind)kd)); continue; }
+        if (run((GemmKind)kd, &o, pool, check ? &ref : NULL)) rc = 1;
+    }
+
+    size_t pi = m > 100 ? 100 : m - 1, pj = n > 100 ? 100 : n - 1;
+    printf("Finished. C[%zu][%zu] = %f\n", pi, pj, MAT(&mx.c, pi, pj));
+    mat_free(&ref);
+    free_matrices(&mx);
+    pool_destroy(pool);
+    return rc;
 }
@@ -0,0 +1,81 @@
+#!/bin/sh
+# Таблиці до/після з фаз 1–2 одним запуском — bench замість perf stat -d,
+# /usr/bin/time, perf stat -e power/energy-pkg/ і скріншотів: bench_O0
+# (gcc -O0, «неоптимізована версія») проти bench (-O3 -march=native).
+#   ./report.sh [SIZES] [REPS]          (типово 800 і 5; SIZES — як --sizes у bench)
+# Змінні: KERNELS — стратегії збірки -O3 (типово naive,blocked,avx2; -O0 — лише naive),
+# THREADS, WARMUP (типово 1), OUT — CSV усіх вимірів (типово results.csv).
+# У stdout — markdown: для кожного розміру метрики по стовпцях «збірка стратегія»,
+# у дужках — зміна відносно першого стовпця (-O0 naive, вихідна програма).
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+SIZES=${1:-800}
+REPS=${2:-5}
+KERNELS=${KERNELS:-naive,blocked,avx2}
+OUT=${OUT:-results.csv}
+ARGS="--sizes=$SIZES --reps=$REPS --warmup=${WARMUP:-1} --threads=${THREADS:-1}"
+
+"$HERE/bench_O0" --label=-O0 --kernels=naive $ARGS > "$OUT" || exit 1
+"$HERE/bench" --label=-O3 --kernels="$KERNELS" $ARGS > "$OUT.O3" || { rm -f "$OUT.O3"; exit 1; }
+tail -n +2 "$OUT.O3" >> "$OUT" && rm -f "$OUT.O3"
+echo "CSV: $OUT" >&2
+
+awk -F, '
+NR == 1 { for (i = 1; i <= NF; i++) col[$i] = i; next }
+function get(r, name,   v) { v = row[r, col[name]]; return v }
+function num(r, name) { return get(r, name) == "" ? "" : get(r, name) + 0 }
+# значення метрики name для рядка r; "" — недоступна
+function value(r, name,   t, j) {
+    if (name == "init_ms") return init[get(r, "label"), get(r, "size")]
+    if (name == "watts") {
+        t = num(r, "time_ms_median"); j = num(r, "joules_median")
+        return t == "" || j == "" || t <= 0 ? "" : j / (t / 1000)
+    }
+    return num(r, name)
+}
+function fmt(v, name) {
+    if (v == "") return "n/a"
+    if (name ~ /^(cycles|instructions)/) return sprintf("%.3f млрд", v / 1e9)
+    if (name ~ /pct/) return sprintf("%.2f%%", v)
+    if (name ~ /^(gflops|ipc|joules|watts)/) return sprintf("%.2f", v)
+    return sprintf("%.3f", v)
+}
+function change(v, base) {
+    if (v == "" || base == "" || base == 0) return ""
+    return sprintf(" (%+.1f%%)", (v / base - 1) * 100)
+}
+$1 == "label" { next }
+{
+    n++
+    for (i = 1; i <= NF; i++) row[n, i] = $i
+    if ($2 == "init") { init[$1, $4] = $(col["time_ms_median"]); next }
+    s = $4
+    if (!(s in cols)) sizes[++ns] = s
+    list[s, ++cols[s]] = n
+}
+END {
+    m = split("time_ms_median:Час, мс (медіана)|time_ms_stddev:Час, мс (σ)|time_ms_min:Час, мс (мін.)|" \
+              "gflops_median:GFLOP/s|cycles_median:Cycles|instructions_median:Instructions|ipc_median:IPC|" \
+              "l1d_miss_pct_median:L1-dcache-load-misses|llc_miss_pct_median:LLC-load-misses|" \
+              "branch_miss_pct_median:branch-misses|joules_median:Енергія, Дж|watts:Сер. потужність, Вт|" \
+              "init_ms:init_matrices, мс (медіана)", metric, "|")
+    for (z = 1; z <= ns; z++) {
+        s = sizes[z]; c = cols[s]
+        printf "%s### %s, потоків: %s, повторів: %s\n\n", (z > 1 ? "\n" : ""), s, get(list[s, 1], "threads"), get(list[s, 1], "reps")
+        printf "| Метрика |"
+        for (j = 1; j <= c; j++) printf " `%s` %s |", get(list[s, j], "label"), get(list[s, j], "kernel")
+        printf "\n| :--- |"
+        for (j = 1; j <= c; j++) printf " ---: |"
+        printf "\n"
+        for (x = 1; x <= m; x++) {
+            split(metric[x], kv, ":")
+            printf "| **%s** |", kv[2]
+            base = value(list[s, 1], kv[1])
+            for (j = 1; j <= c; j++) {
+                v = value(list[s, j], kv[1])
+                printf " %s%s |", fmt(v, kv[1]), (j > 1 && kv[1] !~ /stddev/ ? change(v, base) : "")
+            }
+            printf "\n"
+        }
+    }
+}' "$OUT"
@@ -0,0 +1,50 @@
+#!/bin/sh
+# Масштабування gemm_parallel: GFLOP/s залежно від кількості потоків для
+# кількох розмірів; CSV у stdout, підсумок — у stderr.
+#   ./scaling.sh [SIZES] [MAX_THREADS]     (типово "512 1024 2048" і nproc)
+# Змінні: KERNEL (типово avx2), RUNS (найкращий із RUNS запусків, типово 3),
+# ARGS (додаткові аргументи ./matrix, напр. "--huge" чи "--ptile=96,512").
+# Потоки: 1, 2, 4, ... і сам MAX_THREADS; 1 — послідовний gemm без пулу.
+# efficiency = speedup / threads; підсумок називає першу кількість потоків,
+# на якій efficiency падає нижче 70%, — звідти додавання ядер мало що дає.
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+BIN=${MATRIX:-$HERE/matrix}
+KERNEL=${KERNEL:-avx2}
+RUNS=${RUNS:-3}
+SIZES=${1:-512 1024 2048}
+MAX=${2:-$(nproc)}
+
+[ -x "$BIN" ] || { echo "build first: make -C $HERE" >&2; exit 2; }
+
+counts=""
+t=1
+while [ "$t" -lt "$MAX" ]; do counts="$counts $t"; t=$((t * 2)); done
+counts="$counts $MAX"
+
+# найкращий час (мс) і GFLOP/s з RUNS запусків
+measure() {
+    for r in $(seq "$RUNS"); do
+        "$BIN" --kernel="$KERNEL" --size="$1" --threads="$2" $ARGS | awk -v k="$KERNEL" '$1 == k { print $2, $4 }'
+    done | sort -n | head -1
+}
+
+echo "kernel,size,threads,ms,gflops,speedup,efficiency"
+for n in $SIZES; do
+    base=""
+    stop=""
+    for t in $counts; do
+        set -- $(measure "$n" "$t")
+        [ $# -eq 2 ] || { echo "$KERNEL $n x $t: no result" >&2; exit 1; }
+        [ -z "$base" ] && base=$1
+        line=$(awk -v b="$base" -v ms="$1" -v t="$t" 'BEGIN { s = b / ms; printf "%.2f,%.2f", s, s / t }')
+        echo "$KERNEL,$n,$t,$1,$2,$line"
+        eff=${line#*,}
+        if [ -z "$stop" ] && awk -v e="$eff" 'BEGIN { exit !(e < 0.7) }'; then stop=$t; fi
+    done
+    if [ -n "$stop" ]; then
+        echo "$n: efficiency below 70% from $stop threads" >&2
+    else
+        echo "$n: efficiency >= 70% up to $MAX threads" >&2
+    fi
+done
@@ -0,0 +1,201 @@
+#define _GNU_SOURCE
+#include "work_pool.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Відрізок задач потоку під власним м'ютексом; рядок кешу на чергу */
+typedef struct {
+    _Alignas(64) pthread_mutex_t m;
+    size_t lo, hi;
+} Queue;
+
+typedef struct {
+    WorkPool* pool;
+    unsigned self;
+} Worker;
+
+struct WorkPool {
+    unsigned n;
+    Queue* queues;
+    pthread_t* threads;
+    Worker* workers;
+    pthread_mutex_t m;
+    pthread_cond_t wake, idle;
+    WorkFn fn;
+    void* arg;
+    unsigned long long generation;
+    unsigned busy;
+    int stop;
+    unsigned long long steals; /* під m */
+};
+
+/* Наступна задача: спершу своя черга, потім половина чужого залишку */
+static int next(WorkPool* p, unsigned self, size_t* task, unsigned long long* stolen) {
+    Queue* q = &p->queues[self];
+    pthread_mutex_lock(&q->m);
+    if (q->lo < q->hi) {
+        *task = q->lo++;
+        pthread_mutex_unlock(&q->m);
+        return 1;
+    }
+    pthread_mutex_unlock(&q->m);
+    for (unsigned k = 1; k < p->n; k++) {
+        Queue* v = &p->queues[(self + k) % p->n];
+        pthread_mutex_lock(&v->m);
+        if (v->lo >= v->hi) {
+            pthread_mutex_unlock(&v->m);
+            continue;
+        }
+        size_t hi = v->hi, lo = v->lo + (v->hi - v->lo) / 2;
+        v->hi = lo;
+        pthread_mutex_unlock(&v->m);
+        (*stolen)++;
+        *task = lo;
+        if (lo + 1 < hi) {
+            pthread_mutex_lock(&q->m);
+            q->lo = lo + 1;
+            q->hi = hi;
+            pthread_mutex_unlock(&q->m);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static void work(WorkPool* p, unsigned self) {
+    size_t task;
+    unsigned long long stolen = 0;
+    while (next(p, self, &task, &stolen)) p->fn(p->arg, task, self);
+    if (stolen) {
+        pthread_mutex_lock(&p->m);
+        p->steals += stolen;
+        pthread_mutex_unlock(&p->m);
+    }
+}
+
+static void* loop(void* arg) {
+    Worker* w = arg;
+    WorkPool* p = w->pool;
+    unsigned long long seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&p->m);
+        while (!p->stop && p->generation == seen) pthread_cond_wait(&p->wake, &p->m);
+        if (p->stop) {
+            pthread_mutex_unlock(&p->m);
+            return NULL;
+        }
+        seen = p->generation;
+        pthread_mutex_unlock(&p->m);
+        work(p, w->self);
+        pthread_mutex_lock(&p->m);
+        if (--p->busy == 0) pthread_cond_signal(&p->idle);
+        pthread_mutex_unlock(&p->m);
+    }
+}
+
+/* k-й CPU з дозволених процесу (sched_getaffinity), по колу; -1 — невідомо */
+static int nth_cpu(unsigned k) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof set, &set)) return -1;
+    int count = CPU_COUNT(&set);
+    if (count <= 0) return -1;
+    unsigned want = k % (unsigned)count;
+    for (int c = 0; c < CPU_SETSIZE; c++)
+        if (CPU_ISSET(c, &set) && want-- == 0) return c;
+    return -1;
+}
+
+static void pin_to(pthread_t t, unsigned k) {
+    int c = nth_cpu(k);
+    if (c < 0) return;
+    cpu_set_t one;
+    CPU_ZERO(&one);
+    CPU_SET(c, &one);
+    pthread_setaffinity_np(t, sizeof one, &one); // не вдалося — потік просто не прив'язаний
+}
+
+WorkPool* pool_create(unsigned threads, int pin) {
+    if (threads == 0) {
+        cpu_set_t set;
+        threads = sched_getaffinity(0, sizeof set, &set) == 0 ? (unsigned)CPU_COUNT(&set) : (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+        if (threads == 0) threads = 1;
+    }
+    WorkPool* p = calloc(1, sizeof *p);
+    if (!p) return NULL;
+    p->n = threads;
+    p->queues = aligned_alloc(64, threads * sizeof(Queue));
+    p->threads = calloc(threads, sizeof(pthread_t));
+    p->workers = calloc(threads, sizeof(Worker));
+    if (!p->queues || !p->threads || !p->workers) {
+        free(p->queues);
+        free(p->threads);
+        free(p->workers);
+        free(p);
+        return NULL;
+    }
+    for (unsigned k = 0; k < threads; k++) {
+        pthread_mutex_init(&p->queues[k].m, NULL);
+        p->queues[k].lo = p->queues[k].hi = 0;
+        p->workers[k].pool = p;
+        p->workers[k].self = k;
+    }
+    pthread_mutex_init(&p->m, NULL);
+    pthread_cond_init(&p->wake, NULL);
+    pthread_cond_init(&p->idle, NULL);
+    if (pin) pin_to(pthread_self(), 0);
+    p->threads[0] = pthread_self();
+    for (unsigned k = 1; k < threads; k++) {
+        if (pthread_create(&p->threads[k], NULL, loop, &p->workers[k])) {
+            p->n = k; // скільки вдалося створити
+            break;
+        }
+        if (pin) pin_to(p->threads[k], k);
+    }
+    return p;
+}
+
+void pool_destroy(WorkPool* p) {
+    if (!p) return;
+    pthread_mutex_lock(&p->m);
+    p->stop = 1;
+    pthread_cond_broadcast(&p->wake);
+    pthread_mutex_unlock(&p->m);
+    for (unsigned k = 1; k < p->n; k++) pthread_join(p->threads[k], NULL);
+    for (unsigned k = 0; k < p->n; k++) pthread_mutex_destroy(&p->queues[k].m);
+    pthread_mutex_destroy(&p->m);
+    pthread_cond_destroy(&p->wake);
+    pthread_cond_destroy(&p->idle);
+    free(p->queues);
+    free(p->threads);
+    free(p->workers);
+    free(p);
+}
+
+unsigned pool_size(const WorkPool* p) { return p->n; }
+
+unsigned long long pool_steals(const WorkPool* p) { return p->steals; }
+
+void pool_run(WorkPool* p, size_t tasks, WorkFn fn, void* arg) {
+    if (tasks == 0) return;
+    unsigned n = p->n;
+    for (unsigned k = 0; k < n; k++) {
+        pthread_mutex_lock(&p->queues[k].m);
+        p->queues[k].lo = tasks * k / n;
+        p->queues[k].hi = tasks * (k + 1) / n;
+        pthread_mutex_unlock(&p->queues[k].m);
+    }
+    pthread_mutex_lock(&p->m);
+    p->fn = fn;
+    p->arg = arg;
+    p->busy = n - 1;
+    p->generation++;
+    pthread_cond_broadcast(&p->wake);
+    pthread_mutex_unlock(&p->m);
+    work(p, 0);
+    pthread_mutex_lock(&p->m);
+    while (p->busy) pthread_cond_wait(&p->idle, &p->m);
+    p->fn = NULL;
+    pthread_mutex_unlock(&p->m);
+}
@@ -0,0 +1,26 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+#include <stddef.h>
+
+/*
+ * Пул потоків із крадіжкою роботи (та сама схема, що й WorkPool у lab3).
+ * Робота — номери задач [0, tasks). Потік k починає з суцільного відрізка
+ * [tasks*k/n, tasks*(k+1)/n) і бере задачі з його початку; звільнившись,
+ * забирає в іншого потоку верхню половину залишку. Без крадіжок розподіл
+ * задач за потоками однаковий у кожному pool_run з тим самим tasks — на цьому
+ * тримається first touch (gemm_first_touch розкладає сторінки так само, як
+ * потім рахує gemm_parallel). Викликач pool_run працює як потік 0.
+ */
+typedef struct WorkPool WorkPool;
+typedef void (*WorkFn)(void* arg, size_t task, unsigned worker);
+
+/* threads == 0 — усі доступні ядра; pin — прив'язати потік k до k-го дозволеного CPU */
+WorkPool* pool_create(unsigned threads, int pin);
+void pool_destroy(WorkPool* p);
+unsigned pool_size(const WorkPool* p);
+/* fn(arg, task, worker) для кожної задачі; повертається, коли виконано всі */
+void pool_run(WorkPool* p, size_t tasks, WorkFn fn, void* arg);
+/* скільки разів потоки забирали роботу в інших від створення пулу */
+unsigned long long pool_steals(const WorkPool* p);
+
+#endif